@@ -17,6 +17,7 @@
 #define THRILL_EXAMPLES_WORD_COUNT_WORD_COUNT_HEADER
 
 #include <thrill/api/reduce_by_key.hpp>
+#include <thrill/common/hash.hpp>
 #include <tlx/string/split_view.hpp>
 
 #include <string>
@@ -45,14 +46,16 @@ auto WordCount(const DIA<std::string, InputStack>& input) {
         });
 
     return word_pairs.ReduceByKey(
-        [](const WordCountPair& in) -> std::string {
-            /* reduction key: the word string */
-            return in.first;
+        [](const WordCountPair& in) -> tlx::string_view {
+            /* reduction key: a view of the word string, which avoids copying
+             * the string each time the key is extracted */
+            return tlx::string_view(in.first.data(), in.first.size());
         },
         [](const WordCountPair& a, const WordCountPair& b) -> WordCountPair {
             /* associative reduction operator: add counters */
             return WordCountPair(a.first, a.second + b.second);
-        });
+        },
+        api::DefaultReduceConfig(), common::HashCrc32<tlx::string_view>());
 }
 
 /******************************************************************************/
@@ -806,6 +806,33 @@ TEST(Operations, FilterResultsCorrectly) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, CachedMapFilterSumInBatches) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            static constexpr size_t n = 100000;
+
+            // cached DIAs push their File's Blocks, hence use batch callbacks
+            auto integers = Generate(
+                ctx, n,
+                [](const size_t& index) {
+                    return index + 1;
+                }).Cache();
+
+            ASSERT_EQ(n * (n + 1) / 2, integers.Keep().Sum());
+
+            auto odd_tripled =
+                integers.Keep()
+                .Filter([](size_t in) { return in % 2 == 1; })
+                .Map([](size_t in) { return 3 * in; });
+
+            ASSERT_EQ(3 * (n / 2) * (n / 2), odd_tripled.Sum());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, DIACasting) {
 
     auto start_func =
@@ -11,26 +11,34 @@
 
 #include <gtest/gtest.h>
 #include <thrill/api/all_gather.hpp>
+#include <thrill/api/filter.hpp>
 #include <thrill/api/generate.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
 #include <thrill/api/size.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_one.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/system_exception.hpp>
 #include <thrill/vfs/file_io.hpp>
+#include <thrill/vfs/gzip_filter.hpp>
+#include <thrill/vfs/sys_file.hpp>
 #include <thrill/vfs/temporary_directory.hpp>
 
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <fstream>
 #include <functional>
+#include <limits>
 #include <random>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -162,6 +170,100 @@ TEST(IO, GenerateIntegerWriteReadBinary) {
         });
 }
 
+TEST(IO, GenerateWriteReadColumnar) {
+    vfs::TemporaryDirectory tmpdir;
+
+    using Row = std::tuple<uint32_t, double, uint64_t>;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // wipe directory from last test
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+            }
+            ctx.net.Barrier();
+
+            // generate rows with a sorted "day" column and write them
+            size_t generate_size = 32000;
+            {
+                auto dia = Generate(
+                    ctx, generate_size,
+                    [](const size_t index) {
+                        return Row(index / 1000, index * 0.5, index * index);
+                    });
+
+                dia.WriteColumnar(tmpdir.get() + "/Columnar", 1000);
+            }
+            ctx.net.Barrier();
+
+            // read all columns (collectively) and compare
+            {
+                auto dia = api::ReadColumnar<Row>(
+                    ctx, tmpdir.get() + "/Columnar*");
+
+                std::vector<Row> vec = dia.AllGather();
+
+                ASSERT_EQ(generate_size, vec.size());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    ASSERT_EQ(Row(i / 1000, i * 0.5, i * i), vec[i]);
+                }
+            }
+
+            // read two columns of the row groups which may contain days 20-22
+            {
+                auto dia = api::ReadColumnar<Row>(
+                    ctx, tmpdir.get() + "/Columnar*", ColumnSelect<2, 0>(),
+                    [](const data::ColumnarStats<Row>& stats) {
+                        return stats.max<0>() >= 20 && stats.min<0>() <= 22;
+                    });
+
+                // fewer rows than written were read
+                ASSERT_LT(dia.Size(), generate_size);
+
+                using Selected = std::tuple<uint64_t, uint32_t>;
+                std::vector<Selected> vec =
+                    dia.Filter([](const Selected& s) {
+                                   return std::get<1>(s) >= 20 &&
+                                   std::get<1>(s) <= 22;
+                               }).AllGather();
+
+                ASSERT_EQ(3000u, vec.size());
+                for (size_t i = 0; i < vec.size(); ++i) {
+                    uint64_t index = 20000 + i;
+                    ASSERT_EQ(Selected(index * index, index / 1000), vec[i]);
+                }
+            }
+        });
+}
+
+TEST(IO, ColumnarStatsExcludeNaN) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<double> values { nan, 3.0, 1.0, nan, 2.0 };
+    data::ColumnarRowGroup rg;
+    rg.num_rows = values.size();
+    rg.chunks.resize(1);
+    data::ColumnChunkBuilder bb;
+    data::EncodeColumnChunk(values, 4096, bb, rg.chunks[0]);
+
+    data::ColumnarStats<std::tuple<double> > stats(rg);
+    ASSERT_EQ(1.0, stats.min<0>());
+    ASSERT_EQ(3.0, stats.max<0>());
+
+    // a chunk of only NaNs has NaN statistics, which match no comparison.
+    std::vector<double> nans { nan, nan };
+    data::ColumnarRowGroup rg_nan;
+    rg_nan.num_rows = nans.size();
+    rg_nan.chunks.resize(1);
+    data::ColumnChunkBuilder bb_nan;
+    data::EncodeColumnChunk(nans, 4096, bb_nan, rg_nan.chunks[0]);
+
+    data::ColumnarStats<std::tuple<double> > stats_nan(rg_nan);
+    ASSERT_TRUE(std::isnan(stats_nan.min<0>()));
+    ASSERT_TRUE(std::isnan(stats_nan.max<0>()));
+}
+
 #if THRILL_HAVE_ZLIB
 
 TEST(IO, GenerateIntegerWriteReadBinaryCompressed) {
@@ -211,6 +313,52 @@ TEST(IO, GenerateIntegerWriteReadBinaryCompressed) {
         });
 }
 
+TEST(IO, ReadLinesSplittableCompressed) {
+#if defined(_MSC_VER)
+    return;
+#endif
+
+    vfs::TemporaryDirectory tmpdir;
+
+    api::RunLocalTests(
+        [&tmpdir](api::Context& ctx) {
+
+            // write a block compressed and an uncompressed file of lines
+            size_t lines = 100000;
+            if (ctx.my_rank() == 0) {
+                tmpdir.wipe();
+
+                vfs::WriteStreamPtr zs = vfs::MakeGZipBlockWriteFilter(
+                    vfs::SysOpenWriteStream(tmpdir.get() + "/lines0.gz"));
+                for (size_t i = 0; i < lines; ++i) {
+                    std::string line = std::to_string(i) + "\n";
+                    zs->write(line.data(), line.size());
+                }
+                zs->close();
+
+                vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(
+                    tmpdir.get() + "/lines1");
+                for (size_t i = lines; i < 2 * lines; ++i) {
+                    std::string line = std::to_string(i) + "\n";
+                    ws->write(line.data(), line.size());
+                }
+                ws->close();
+            }
+            ctx.net.Barrier();
+
+            ASSERT_TRUE(
+                vfs::IsSplittableCompressed(tmpdir.get() + "/lines0.gz"));
+
+            std::vector<std::string> vec =
+                ReadLines(ctx, tmpdir.get() + "/lines*").AllGather();
+
+            ASSERT_EQ(2 * lines, vec.size());
+            for (size_t i = 0; i < vec.size(); ++i) {
+                ASSERT_EQ(std::to_string(i), vec[i]);
+            }
+        });
+}
+
 #endif // THRILL_HAVE_ZLIB
 
 // make weird test strings of different lengths
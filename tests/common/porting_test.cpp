@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * tests/common/porting_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/porting.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+//! parse a topology from files given as a map of names to contents
+static common::NumaTopology ParseTopology(
+    const std::map<std::string, std::string>& files, size_t num_cpus) {
+    return common::NumaTopology::Parse(
+        [&files](const std::string& name, std::string& content) {
+            auto it = files.find(name);
+            if (it == files.end()) return false;
+            content = it->second;
+            return true;
+        },
+        num_cpus);
+}
+
+TEST(NumaTopology, ParseNodesWithHoles) {
+    // node 1 is offline, node 2 lists its cpus in two ranges.
+    common::NumaTopology t = ParseTopology(
+        {
+            { "online", "0,2\n" },
+            { "node0/cpulist", "0-3" },
+            { "node2/cpulist", "4-5,6-7\n" }
+        }, 8);
+
+    ASSERT_EQ(3u, t.num_nodes);
+    ASSERT_EQ(std::vector<size_t>({ 0, 0, 0, 0, 2, 2, 2, 2 }), t.cpu_node);
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4, 5, 6, 7 }), t.cpus_by_node);
+
+    // workers are spread across both nodes.
+    std::vector<size_t> cpus;
+    for (size_t w = 0; w < 4; ++w)
+        cpus.push_back(t.WorkerCpu(w, 4, 0));
+    ASSERT_EQ(std::vector<size_t>({ 0, 2, 4, 6 }), cpus);
+
+    // without the last two cpus reserved for dispatchers.
+    cpus.clear();
+    for (size_t w = 0; w < 6; ++w)
+        cpus.push_back(t.WorkerCpu(w, 6, 2));
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4, 5 }), cpus);
+
+    // a worker on each cpu: all cpus of both nodes are used.
+    cpus.clear();
+    for (size_t w = 0; w < 8; ++w)
+        cpus.push_back(t.WorkerCpu(w, 8, 1));
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4, 5, 6, 7 }), cpus);
+}
+
+TEST(NumaTopology, NoNumaFallback) {
+    // no /sys/devices/system/node: all cpus are on node 0.
+    common::NumaTopology t = ParseTopology({ }, 4);
+
+    ASSERT_EQ(1u, t.num_nodes);
+    ASSERT_EQ(std::vector<size_t>({ 0, 0, 0, 0 }), t.cpu_node);
+    ASSERT_TRUE(t.cpus_by_node.empty());
+
+    // workers are pinned in order, skipping the dispatcher's cpu.
+    ASSERT_EQ(0u, t.WorkerCpu(0, 3, 1));
+    ASSERT_EQ(2u, t.WorkerCpu(2, 3, 1));
+
+    // a worker on each cpu: the dispatcher's cpu is shared, not a worker's.
+    std::vector<size_t> cpus;
+    for (size_t w = 0; w < 4; ++w)
+        cpus.push_back(t.WorkerCpu(w, 4, 1));
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3 }), cpus);
+
+    // all cpus reserved: fall back to using all of them.
+    ASSERT_EQ(3u, t.WorkerCpu(3, 4, 4));
+}
+
+/******************************************************************************/
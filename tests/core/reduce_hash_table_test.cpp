@@ -143,4 +143,61 @@ TEST(ReduceHashTable, OldProbingAddIntegers) {
         });
 }
 
+//! insert distinct keys into a tiny probing table, which either spills or grows
+//! with memory from the Stage's memory broker.
+static void TestProbingGrowFromBroker(Context& ctx, size_t broker_bytes) {
+    static constexpr size_t test_size = 5000;
+
+    auto key_ex = [](const MyStruct& in) { return in.key; };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct(in1.key, in1.value + in2.value);
+                  };
+
+    using Collector = TableCollector<MyStruct>;
+
+    Collector collector(13);
+
+    using Table = core::ReduceProbingHashTable<
+        MyStruct, size_t, MyStruct,
+        decltype(key_ex), decltype(red_fn), Collector,
+        /* VolatileKey */ false, core::DefaultReduceConfig,
+        core::ReduceByHash<size_t> >;
+
+    Table table(ctx, 0, key_ex, red_fn, collector,
+                /* num_partitions */ 13,
+                core::DefaultReduceConfig(),
+                /* immediate_flush */ false);
+    table.Initialize(/* limit_memory_bytes */ 1024);
+
+    ctx.set_stage_mem_available(broker_bytes);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        table.Insert(MyStruct(i, i));
+    }
+
+    if (broker_bytes == 0) {
+        ASSERT_TRUE(table.has_spilled_data());
+        ASSERT_EQ(1024u, table.limit_memory_bytes());
+    }
+    else {
+        ASSERT_FALSE(table.has_spilled_data());
+        ASSERT_LT(1024u, table.limit_memory_bytes());
+        ASSERT_EQ(broker_bytes,
+                  ctx.stage_mem_available() + table.limit_memory_bytes() - 1024);
+        ASSERT_EQ(test_size, table.num_items());
+    }
+
+    ctx.set_stage_mem_available(0);
+    table.Dispose();
+}
+
+TEST(ReduceHashTable, ProbingGrowFromBroker) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestProbingGrowFromBroker(ctx, /* broker_bytes */ 0);
+            TestProbingGrowFromBroker(ctx, /* broker_bytes */ 1024 * 1024);
+        });
+}
+
 /******************************************************************************/
@@ -11,11 +11,66 @@
 #include <gtest/gtest.h>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
+#include <thrill/data/mapped_file.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
 
+#include <foxxll/mng/config.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace thrill;
 
+//! size of the fast tier of flash disks, the slow tier autogrows.
+static constexpr size_t fast_tier_size = 4 * 1024 * 1024;
+
+//! foxxll config with a small fast tier and a slow tier, installed before any
+//! BlockPool starts the block manager.
+class TieredFoxxllConfig : public foxxll::config
+{
+public:
+    void load_default_config() override {
+        std::string path = "/var/tmp/thrill_block_pool_test."
+                           + std::to_string(getpid());
+
+        foxxll::disk_config slow(path + ".slow", 16 * 1024 * 1024, "syscall");
+        slow.unlink_on_open = true;
+        slow.direct = foxxll::disk_config::DIRECT_TRY;
+        slow.autogrow = true;
+        add_disk(slow);
+
+        foxxll::disk_config fast(path + ".fast", fast_tier_size, "syscall");
+        fast.unlink_on_open = true;
+        fast.direct = foxxll::disk_config::DIRECT_TRY;
+        fast.flash = true;
+        add_disk(fast);
+    }
+
+    std::string default_config_file_name() override {
+        return ".thrill_block_pool_test";
+    }
+};
+
+class TieredFoxxllEnvironment : public ::testing::Environment
+{
+public:
+    void SetUp() final {
+        foxxll::config::create_instance<TieredFoxxllConfig>();
+    }
+};
+
+static ::testing::Environment* const tiered_foxxll_environment =
+    ::testing::AddGlobalTestEnvironment(new TieredFoxxllEnvironment);
+
 struct BlockPoolTest : public ::testing::Test {
     data::BlockPool block_pool_;
 };
@@ -109,4 +164,431 @@ TEST_F(BlockPoolTest, EvictBlock) {
     ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
 }
 
+TEST_F(BlockPoolTest, EvictMappedBlocks) {
+    if (!data::MappedFile::supported()) return;
+
+    static constexpr size_t size = 10000;
+    vfs::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/mapped";
+
+    std::vector<char> content(3 * size + 100);
+    for (size_t i = 0; i < content.size(); ++i)
+        content[i] = static_cast<char>(i * 7 % 251);
+    {
+        std::ofstream of(path, std::ios::binary);
+        of.write(content.data(), content.size());
+    }
+
+    // map all but the first bytes, hence the range is not page aligned.
+    data::MappedFilePtr file = tlx::make_counting<data::MappedFile>(
+        path, common::Range(100, content.size()));
+
+    std::vector<data::Block> blocks;
+    for (size_t off = 100; off < content.size(); off += size) {
+        blocks.emplace_back(block_pool_.MapMappedBlock(file, off, size),
+                            0, size, 0, 0, false);
+    }
+    ASSERT_EQ(0u, block_pool_.total_blocks());
+
+    for (size_t round = 0; round < 2; ++round) {
+        // pinning points the Blocks into the mapping
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            data::PinnedBlock pinned_block = blocks[i].PinWait(0);
+            ASSERT_TRUE(std::equal(
+                            pinned_block.data_begin(), pinned_block.data_end(),
+                            reinterpret_cast<const data::Byte*>(
+                                content.data() + 100 + i * size)));
+        }
+        ASSERT_EQ(3u, block_pool_.unpinned_blocks());
+
+        // evicting drops the pages without writing them
+        for (data::Block& block : blocks)
+            block_pool_.EvictBlock(block.byte_block().get());
+        ASSERT_EQ(0u, block_pool_.unpinned_blocks());
+        ASSERT_EQ(0u, block_pool_.writing_blocks());
+        ASSERT_EQ(0u, block_pool_.swapped_blocks());
+    }
+}
+
+TEST_F(BlockPoolTest, EvictionFollowsNextUseHints) {
+    // three unpinned Blocks held by DIANodes 1, 2, and 3.
+    std::vector<data::Block> blocks;
+    for (size_t dia_id = 1; dia_id <= 3; ++dia_id) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        block->set_dia_id(dia_id);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+    ASSERT_EQ(3u, block_pool_.unpinned_blocks());
+
+    // DIANode 1 is used in Stage 5, DIANode 2 in Stage 3, and DIANode 3 not
+    // at all, and its Blocks are evicted first.
+    block_pool_.SetNextUse(1, 5);
+    block_pool_.SetNextUse(2, 3);
+    block_pool_.AdvanceStage(2);
+
+    std::vector<size_t> order;
+    while (block_pool_.unpinned_blocks() != 0) {
+        foxxll::request_ptr req = block_pool_.EvictBlockLRU();
+        req->wait();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!blocks[i].byte_block()->in_memory() &&
+                std::find(order.begin(), order.end(), i + 1) == order.end())
+                order.push_back(i + 1);
+        }
+    }
+    ASSERT_EQ(std::vector<size_t>({ 3, 1, 2 }), order);
+}
+
+TEST_F(BlockPoolTest, EvictionWithoutHintsIsLru) {
+    // Blocks of DIANodes 1 and 2 unpinned alternately, and one of DIANode 3.
+    std::vector<data::Block> blocks;
+    for (size_t dia_id : { 1, 2, 1, 2, 3 }) {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        block->set_dia_id(dia_id);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    // the hint of DIANode 1 expires, e.g. a Cache()d DIA reused later, which
+    // hence is evicted in LRU order with DIANode 2, before DIANode 3.
+    block_pool_.SetNextUse(1, 1);
+    block_pool_.SetNextUse(3, 4);
+    block_pool_.AdvanceStage(2);
+
+    std::vector<size_t> order;
+    while (block_pool_.unpinned_blocks() != 0) {
+        foxxll::request_ptr req = block_pool_.EvictBlockLRU();
+        req->wait();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            if (!blocks[i].byte_block()->in_memory() &&
+                std::find(order.begin(), order.end(), i) == order.end())
+                order.push_back(i);
+        }
+    }
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4 }), order);
+}
+
+TEST(BlockPool, ConcurrentPinsFromManyWorkers) {
+    static constexpr size_t workers = 4;
+    static constexpr size_t iterations = 10000;
+
+    data::BlockPool block_pool(workers);
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    ASSERT_EQ(1u, block_pool.unpinned_blocks());
+
+    // each worker repeatedly takes and releases additional pins, which mostly
+    // use the lock-free paths, while the Block is pinned and unpinned.
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; ++w) {
+        threads.emplace_back(
+            [&, w]() {
+                for (size_t i = 0; i < iterations; ++i) {
+                    data::PinnedBlock p1 = unpinned_block.PinWait(w);
+                    data::PinnedBlock p2 = p1;
+                    data::PinnedBlock p3 = unpinned_block.PinWait(w);
+                    ASSERT_EQ(3u, p1.byte_block()->pin_count(w));
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    for (size_t w = 0; w < workers; ++w)
+        ASSERT_EQ(0u, unpinned_block.byte_block()->pin_count(w));
+    ASSERT_EQ(0u, block_pool.pinned_blocks());
+    ASSERT_EQ(1u, block_pool.unpinned_blocks());
+}
+
+TEST(BlockPool, ConcurrentPinsReleasedByOtherThreads) {
+    static constexpr size_t iterations = 20000;
+
+    data::BlockPool block_pool(2);
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+
+    // worker 0 holds a pin throughout and takes additional pins on the fast
+    // path, which a dispatcher thread releases. Meanwhile worker 1 pins and
+    // unpins on the slow path. The Block must never become unpinned.
+    data::PinnedBlock base_pin = unpinned_block.PinWait(0);
+
+    std::mutex mutex;
+    std::deque<data::PinnedBlock> queue;
+    std::atomic<bool> done { false };
+
+    std::thread worker0(
+        [&]() {
+            for (size_t i = 0; i < iterations; ++i) {
+                data::PinnedBlock pin = unpinned_block.PinWait(0);
+                std::unique_lock<std::mutex> lock(mutex);
+                queue.emplace_back(std::move(pin));
+            }
+            done = true;
+        });
+    std::thread dispatcher(
+        [&]() {
+            for ( ; ; ) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (queue.empty()) {
+                    if (done) break;
+                    continue;
+                }
+                data::PinnedBlock pin = std::move(queue.front());
+                queue.pop_front();
+                // release the pin outside the lock
+                lock.unlock();
+            }
+        });
+    std::thread worker1(
+        [&]() {
+            for (size_t i = 0; i < iterations; ++i) {
+                data::PinnedBlock pin = unpinned_block.PinWait(1);
+                ASSERT_EQ(0u, block_pool.unpinned_blocks());
+            }
+        });
+
+    while (!done)
+        ASSERT_EQ(0u, block_pool.unpinned_blocks());
+
+    worker0.join();
+    dispatcher.join();
+    worker1.join();
+
+    ASSERT_EQ(0u, block_pool.unpinned_blocks());
+    ASSERT_EQ(1u, base_pin.byte_block()->pin_count(0));
+    ASSERT_EQ(0u, base_pin.byte_block()->pin_count(1));
+
+    base_pin.Reset();
+    ASSERT_EQ(0u, block_pool.pinned_blocks());
+    ASSERT_EQ(1u, block_pool.unpinned_blocks());
+}
+
+TEST(BlockPool, EvictToCompressedTier) {
+    static constexpr size_t size = 65536;
+
+    data::BlockPool block_pool(0, 0, nullptr, nullptr, 1, 1024 * 1024);
+
+    // two compressible Blocks and one of random bytes.
+    std::minstd_rand rng(42);
+    std::vector<std::vector<data::Byte> > contents(3);
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            contents[i].push_back(
+                static_cast<data::Byte>(i < 2 ? j % (5 + i) : rng()));
+        }
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(size, 0);
+        std::copy(contents[i].begin(), contents[i].end(), block->begin());
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    while (block_pool.unpinned_blocks() != 0) {
+        foxxll::request_ptr req = block_pool.EvictBlockLRU();
+        if (req) req->wait();
+    }
+#if THRILL_HAVE_LZ4 || THRILL_HAVE_ZLIB
+    ASSERT_EQ(2u, block_pool.compressed_blocks());
+    ASSERT_EQ(1u, block_pool.swapped_blocks());
+    ASSERT_LT(block_pool.total_ram_bytes(), size);
+#endif
+    ASSERT_EQ(3u, block_pool.total_blocks());
+    ASSERT_EQ(3 * size, block_pool.total_bytes());
+
+    // pinning decompresses or reads the Blocks transparently.
+    for (size_t i = 0; i < 3; ++i) {
+        data::PinnedBlock pinned_block = blocks[i].PinWait(0);
+        ASSERT_TRUE(std::equal(contents[i].begin(), contents[i].end(),
+                               pinned_block.byte_block()->begin()));
+    }
+    ASSERT_EQ(0u, block_pool.compressed_blocks());
+    ASSERT_EQ(3u, block_pool.unpinned_blocks());
+}
+
+TEST(BlockPool, DemoteFromFullCompressedTier) {
+    static constexpr size_t size = 65536;
+
+    // each Block repeats 4 KiB of random bytes and compresses to a bit more
+    // than 4 KiB, which is padded to 8 KiB, hence the tier holds only one.
+    data::BlockPool block_pool(0, 0, nullptr, nullptr, 1, 12000);
+
+    std::minstd_rand rng(42);
+    std::vector<std::vector<data::Byte> > contents(3);
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < 3; ++i) {
+        std::vector<data::Byte> pattern(4096);
+        for (data::Byte& b : pattern) b = static_cast<data::Byte>(rng());
+        for (size_t j = 0; j < size; ++j)
+            contents[i].push_back(pattern[j % pattern.size()]);
+
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(size, 0);
+        std::copy(contents[i].begin(), contents[i].end(), block->begin());
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    // evicting a Block into the full tier demotes the older one to disk.
+    while (block_pool.unpinned_blocks() != 0)
+        block_pool.EvictBlockLRU();
+    while (foxxll::request_ptr req = block_pool.GetAnyWriting())
+        req->wait();
+#if THRILL_HAVE_LZ4 || THRILL_HAVE_ZLIB
+    ASSERT_EQ(1u, block_pool.compressed_blocks());
+    ASSERT_EQ(2u, block_pool.swapped_blocks());
+#endif
+    ASSERT_EQ(3u, block_pool.total_blocks());
+
+    // pinning reads and decompresses the demoted Blocks.
+    for (size_t i = 0; i < 3; ++i) {
+        data::PinnedBlock pinned_block = blocks[i].PinWait(0);
+        ASSERT_TRUE(std::equal(contents[i].begin(), contents[i].end(),
+                               pinned_block.byte_block()->begin()));
+    }
+    ASSERT_EQ(0u, block_pool.compressed_blocks());
+    ASSERT_EQ(0u, block_pool.swapped_blocks());
+    ASSERT_EQ(3u, block_pool.unpinned_blocks());
+}
+
+TEST(BlockPool, SpillToFastAndSlowTier) {
+    static constexpr size_t fast = 0, slow = 1;
+    static constexpr size_t large = 2 * 1024 * 1024;
+    static constexpr size_t small = 256 * 1024;
+
+    data::BlockPool block_pool(0, 0, nullptr, nullptr, 1);
+
+    // DIANode 1 is used in the next Stage, DIANode 2 not at all.
+    block_pool.SetNextUse(1, 1);
+
+    std::vector<size_t> sizes = { large, large };
+    sizes.resize(2 + 7, small);
+
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        data::PinnedByteBlockPtr block =
+            block_pool.AllocateByteBlock(sizes[i], 0);
+        block->set_dia_id(i == 0 ? 1 : 2);
+        std::fill(block->begin(), block->end(), static_cast<data::Byte>(i));
+        data::PinnedBlock pinned_block(
+            std::move(block), 0, sizes[i], 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    // a hot large Block goes to the fast tier, a cold one to the slow tier.
+    block_pool.EvictBlock(blocks[0].byte_block().get());
+    ASSERT_EQ(large, block_pool.em_tier_bytes(fast));
+    block_pool.EvictBlock(blocks[1].byte_block().get());
+    ASSERT_EQ(large, block_pool.em_tier_bytes(slow));
+
+    // small Blocks are hot and fill the fast tier up to 90%, then fall back
+    // to the slow tier.
+    for (size_t i = 2; i < blocks.size(); ++i)
+        block_pool.EvictBlock(blocks[i].byte_block().get());
+    ASSERT_EQ(large + 6 * small, block_pool.em_tier_bytes(fast));
+    ASSERT_EQ(large + small, block_pool.em_tier_bytes(slow));
+    ASSERT_LE((large + 6 * small) * 10, fast_tier_size * 9);
+    ASSERT_GT((large + 7 * small) * 10, fast_tier_size * 9);
+
+    ASSERT_EQ(blocks.size(),
+              block_pool.writing_blocks() + block_pool.swapped_blocks());
+    while (foxxll::request_ptr req = block_pool.GetAnyWriting())
+        req->wait();
+    ASSERT_EQ(0u, block_pool.em_tier_queue_depth(fast));
+    ASSERT_EQ(0u, block_pool.em_tier_queue_depth(slow));
+    ASSERT_EQ(large + 6 * small, block_pool.em_tier_written_bytes(fast));
+    ASSERT_EQ(large + small, block_pool.em_tier_written_bytes(slow));
+
+    // reading the Blocks back frees their space in both tiers.
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        data::PinnedBlock pinned_block = blocks[i].PinWait(0);
+        ASSERT_TRUE(std::all_of(
+                        pinned_block.data_begin(), pinned_block.data_end(),
+                        [i](const data::Byte& b) {
+                            return b == static_cast<data::Byte>(i);
+                        }));
+    }
+    ASSERT_EQ(0u, block_pool.em_tier_queue_depth(fast));
+    ASSERT_EQ(0u, block_pool.em_tier_queue_depth(slow));
+    ASSERT_EQ(large + 6 * small, block_pool.em_tier_read_bytes(fast));
+    ASSERT_EQ(large + small, block_pool.em_tier_read_bytes(slow));
+    ASSERT_EQ(0u, block_pool.em_tier_bytes(fast));
+    ASSERT_EQ(0u, block_pool.em_tier_bytes(slow));
+}
+
+TEST(BlockPool, DemoteOddSizedCompressedCopy) {
+    static constexpr size_t size = 65536;
+
+    // a pattern of 3001 random bytes compresses to an odd size, which is
+    // padded to 4 KiB, hence the tier holds only one copy. The demoted copy is
+    // written padded to the disks, which use O_DIRECT if possible.
+    data::BlockPool block_pool(0, 0, nullptr, nullptr, 1, 6000);
+
+    std::minstd_rand rng(7);
+    std::vector<data::Byte> pattern(3001);
+    for (data::Byte& b : pattern) b = static_cast<data::Byte>(rng());
+
+    std::vector<data::Block> blocks;
+    for (size_t i = 0; i < 2; ++i) {
+        data::PinnedByteBlockPtr block = block_pool.AllocateByteBlock(size, 0);
+        for (size_t j = 0; j < size; ++j)
+            block->begin()[j] = pattern[(i + j) % pattern.size()];
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        blocks.emplace_back(pinned_block.ToBlock());
+    }
+
+    while (block_pool.unpinned_blocks() != 0)
+        block_pool.EvictBlockLRU();
+    while (foxxll::request_ptr req = block_pool.GetAnyWriting())
+        req->wait();
+#if THRILL_HAVE_LZ4 || THRILL_HAVE_ZLIB
+    ASSERT_EQ(1u, block_pool.compressed_blocks());
+    ASSERT_EQ(1u, block_pool.swapped_blocks());
+
+    size_t written =
+        block_pool.em_tier_written_bytes(0) + block_pool.em_tier_written_bytes(1);
+    ASSERT_GT(written, 0u);
+    ASSERT_LT(written, size);
+    ASSERT_EQ(0u, written % foxxll::BlockAlignment);
+#endif
+
+    // the demoted copy decompresses from its unpadded size.
+    for (size_t i = 0; i < 2; ++i) {
+        data::PinnedBlock pinned_block = blocks[i].PinWait(0);
+        for (size_t j = 0; j < size; ++j) {
+            ASSERT_EQ(pattern[(i + j) % pattern.size()],
+                      pinned_block.byte_block()->begin()[j]);
+        }
+    }
+    ASSERT_EQ(0u, block_pool.compressed_blocks());
+    ASSERT_EQ(0u, block_pool.swapped_blocks());
+}
+
+TEST(BlockPool, PrefetchBudgetPerWorker) {
+    static constexpr size_t hard_limit = 8 * 1024 * 1024;
+    static constexpr size_t budget = hard_limit / 2 / 2;
+
+    data::BlockPool block_pool(
+        hard_limit, hard_limit, nullptr, nullptr, /* workers_per_host */ 2);
+
+    // adaptive readers are granted at most the worker's budget
+    ASSERT_EQ(budget, block_pool.ReservePrefetch(0, 2 * budget));
+    ASSERT_EQ(0u, block_pool.ReservePrefetch(0, 1));
+    ASSERT_EQ(budget / 2, block_pool.ReservePrefetch(1, budget / 2));
+
+    // explicit prefetch sizes are always granted
+    ASSERT_EQ(budget, block_pool.ReservePrefetch(0, budget, /* force */ true));
+
+    block_pool.ReleasePrefetch(0, 2 * budget);
+    block_pool.ReleasePrefetch(1, budget / 2);
+    ASSERT_EQ(budget, block_pool.ReservePrefetch(1, budget));
+    block_pool.ReleasePrefetch(1, budget);
+}
+
 /******************************************************************************/
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * tests/data/column_file_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/data/column_file.hpp>
+
+#include <tuple>
+
+using namespace thrill;
+
+struct ColumnFile : public ::testing::Test {
+    data::BlockPool block_pool_;
+};
+
+using LineItem = std::tuple<uint64_t, int32_t, double, char, uint16_t>;
+
+static LineItem MakeLineItem(size_t i) {
+    return LineItem(1000000 + i, static_cast<int32_t>(i % 7) - 3,
+                    static_cast<double>(i) / 10, static_cast<char>('a' + i % 3),
+                    static_cast<uint16_t>(i / 50));
+}
+
+static void WriteAndReadColumns(data::BlockPool& block_pool,
+                                data::ColumnEncoding encoding) {
+    static constexpr size_t size = 12345;
+
+    data::ColumnFile<uint64_t, int32_t, double, char, uint16_t> file(
+        block_pool, 0, /* dia_id */ 0, /* page_items */ 1000, encoding);
+    {
+        auto writer = file.GetWriter(/* block_size */ 256);
+        for (size_t i = 0; i < size; ++i)
+            writer.Put(MakeLineItem(i));
+    }
+    ASSERT_EQ(size, file.num_items());
+
+    // read a projection of two columns
+    {
+        auto reader = file.GetReader<1, 3>(/* consume */ false);
+        size_t i = 0;
+        while (reader.HasNext()) {
+            std::tuple<int32_t, char> t = reader.Next();
+            ASSERT_EQ(std::get<1>(MakeLineItem(i)), std::get<0>(t));
+            ASSERT_EQ(std::get<3>(MakeLineItem(i)), std::get<1>(t));
+            ++i;
+        }
+        ASSERT_EQ(size, i);
+    }
+
+    // read all columns while consuming the ColumnFile
+    {
+        auto reader = file.GetFullReader(/* consume */ true);
+        size_t i = 0;
+        while (reader.HasNext())
+            ASSERT_EQ(MakeLineItem(i++), reader.Next());
+        ASSERT_EQ(size, i);
+    }
+    ASSERT_TRUE(file.empty());
+}
+
+TEST_F(ColumnFile, PlainEncoding) {
+    WriteAndReadColumns(block_pool_, data::ColumnEncoding::Plain);
+}
+
+TEST_F(ColumnFile, DictionaryEncoding) {
+    WriteAndReadColumns(block_pool_, data::ColumnEncoding::Dictionary);
+}
+
+TEST_F(ColumnFile, DictionaryEncodingOfDistinctItems) {
+    static constexpr size_t size = 100000;
+
+    // a page with more distinct items than dictionary indexes can address is
+    // stored plainly.
+    data::ColumnFile<uint64_t> file(
+        block_pool_, 0, /* dia_id */ 0, /* page_items */ size,
+        data::ColumnEncoding::Dictionary);
+    {
+        auto writer = file.GetWriter();
+        for (size_t i = 0; i < size; ++i)
+            writer.Put(std::make_tuple(uint64_t(i) * 7));
+    }
+
+    auto reader = file.GetFullReader(/* consume */ true);
+    for (size_t i = 0; i < size; ++i)
+        ASSERT_EQ(uint64_t(i) * 7, std::get<0>(reader.Next()));
+    ASSERT_FALSE(reader.HasNext());
+}
+
+TEST_F(ColumnFile, RunLengthEncoding) {
+    WriteAndReadColumns(block_pool_, data::ColumnEncoding::RunLength);
+}
+
+TEST_F(ColumnFile, AutoEncoding) {
+    WriteAndReadColumns(block_pool_, data::ColumnEncoding::Auto);
+}
+
+TEST_F(ColumnFile, EncodingsShrinkColumns) {
+    static constexpr size_t size = 100000;
+
+    data::ColumnFile<uint64_t, char> file(block_pool_, 0, /* dia_id */ 0);
+    file.set_encoding(0, data::ColumnEncoding::FrameOfReference);
+    {
+        auto writer = file.GetWriter();
+        for (size_t i = 0; i < size; ++i)
+            writer.Put(std::make_tuple(uint64_t(1) << 40 | (i % 1000),
+                                       static_cast<char>('a' + i / 10000)));
+    }
+
+    // frame-of-reference needs two bytes per key, run-length only few bytes
+    ASSERT_LT(file.column(0).size_bytes(), 3 * size);
+    ASSERT_LT(file.column(1).size_bytes(), size / 10);
+
+    auto reader = file.GetReader<0>(/* consume */ false);
+    for (size_t i = 0; i < size; ++i)
+        ASSERT_EQ(uint64_t(1) << 40 | (i % 1000), std::get<0>(reader.Next()));
+    ASSERT_FALSE(reader.HasNext());
+}
+
+/******************************************************************************/
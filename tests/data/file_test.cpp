@@ -16,7 +16,9 @@
 #include <tlx/string/hexdump.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -254,6 +256,76 @@ TEST_F(File, SerializeSomeItemsConsumeReader) {
     ASSERT_EQ(0u, file.num_items());
 }
 
+//! read all items of file with spans of up to 7 items, falling back to Next()
+//! for straddling or unaligned items. Returns the number of fallbacks.
+static size_t ReadSpans(data::File& file, std::vector<uint64_t>& out) {
+    data::File::Reader fr = file.GetReader(false);
+    size_t fallbacks = 0;
+    while (fr.HasNext()) {
+        common::Span<const uint64_t> span = fr.NextSpan<uint64_t>(7);
+        EXPECT_LE(span.size(), 7u);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(span.data())
+                  % alignof(uint64_t));
+        if (span.empty()) {
+            out.push_back(fr.Next<uint64_t>());
+            ++fallbacks;
+        }
+        else {
+            out.insert(out.end(), span.begin(), span.end());
+        }
+    }
+    return fallbacks;
+}
+
+TEST_F(File, PutBatchReadSpans) {
+    static constexpr size_t size = 5000;
+
+    std::vector<uint64_t> items(size);
+    std::iota(items.begin(), items.end(), 0);
+
+    // construct File with very small blocks, such that items straddle blocks,
+    // and the items in most blocks are not aligned.
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    {
+        data::File::Writer fw = file.GetWriter(53);
+        fw.PutBatch(items.data(), 10);
+        fw.PutBatch(items.data() + 10, size - 10);
+    }
+    ASSERT_EQ(size, file.num_items());
+
+    // read items back in spans, unaligned items fall back to Next(), hence
+    // there are many more fallbacks than straddling items.
+    {
+        std::vector<uint64_t> out;
+        size_t fallbacks = ReadSpans(file, out);
+        ASSERT_EQ(items, out);
+        ASSERT_GT(fallbacks, 2 * file.num_blocks());
+    }
+
+    // and with ForEach() while consuming the File
+    {
+        data::File::Reader fr = file.GetReader(true);
+        size_t i = 0;
+        fr.ForEach<uint64_t>([&](const uint64_t& x) { ASSERT_EQ(i++, x); });
+        ASSERT_EQ(size, i);
+    }
+    ASSERT_TRUE(file.empty());
+
+    // with blocks of whole items, all items are read as aligned spans.
+    data::File aligned_file(block_pool_, 0, /* dia_id */ 0);
+    {
+        data::File::Writer fw = aligned_file.GetWriter(64);
+        fw.PutBatch(items.data(), size);
+    }
+    {
+        std::vector<uint64_t> out;
+        size_t fallbacks = ReadSpans(aligned_file, out);
+        ASSERT_EQ(items, out);
+        if (!data::File::Reader::self_verify)
+            ASSERT_EQ(0u, fallbacks);
+    }
+}
+
 TEST_F(File, RandomGetIndexOf) {
     static constexpr size_t size = 500;
 
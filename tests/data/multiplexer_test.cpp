@@ -18,7 +18,13 @@
 #include <thrill/net/group.hpp>
 #include <thrill/net/mock/group.hpp>
 
+#if THRILL_HAVE_NET_TCP
+#include <thrill/net/tcp/group.hpp>
+#endif
+
 #include <algorithm>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -171,7 +177,12 @@ struct Multiplexer : public ::testing::Test {
 
 // open a Stream via data::Multiplexer, and send a short message to all workers,
 // receive and check the message.
-void TalkAllToAllViaCatStream(net::Group* net) {
+void TalkAllToAllViaCatStreamSharded(
+    net::Group* net, size_t num_dispatchers,
+    size_t credit_window = data::Multiplexer::auto_credit_window,
+    size_t soft_ram_limit = 0,
+    std::chrono::milliseconds credit_max_delay =
+        data::Multiplexer::default_credit_max_delay) {
     common::NameThisThread("chmp" + std::to_string(net->my_host_rank()));
 
     unsigned char send_buffer[123];
@@ -184,10 +195,17 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     size_t total_workers = num_hosts * num_workers_per_host;
 
     mem::Manager mem_manager(nullptr, "Benchmark");
-    data::BlockPool block_pool(num_workers_per_host);
+    std::unique_ptr<data::BlockPool> block_pool_ptr =
+        soft_ram_limit == 0
+        ? std::make_unique<data::BlockPool>(num_workers_per_host)
+        : std::make_unique<data::BlockPool>(
+            soft_ram_limit, /* hard_ram_limit */ 0, nullptr, &mem_manager,
+            num_workers_per_host);
+    data::BlockPool& block_pool = *block_pool_ptr;
     net::DispatcherThread disp(net->ConstructDispatcher(), 0);
     data::Multiplexer multiplexer(
-        mem_manager, block_pool, disp, *net, num_workers_per_host);
+        mem_manager, block_pool, disp, *net, num_workers_per_host,
+        num_dispatchers, credit_window, credit_max_delay);
 
     auto thread_func =
         [&](size_t my_local_worker_id) {
@@ -287,10 +305,15 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     std::thread t1 = std::thread(thread_func, 1);
     t0.join(), t1.join();
 
-    // stop DispatcherThread before Multiplexer
+    // stop DispatcherThreads before Multiplexer
+    multiplexer.TerminateDispatchers();
     disp.Terminate();
 }
 
+void TalkAllToAllViaCatStream(net::Group* net) {
+    return TalkAllToAllViaCatStreamSharded(net, 1);
+}
+
 TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     data::default_block_size = test_block_size;
     // test for all network mesh sizes 1, 2, 5, 9:
@@ -300,6 +323,61 @@ TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     net::RunLoopbackGroupTest(9, TalkAllToAllViaCatStream);
 }
 
+#if THRILL_HAVE_NET_TCP
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamStriped) {
+    data::default_block_size = test_block_size;
+    // stripe Blocks over three parallel connections to each peer
+    std::function<void(net::Group*)> func = TalkAllToAllViaCatStream;
+    net::ExecuteGroupThreads(net::tcp::Group::ConstructLoopbackMesh(2, 3), func);
+    net::ExecuteGroupThreads(net::tcp::Group::ConstructLoopbackMesh(5, 3), func);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamMultipleDispatchers) {
+    data::default_block_size = test_block_size;
+    // shard the striped connections over three DispatcherThreads
+    std::function<void(net::Group*)> func =
+        [](net::Group* net) { TalkAllToAllViaCatStreamSharded(net, 3); };
+    net::ExecuteGroupThreads(net::tcp::Group::ConstructLoopbackMesh(2, 3), func);
+    net::ExecuteGroupThreads(net::tcp::Group::ConstructLoopbackMesh(5, 3), func);
+}
+#endif
+
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamCreditWindow) {
+    data::default_block_size = test_block_size;
+    // grant only a single byte of credit, such that each Block has to wait
+    // until the receiver returned the credit for the previous one.
+    std::function<void(net::Group*)> func =
+        [](net::Group* net) { TalkAllToAllViaCatStreamSharded(net, 1, 1); };
+    net::RunLoopbackGroupTest(2, func);
+    net::RunLoopbackGroupTest(5, func);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaCatStreamUnderSoftLimit) {
+    data::default_block_size = test_block_size;
+    // a soft limit of a few Blocks keeps the receivers above it, hence they
+    // return credit only as they evict or consume Blocks. The fallback delay is
+    // far away, hence the throughput shows whether credit is returned in
+    // proportion to the released memory instead of being held until then.
+    static constexpr std::chrono::milliseconds max_delay { 60000 };
+    std::function<void(net::Group*)> func =
+        [](net::Group* net) {
+            auto start = std::chrono::steady_clock::now();
+            TalkAllToAllViaCatStreamSharded(
+                net, 1, data::Multiplexer::auto_credit_window,
+                /* soft_ram_limit */ 8 * test_block_size, max_delay);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+            // payload sent by the two workers of this host to all workers
+            size_t bytes = 2 * 2 * net->num_hosts() * 1000 * 123;
+            LOG << "host " << net->my_host_rank() << " throughput "
+                << bytes / seconds / 1024 << " KiB/s";
+            ASSERT_LT(seconds, 10.0);
+        };
+    net::RunLoopbackGroupTest(2, func);
+    net::RunLoopbackGroupTest(3, func);
+}
+
 TEST_F(Multiplexer, ReadCompleteCatStream) {
     data::default_block_size = test_block_size;
     auto w0 =
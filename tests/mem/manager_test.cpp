@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * tests/mem/manager_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/manager.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace thrill;
+
+TEST(MemManager, ShardedTotalsFromManyThreads) {
+    mem::Manager root(nullptr, "ManagerTestRoot");
+    mem::Manager child(&root, "ManagerTestChild");
+
+    static constexpr size_t num_threads = 8;
+    static constexpr size_t iterations = 100000;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&child, t]() {
+                for (size_t i = 0; i < iterations; ++i) {
+                    child.add(64 + t);
+                    if (i % 2 == 1) child.subtract(64 + t);
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    size_t expected = 0;
+    for (size_t t = 0; t < num_threads; ++t)
+        expected += (64 + t) * (iterations / 2);
+
+    // the child's total includes pending deltas, the root's only after flush.
+    ASSERT_EQ(expected, child.total());
+
+    child.flush();
+    ASSERT_EQ(expected, root.total());
+
+    for (size_t t = 0; t < num_threads; ++t)
+        child.subtract((64 + t) * (iterations / 2));
+
+    ASSERT_EQ(0u, child.total());
+    child.flush();
+    ASSERT_EQ(0u, root.total());
+}
+
+TEST(MemManager, SmallDeltasArePending) {
+    mem::Manager root(nullptr, "ManagerTestRoot");
+    {
+        mem::Manager child(&root, "ManagerTestChild");
+        child.add(100);
+        ASSERT_EQ(100u, child.total());
+        ASSERT_EQ(0u, root.total());
+
+        const size_t threshold = mem::Manager::flush_threshold;
+
+        child.add(threshold);
+        ASSERT_EQ(100u + threshold, root.total());
+
+        child.subtract(threshold);
+        ASSERT_EQ(100u, root.total());
+
+        child.add(20);
+        ASSERT_EQ(100u, root.total());
+    }
+    // destroying the child flushes its pending delta
+    ASSERT_EQ(120u, root.total());
+    root.subtract(120);
+    ASSERT_EQ(0u, root.total());
+}
+
+/******************************************************************************/
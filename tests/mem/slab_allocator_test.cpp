@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * tests/mem/slab_allocator_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/mem/slab_allocator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace thrill;
+
+TEST(SlabAllocator, RandomAllocDeallocRecycles) {
+    mem::Manager manager(nullptr, "SlabAllocatorTest");
+    mem::SlabAllocator slab(&manager);
+
+    std::default_random_engine rng(std::random_device { } ());
+    std::deque<std::pair<void*, size_t> > list;
+
+    for (size_t iterations = 2000; iterations != 0; --iterations) {
+        if (rng() % 3 != 0 || list.empty()) {
+            size_t size = mem::SlabAllocator::min_size
+                          << (rng() % mem::SlabAllocator::num_classes);
+            void* ptr = slab.allocate(size);
+            ASSERT_NE(nullptr, ptr);
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % size);
+            ASSERT_TRUE(slab.owns(ptr));
+            memset(ptr, 0x42, size);
+            list.emplace_back(ptr, size);
+        }
+        else {
+            slab.deallocate(list.front().first, list.front().second);
+            list.pop_front();
+        }
+    }
+
+    size_t mapped = slab.mapped_bytes();
+    size_t size = list.empty() ? 0 : list.back().second;
+    while (!list.empty()) {
+        slab.deallocate(list.front().first, list.front().second);
+        list.pop_front();
+    }
+
+    // slabs are kept for reuse instead of being returned to the OS, and
+    // remain counted in the Manager.
+    ASSERT_EQ(mapped, manager.total());
+    ASSERT_EQ(mapped, slab.mapped_bytes());
+    ASSERT_EQ(mapped, slab.cached_bytes());
+
+    if (size != 0) {
+        void* ptr = slab.allocate(size);
+        ASSERT_EQ(mapped, slab.mapped_bytes());
+        ASSERT_EQ(mapped - size, slab.cached_bytes());
+        slab.deallocate(ptr, size);
+    }
+
+    // all chunks are empty, hence they can be unmapped.
+    ASSERT_EQ(mapped, slab.ReleaseCached(mapped));
+    ASSERT_EQ(0u, slab.mapped_bytes());
+    ASSERT_EQ(0u, manager.total());
+
+    int on_stack;
+    ASSERT_FALSE(slab.owns(&on_stack));
+}
+
+TEST(SlabAllocator, EmptyChunksAreCarvedForOtherClasses) {
+    mem::Manager manager(nullptr, "SlabAllocatorTest");
+    mem::SlabAllocator slab(&manager);
+
+    static constexpr size_t chunk_size = mem::SlabAllocator::chunk_size;
+    static constexpr size_t small = mem::SlabAllocator::min_size;
+    static constexpr size_t large = chunk_size / 4;
+
+    // fill one chunk with small slabs and free them again.
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < chunk_size / small; ++i) {
+        ptrs.push_back(slab.allocate(small));
+        ASSERT_NE(nullptr, ptrs.back());
+    }
+    ASSERT_EQ(chunk_size, slab.mapped_bytes());
+    for (void* ptr : ptrs)
+        slab.deallocate(ptr, small);
+    ptrs.clear();
+
+    // the empty chunk is re-carved into large slabs without mapping another.
+    for (size_t i = 0; i < chunk_size / large; ++i) {
+        ptrs.push_back(slab.allocate(large));
+        ASSERT_NE(nullptr, ptrs.back());
+        ASSERT_TRUE(slab.owns(ptrs.back()));
+    }
+    ASSERT_EQ(chunk_size, slab.mapped_bytes());
+    ASSERT_EQ(0u, slab.cached_bytes());
+
+    // chunks with slabs in use are not released.
+    ASSERT_EQ(0u, slab.ReleaseCached(chunk_size));
+
+    for (void* ptr : ptrs)
+        slab.deallocate(ptr, large);
+    ASSERT_EQ(chunk_size, slab.cached_bytes());
+    ASSERT_EQ(chunk_size, manager.total());
+}
+
+/******************************************************************************/
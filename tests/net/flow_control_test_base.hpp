@@ -446,6 +446,32 @@ static void TestAllGatherString(net::Group* net) {
     }
 }
 
+//! start asynchronous collectives and check them after a blocking one
+static void TestMultiThreadAsyncCollectives(net::Group* net) {
+    const size_t count = 4;
+    ExecuteMultiThreads(
+        net, count, [=](net::FlowControlChannel& channel) {
+            size_t n = channel.num_workers();
+            size_t my_rank = channel.my_rank();
+
+            auto sum = channel.AllReduceAsync(my_rank);
+            auto prefix = channel.PrefixSumAsync(size_t(1));
+            auto ex_prefix = channel.PrefixSumAsync(
+                size_t(1), std::plus<size_t>(), size_t(0), false);
+            auto bcast = channel.BroadcastAsync(my_rank + 42, n - 1);
+            auto barrier = channel.BarrierAsync();
+
+            // blocking collective waits for the asynchronous ones
+            ASSERT_EQ(n, channel.AllReduce(size_t(1)));
+
+            ASSERT_EQ(n * (n - 1) / 2, sum.get());
+            ASSERT_EQ(my_rank + 1, prefix.get());
+            ASSERT_EQ(my_rank, ex_prefix.get());
+            ASSERT_EQ(n - 1 + 42, bcast.get());
+            barrier.get();
+        });
+}
+
 #endif // !THRILL_TESTS_NET_FLOW_CONTROL_TEST_BASE_HEADER
 
 /******************************************************************************/
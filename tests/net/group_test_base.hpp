@@ -214,6 +214,101 @@ static void TestAllReduceEliminationString(net::Group* net) {
     ASSERT_EQ(result.substr(0, net->num_hosts()), local_value);
 }
 
+//! let group of p hosts broadcast strings along the pipelined chain
+static void TestBroadcastPipelinedChain(net::Group* net) {
+    for (size_t origin = 0; origin < net->num_hosts(); ++origin) {
+        std::string value = net->my_host_rank() == origin ? "abcdefgh" : "";
+        net->BroadcastPipelinedChain(value, origin);
+        ASSERT_EQ("abcdefgh", value);
+    }
+
+    // large value which BroadcastSelect() sends along the chain
+    std::string large(net::Group::kBroadcastChainThreshold + 12345, 0);
+    for (size_t i = 0; i < large.size(); ++i)
+        large[i] = static_cast<char>('a' + i % 26);
+
+    size_t origin = net->num_hosts() / 2;
+    std::string value = net->my_host_rank() == origin ? large : "";
+    net->Broadcast(value, origin);
+    ASSERT_EQ(large, value);
+}
+
+//! let group of p hosts perform component-wise vector sums
+static void TestAllReduceRabenseifner(net::Group* net) {
+    size_t p = net->num_hosts();
+
+    std::vector<size_t> small = { net->my_host_rank(), 1, 2 };
+    net->AllReduceRabenseifner(
+        small, common::ComponentSum<std::vector<size_t> >());
+    ASSERT_EQ(std::vector<size_t>({ p * (p - 1) / 2, p, 2 * p }), small);
+
+    // large vector for which AllReduce() selects Rabenseifner's algorithm
+    size_t n = net::Group::kAllReduceRabenseifnerThreshold / sizeof(size_t) + 7;
+    std::vector<size_t> values(n);
+    for (size_t i = 0; i < n; ++i)
+        values[i] = i * p + net->my_host_rank();
+
+    net->AllReduce(values, common::ComponentSum<std::vector<size_t> >());
+    for (size_t i = 0; i < n; ++i)
+        ASSERT_EQ(i * p * p + p * (p - 1) / 2, values[i]);
+}
+
+//! restores the flat host layout of a group when leaving the scope, also if an
+//! assertion failed, such that the rack layout does not leak into later tests.
+class FlatHostRacksGuard
+{
+public:
+    explicit FlatHostRacksGuard(net::Group* net) : net_(net) { }
+
+    ~FlatHostRacksGuard() {
+        // a single rack of all hosts is the flat layout
+        net_->SetHostRacks(std::vector<size_t>(net_->num_hosts(), 0));
+    }
+
+private:
+    net::Group* net_;
+};
+
+//! let group of p hosts perform collectives in racks of three hosts
+static void TestHierarchicalCollectives(net::Group* net) {
+    size_t p = net->num_hosts();
+    FlatHostRacksGuard flat_guard(net);
+
+    // racks must consist of consecutive hosts
+    if (p >= 3) {
+        std::vector<size_t> interleaved(p);
+        for (size_t h = 0; h < p; ++h) interleaved[h] = h % 2;
+        ASSERT_FALSE(net->SetHostRacks(interleaved));
+    }
+
+    std::vector<size_t> racks(p);
+    for (size_t h = 0; h < p; ++h) racks[h] = h / 3;
+    ASSERT_TRUE(net->SetHostRacks(racks));
+    ASSERT_EQ((p + 2) / 3, net->num_racks());
+
+    for (size_t origin = 0; origin < p; ++origin) {
+        size_t local_value = net->my_host_rank() == origin ? 42 : 0;
+        net->Broadcast(local_value, origin);
+        ASSERT_EQ(42u, local_value);
+
+        std::string str = net->my_host_rank() == origin ? "abc" : "";
+        net->BroadcastHierarchical(str, origin);
+        ASSERT_EQ("abc", str);
+    }
+
+    // string concatenation checks the reduction order
+    const std::string result = "abcdefghijklmnopqrstuvwxyz";
+    std::string local_value = result.substr(net->my_host_rank(), 1);
+    net->AllReduce(local_value);
+    ASSERT_EQ(result.substr(0, p), local_value);
+
+    // large vectors use Rabenseifner's algorithm among the rack leaders
+    size_t n = net::Group::kAllReduceRabenseifnerThreshold / sizeof(size_t);
+    std::vector<size_t> values(n, net->my_host_rank());
+    net->AllReduce(values, common::ComponentSum<std::vector<size_t> >());
+    ASSERT_EQ(std::vector<size_t>(n, p * (p - 1) / 2), values);
+}
+
 /******************************************************************************/
 // Dispatcher Tests
 
@@ -94,6 +94,15 @@ TEST(MockGroup, AllReduceHypercubeString) {
 TEST(MockGroup, AllReduceEliminationString) {
     MockTest(TestAllReduceEliminationString);
 }
+TEST(MockGroup, BroadcastPipelinedChain) {
+    MockTest(TestBroadcastPipelinedChain);
+}
+TEST(MockGroup, AllReduceRabenseifner) {
+    MockTest(TestAllReduceRabenseifner);
+}
+TEST(MockGroup, HierarchicalCollectives) {
+    MockTest(TestHierarchicalCollectives);
+}
 TEST(MockGroup, DispatcherSyncSendAsyncRead) {
     MockTest(TestDispatcherSyncSendAsyncRead);
 }
@@ -145,6 +154,9 @@ TEST(MockGroup, AllGatherMultiThreaded) {
 TEST(MockGroup, AllGatherString) {
     MockTestLess(TestAllGatherString);
 }
+TEST(MockGroup, MultiThreadAsyncCollectives) {
+    MockTestLess(TestMultiThreadAsyncCollectives);
+}
 // [[[end]]]
 
 /******************************************************************************/
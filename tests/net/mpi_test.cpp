@@ -84,6 +84,15 @@ TEST(MpiGroup, AllReduceHypercubeString) {
 TEST(MpiGroup, AllReduceEliminationString) {
     MpiTest(TestAllReduceEliminationString);
 }
+TEST(MpiGroup, BroadcastPipelinedChain) {
+    MpiTest(TestBroadcastPipelinedChain);
+}
+TEST(MpiGroup, AllReduceRabenseifner) {
+    MpiTest(TestAllReduceRabenseifner);
+}
+TEST(MpiGroup, HierarchicalCollectives) {
+    MpiTest(TestHierarchicalCollectives);
+}
 TEST(MpiGroup, DispatcherSyncSendAsyncRead) {
     MpiTest(TestDispatcherSyncSendAsyncRead);
 }
@@ -135,6 +144,9 @@ TEST(MpiGroup, AllGatherMultiThreaded) {
 TEST(MpiGroup, AllGatherString) {
     MpiTest(TestAllGatherString);
 }
+TEST(MpiGroup, MultiThreadAsyncCollectives) {
+    MpiTest(TestMultiThreadAsyncCollectives);
+}
 // [[[end]]]
 
 /******************************************************************************/
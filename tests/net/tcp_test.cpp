@@ -86,6 +86,15 @@ TEST(RealTcpGroup, AllReduceHypercubeString) {
 TEST(RealTcpGroup, AllReduceEliminationString) {
     RealGroupTest(TestAllReduceEliminationString);
 }
+TEST(RealTcpGroup, BroadcastPipelinedChain) {
+    RealGroupTest(TestBroadcastPipelinedChain);
+}
+TEST(RealTcpGroup, AllReduceRabenseifner) {
+    RealGroupTest(TestAllReduceRabenseifner);
+}
+TEST(RealTcpGroup, HierarchicalCollectives) {
+    RealGroupTest(TestHierarchicalCollectives);
+}
 TEST(RealTcpGroup, DispatcherSyncSendAsyncRead) {
     RealGroupTest(TestDispatcherSyncSendAsyncRead);
 }
@@ -131,6 +140,15 @@ TEST(LocalTcpGroup, AllReduceHypercubeString) {
 TEST(LocalTcpGroup, AllReduceEliminationString) {
     LocalGroupTest(TestAllReduceEliminationString);
 }
+TEST(LocalTcpGroup, BroadcastPipelinedChain) {
+    LocalGroupTest(TestBroadcastPipelinedChain);
+}
+TEST(LocalTcpGroup, AllReduceRabenseifner) {
+    LocalGroupTest(TestAllReduceRabenseifner);
+}
+TEST(LocalTcpGroup, HierarchicalCollectives) {
+    LocalGroupTest(TestHierarchicalCollectives);
+}
 TEST(LocalTcpGroup, DispatcherSyncSendAsyncRead) {
     LocalGroupTest(TestDispatcherSyncSendAsyncRead);
 }
@@ -182,6 +200,9 @@ TEST(LocalTcpGroup, AllGatherMultiThreaded) {
 TEST(LocalTcpGroup, AllGatherString) {
     LocalGroupTest(TestAllGatherString);
 }
+TEST(LocalTcpGroup, MultiThreadAsyncCollectives) {
+    LocalGroupTest(TestMultiThreadAsyncCollectives);
+}
 // [[[end]]]
 
 /******************************************************************************/
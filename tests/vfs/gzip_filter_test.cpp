@@ -14,6 +14,7 @@
 #include <thrill/vfs/sys_file.hpp>
 #include <thrill/vfs/temporary_directory.hpp>
 
+#include <limits>
 #include <string>
 
 using namespace thrill;
@@ -68,4 +69,59 @@ TEST(GZipFilterTest, WriteReadSingleFile) {
     }
 }
 
+TEST(GZipFilterTest, BlockCompressedMembers) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/test.dat.gz";
+
+    std::string data;
+    for (size_t i = 0; i < 100000; ++i) {
+        data += "test" + std::to_string(i) + "\n";
+    }
+
+    {
+        vfs::WriteStreamPtr zs = vfs::MakeGZipBlockWriteFilter(
+            vfs::SysOpenWriteStream(path));
+        zs->write(data.data(), data.size());
+        zs->close();
+    }
+
+    ASSERT_TRUE(vfs::GZipIsBlockCompressed(vfs::SysOpenReadStream(path)));
+
+    // a plain gzip reader decompresses all members
+    {
+        vfs::ReadStreamPtr zs =
+            vfs::MakeGZipReadFilter(vfs::SysOpenReadStream(path));
+
+        std::string result(data.size() + 1, 0);
+        ASSERT_EQ(static_cast<ssize_t>(data.size()),
+                  zs->read(&result[0], result.size()));
+        result.resize(data.size());
+        ASSERT_EQ(data, result);
+    }
+
+    // decompress member-wise from the first member after an offset, which
+    // must yield a suffix of the data
+    for (uint64_t offset : { 0, 1, 1000, 30000 }) {
+        uint64_t member = vfs::GZipFindBlock(
+            vfs::SysOpenReadStream(path, common::Range(offset, 0)), offset);
+        ASSERT_NE(std::numeric_limits<uint64_t>::max(), member);
+        ASSERT_GE(member, offset);
+
+        vfs::MemberReadStreamPtr zs = vfs::MakeGZipMemberReadFilter(
+            vfs::SysOpenReadStream(path, common::Range(member, 0)), member);
+
+        std::string result;
+        char buffer[4096];
+        ssize_t rb;
+        while ((rb = zs->read(buffer, sizeof(buffer))) > 0) {
+            ASSERT_GE(zs->member_offset(), member);
+            result.append(buffer, rb);
+        }
+
+        ASSERT_LE(result.size(), data.size());
+        ASSERT_EQ(data.substr(data.size() - result.size()), result);
+        if (offset == 0) ASSERT_EQ(data, result);
+    }
+}
+
 /******************************************************************************/
@@ -11,12 +11,24 @@
 #include <thrill/vfs/sys_file.hpp>
 
 #include <gtest/gtest.h>
+#include <thrill/common/logger.hpp>
 #include <thrill/vfs/temporary_directory.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
 #include <string>
+#include <vector>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using namespace thrill;
 
+static constexpr bool debug = false;
+
 TEST(SysFileTest, WriteBinaryPatternFormatter) {
 
     std::string str1 = vfs::FillFilePattern("test-@@@@-########", 42, 10);
@@ -63,4 +75,70 @@ TEST(SysFileTest, WriteReadSingleFile) {
     }
 }
 
+#if !defined(_MSC_VER)
+
+TEST(SysFileTest, WriteReadDirectIO) {
+    vfs::TemporaryDirectory tmpdir;
+    std::string path = tmpdir.get() + "/direct.dat";
+
+    setenv("THRILL_DIRECT_IO", ("/nonexisting:" + tmpdir.get()).c_str(), 1);
+    ASSERT_TRUE(vfs::SysIsDirectIO(path));
+
+    // some file systems, e.g. tmpfs before Linux 6.6, reject O_DIRECT and the
+    // streams fall back to the page cache.
+    bool direct = false;
+#if defined(O_DIRECT)
+    {
+        std::string probe = tmpdir.get() + "/probe.dat";
+        int fd = ::open(probe.c_str(), O_CREAT | O_WRONLY, 0666);
+        ASSERT_GE(fd, 0);
+        direct = (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_DIRECT) == 0);
+        ::close(fd);
+        ::unlink(probe.c_str());
+    }
+#endif
+    LOG << "WriteReadDirectIO: testing "
+        << (direct ? "O_DIRECT" : "the page cache fallback")
+        << " in " << tmpdir.get();
+
+    // more than two buffers with an unaligned tail
+    std::vector<size_t> data(1500017);
+    std::iota(data.begin(), data.end(), 42);
+
+    const char* bytes = reinterpret_cast<const char*>(data.data());
+    size_t total = data.size() * sizeof(size_t);
+    {
+        vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(path);
+        ASSERT_EQ(direct, vfs::SysIsDirectStream(ws));
+        for (size_t off = 0; off < total; off += 100003)
+            ws->write(bytes + off, std::min<size_t>(100003, total - off));
+        ws->close();
+    }
+
+    // read from aligned and unaligned offsets
+    for (size_t skip : { 0, 1001, 524288 }) {
+        vfs::ReadStreamPtr rs = vfs::SysOpenReadStream(
+            path, common::Range(skip * sizeof(size_t), 0));
+        ASSERT_EQ(direct, vfs::SysIsDirectStream(rs));
+
+        std::vector<size_t> out(data.size() - skip);
+        char* out_bytes = reinterpret_cast<char*>(out.data());
+        size_t out_size = out.size() * sizeof(size_t), pos = 0;
+        ssize_t rb;
+        while ((rb = rs->read(out_bytes + pos, std::min<size_t>(
+                                  77777, out_size - pos + 1))) > 0) {
+            pos += rb;
+        }
+        ASSERT_EQ(0, rb);
+        ASSERT_EQ(out_size, pos);
+        ASSERT_TRUE(std::equal(out.begin(), out.end(), data.begin() + skip));
+        rs->close();
+    }
+
+    unsetenv("THRILL_DIRECT_IO");
+    ASSERT_FALSE(vfs::SysIsDirectIO(path));
+}
+
+#endif
+
 /******************************************************************************/
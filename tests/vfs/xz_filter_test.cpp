@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * tests/vfs/xz_filter_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/xz_filter.hpp>
+
+#include <gtest/gtest.h>
+#include <thrill/vfs/sys_file.hpp>
+#include <thrill/vfs/temporary_directory.hpp>
+
+#include <string>
+
+using namespace thrill;
+
+TEST(XZFilterTest, WriteReadSingleFile) {
+    vfs::TemporaryDirectory tmpdir;
+
+    {
+        vfs::WriteStreamPtr ws = vfs::SysOpenWriteStream(
+            tmpdir.get() + "/test.dat.xz");
+
+        vfs::WriteStreamPtr zs = vfs::MakeXZWriteFilter(ws);
+
+        std::string test_string("test123abc");
+        for (size_t i = 0; i < 100000; ++i) {
+            zs->write(test_string.data(), test_string.size());
+        }
+
+        for (size_t i = 0; i < 1000000; ++i) {
+            zs->write(&i, sizeof(i));
+        }
+
+        // put one more byte in
+        zs->write(test_string.data(), 1);
+
+        zs->close();
+    }
+    {
+        vfs::ReadStreamPtr rs = vfs::SysOpenReadStream(
+            tmpdir.get() + "/test.dat.xz");
+
+        vfs::ReadStreamPtr zs = vfs::MakeXZReadFilter(rs);
+
+        char buffer[10 + 1];
+        for (size_t i = 0; i < 100000; ++i) {
+            zs->read(buffer, 10);
+            buffer[10] = 0;
+            ASSERT_EQ(std::string(buffer), "test123abc");
+        }
+
+        for (size_t i = 0; i < 1000000; ++i) {
+            size_t r;
+            zs->read(&r, sizeof(r));
+            ASSERT_EQ(r, i);
+        }
+
+        // read beyond end-of-file
+        ssize_t rb = zs->read(buffer, 10);
+        ASSERT_EQ(rb, 1);
+
+        zs->close();
+    }
+}
+
+/******************************************************************************/
@@ -49,8 +49,14 @@ public:
                              PreOp(input);
                          };
 
+        auto pre_op_batch_fn = [this](const ValueType* items, size_t size) {
+                                   PreOpBatch(items, size);
+                               };
+
         auto lop_chain = parent.stack().push(pre_op_fn).fold();
-        parent.node()->AddChild(this, lop_chain);
+        parent.node()->AddChild(
+            this, lop_chain, 0,
+            FoldBatchChain(parent, lop_chain, pre_op_batch_fn));
     }
 
     void PreOp(const ValueType& input) {
@@ -63,6 +69,22 @@ public:
         }
     }
 
+    //! PreOp() for an array of items, reducing into a local variable.
+    void PreOpBatch(const ValueType* items, size_t size) {
+        if (size == 0) return;
+
+        size_t i = 0;
+        if (TLX_UNLIKELY(first_)) {
+            first_ = false;
+            sum_ = items[i++];
+        }
+
+        ValueType sum = sum_;
+        for ( ; i < size; ++i)
+            sum = reduce_function_(sum, items[i]);
+        sum_ = sum;
+    }
+
     //! Executes the sum operation.
     void Execute() final {
         // process the reduce
@@ -163,7 +163,8 @@ RunLoopbackThreads(
 
                     ctx.Launch(job_startpoint);
                 });
-            common::SetCpuAffinity(threads[id], core_offset + id);
+            host_contexts[host]->PinWorker(
+                threads[id], worker, core_offset + id);
         }
     }
 
@@ -201,6 +202,96 @@ static inline bool SetupBlockSize() {
     return true;
 }
 
+//! Parse THRILL_NET_STRIPES: number of parallel TCP connections to each peer
+//! host used for data streams. Returns 0 on error.
+static inline size_t FindNetStripes() {
+
+    const char* env_net_stripes = getenv("THRILL_NET_STRIPES");
+    if (env_net_stripes == nullptr || *env_net_stripes == 0) return 1;
+
+    char* endptr;
+    size_t net_stripes = std::strtoul(env_net_stripes, &endptr, 10);
+
+    if (endptr == nullptr || *endptr != 0 || net_stripes == 0) {
+        std::cerr << "Thrill: environment variable"
+                  << " THRILL_NET_STRIPES=" << env_net_stripes
+                  << " is not a valid number of connections per host."
+                  << std::endl;
+        return 0;
+    }
+
+    return net_stripes;
+}
+
+//! Parse THRILL_NET_DISPATCHERS: number of dispatcher threads among which the
+//! data connections are sharded. Returns 0 on error.
+static inline size_t FindNetDispatchers() {
+
+    const char* env_net_dispatchers = getenv("THRILL_NET_DISPATCHERS");
+    if (env_net_dispatchers == nullptr || *env_net_dispatchers == 0) return 1;
+
+    char* endptr;
+    size_t net_dispatchers = std::strtoul(env_net_dispatchers, &endptr, 10);
+
+    if (endptr == nullptr || *endptr != 0 || net_dispatchers == 0) {
+        std::cerr << "Thrill: environment variable"
+                  << " THRILL_NET_DISPATCHERS=" << env_net_dispatchers
+                  << " is not a valid number of dispatcher threads."
+                  << std::endl;
+        return 0;
+    }
+
+    return net_dispatchers;
+}
+
+//! Parse THRILL_HOST_RACKS: list of rack labels for each host rank, separated
+//! by spaces or commas, and apply it to the flow control group. Invalid values
+//! are reported and ignored.
+static inline void SetupHostRacks(net::Group& group) {
+
+    const char* env_host_racks = getenv("THRILL_HOST_RACKS");
+    if (env_host_racks == nullptr || *env_host_racks == 0) return;
+
+    // first try to split by spaces, then by commas
+    std::vector<std::string> list = tlx::split(' ', env_host_racks);
+    if (list.size() == 1)
+        tlx::split(&list, ',', env_host_racks);
+
+    // number racks in order of their first appearance
+    std::vector<std::string> labels;
+    std::vector<size_t> host_racks;
+    for (const std::string& label : list) {
+        if (label.empty()) continue;
+        size_t r = std::find(labels.begin(), labels.end(), label)
+                   - labels.begin();
+        if (r == labels.size()) labels.push_back(label);
+        host_racks.push_back(r);
+    }
+
+    if (host_racks.size() != group.num_hosts()) {
+        std::cerr << "Thrill: environment variable"
+                  << " THRILL_HOST_RACKS=" << env_host_racks
+                  << " must contain one rack for each of the "
+                  << group.num_hosts() << " hosts, ignoring it."
+                  << std::endl;
+        return;
+    }
+
+    if (!group.SetHostRacks(host_racks)) {
+        std::cerr << "Thrill: environment variable"
+                  << " THRILL_HOST_RACKS=" << env_host_racks
+                  << " is ignored, hosts of a rack must have consecutive"
+                  << " ranks."
+                  << std::endl;
+        return;
+    }
+
+    if (group.my_host_rank() == 0) {
+        std::cerr << "Thrill: using hierarchical collectives over "
+                  << group.num_racks() << " racks" << std::endl;
+    }
+}
+
 static inline size_t FindWorkersPerHost(
     const char*& str_workers_per_host, const char*& env_workers_per_host) {
 
@@ -581,6 +672,16 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
     if (workers_per_host == 0)
         return -1;
 
+    // determine number of parallel data connections per peer
+
+    size_t net_stripes = FindNetStripes();
+    if (net_stripes == 0)
+        return -1;
+
+    size_t net_dispatchers = FindNetDispatchers();
+    if (net_dispatchers == 0)
+        return -1;
+
     // detect memory config
 
     MemoryConfig mem_config;
@@ -591,6 +692,8 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
     std::cerr << "Thrill: running in tcp network with " << hostlist.size()
               << " hosts and " << workers_per_host << " workers per host"
+              << " and " << net_stripes << " data connections per host"
+              << " on " << net_dispatchers << " dispatcher threads"
               << " with " << common::GetHostname()
               << " as rank " << my_host_rank << " and endpoints";
     for (const std::string& ep : hostlist)
@@ -604,10 +707,15 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
     // construct three TCP network groups
     auto select_dispatcher = std::make_unique<net::tcp::SelectDispatcher>();
 
+    // the flow control group uses one connection, the data group is striped.
+    const size_t num_stripes[kGroupCount] = { 1, net_stripes };
+
     std::array<std::unique_ptr<net::tcp::Group>, kGroupCount> groups;
     net::tcp::Construct(
         *select_dispatcher, my_host_rank, hostlist,
-        groups.data(), net::Manager::kGroupCount);
+        groups.data(), net::Manager::kGroupCount, num_stripes);
+
+    SetupHostRacks(*groups[0]);
 
     std::array<net::GroupPtr, kGroupCount> host_groups = {
         { std::move(groups[0]), std::move(groups[1]) }
@@ -620,7 +728,8 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
     HostContext host_context(
         0, mem_config,
-        std::move(dispatcher), std::move(host_groups), workers_per_host);
+        std::move(dispatcher), std::move(host_groups), workers_per_host,
+        net_dispatchers);
 
     std::vector<std::thread> threads(workers_per_host);
 
@@ -632,7 +741,10 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        host_context.PinWorker(
+            threads[worker], worker,
+            common::NumaWorkerCpu(worker, workers_per_host,
+                                  host_context.num_dispatchers()));
     }
 
     // join worker threads
@@ -703,6 +815,8 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
     std::array<std::unique_ptr<net::mpi::Group>, kGroupCount> groups;
     net::mpi::Construct(num_hosts, *dispatcher, groups.data(), kGroupCount);
 
+    SetupHostRacks(*groups[0]);
+
     std::array<net::GroupPtr, kGroupCount> host_groups = {
         { std::move(groups[0]), std::move(groups[1]) }
     };
@@ -724,7 +838,10 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        host_context.PinWorker(
+            threads[worker], worker,
+            common::NumaWorkerCpu(worker, workers_per_host,
+                                  host_context.num_dispatchers()));
     }
 
     // join worker threads
@@ -798,7 +915,10 @@ int RunBackendIb(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        host_context.PinWorker(
+            threads[worker], worker,
+            common::NumaWorkerCpu(worker, workers_per_host,
+                                  host_context.num_dispatchers()));
     }
 
     // join worker threads
@@ -1071,9 +1191,63 @@ int MemoryConfig::setup_detect() {
         else {
             sLOG1 << "getrlimit(): " << strerror(errno);
         }
+
+        // honour the memory limit of the cgroup (e.g. of a container), but
+        // leave some room for the kernel's page cache and the runtime.
+        size_t cgroup_limit = common::LinuxCGroupMemoryLimit();
+        if (cgroup_limit != 0 && cgroup_limit * 7 / 8 < ram_) {
+            ram_ = cgroup_limit * 7 / 8;
+        }
 #endif
     }
 
+    // credit window of data streams
+
+    const char* env_net_credits = getenv("THRILL_NET_CREDITS");
+
+    if (env_net_credits != nullptr && *env_net_credits != 0) {
+        uint64_t credits64;
+        if (!tlx::parse_si_iec_units(env_net_credits, &credits64)) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_NET_CREDITS=" << env_net_credits
+                      << " is not a valid credit window size."
+                      << std::endl;
+            return -1;
+        }
+        net_credit_window_ = static_cast<size_t>(credits64);
+    }
+
+    const char* env_net_credit_delay = getenv("THRILL_NET_CREDIT_DELAY");
+
+    if (env_net_credit_delay != nullptr && *env_net_credit_delay != 0) {
+        char* endptr;
+        unsigned long delay = std::strtoul(env_net_credit_delay, &endptr, 10);
+        if (!endptr || *endptr != 0) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_NET_CREDIT_DELAY=" << env_net_credit_delay
+                      << " is not a valid number of milliseconds."
+                      << std::endl;
+            return -1;
+        }
+        net_credit_max_delay_ = std::chrono::milliseconds(delay);
+    }
+
+    // RAM for Blocks held compressed in the BlockPool
+
+    const char* env_ram_compressed = getenv("THRILL_RAM_COMPRESSED");
+
+    if (env_ram_compressed != nullptr && *env_ram_compressed != 0) {
+        uint64_t compressed64;
+        if (!tlx::parse_si_iec_units(env_ram_compressed, &compressed64)) {
+            std::cerr << "Thrill: environment variable"
+                      << " THRILL_RAM_COMPRESSED=" << env_ram_compressed
+                      << " is not a valid amount of RAM memory."
+                      << std::endl;
+            return -1;
+        }
+        ram_compressed_ = static_cast<size_t>(compressed64);
+    }
+
     apply();
 
     return 0;
@@ -1085,6 +1259,9 @@ void MemoryConfig::apply() {
     ram_workers_ = ram_ / 3;
     ram_block_pool_hard_ = ram_ / 3;
     ram_block_pool_soft_ = ram_block_pool_hard_ * 9 / 10;
+    ram_block_pool_compressed_ =
+        ram_compressed_ == size_t(-1) ? ram_block_pool_soft_ / 4
+        : std::min(ram_compressed_, ram_block_pool_soft_);
     ram_floating_ = ram_ - ram_block_pool_hard_ - ram_workers_;
 
     // set memory limit, only BlockPool is excluded from malloc tracking, as
@@ -1098,6 +1275,7 @@ MemoryConfig MemoryConfig::divide(size_t hosts) const {
     mc.ram_ /= hosts;
     mc.ram_block_pool_hard_ /= hosts;
     mc.ram_block_pool_soft_ /= hosts;
+    mc.ram_block_pool_compressed_ /= hosts;
     mc.ram_workers_ /= hosts;
     // free floating memory is not divided by host, as it is measured overall
 
@@ -1125,13 +1303,14 @@ HostContext::HostContext(
     const MemoryConfig& mem_config,
     std::unique_ptr<net::DispatcherThread> dispatcher,
     std::array<net::GroupPtr, net::Manager::kGroupCount>&& groups,
-    size_t workers_per_host)
+    size_t workers_per_host, size_t num_dispatchers)
     : mem_config_(mem_config),
       base_logger_(MakeHostLogPath(groups[0]->my_host_rank())),
       logger_(&base_logger_, "host_rank", groups[0]->my_host_rank()),
       profiler_(std::make_unique<common::ProfileThread>()),
       local_host_id_(local_host_id),
       workers_per_host_(workers_per_host),
+      num_dispatchers_(num_dispatchers),
       dispatcher_(std::move(dispatcher)),
       net_manager_(std::move(groups), logger_) {
 
@@ -1146,8 +1325,18 @@ HostContext::HostContext(
         mem::StartMemProfiler(*profiler_, logger_);
 }
 
+void HostContext::PinWorker(
+    std::thread& thread, size_t local_worker_id, size_t cpu_id) {
+    common::SetCpuAffinity(thread, cpu_id);
+    if (common::NumaNodes() > 1) {
+        block_pool_.SetWorkerNumaNode(
+            local_worker_id, common::NumaNodeOfCpu(cpu_id));
+    }
+}
+
 HostContext::~HostContext() {
-    // stop dispatcher _before_ stopping multiplexer
+    // stop dispatchers _before_ stopping multiplexer
+    data_multiplexer_.TerminateDispatchers();
     dispatcher_->Terminate();
 }
 
@@ -28,11 +28,13 @@
 #include <thrill/net/manager.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <numeric>
 #include <random>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -68,6 +70,12 @@ public:
     //! amount of RAM dedicated to data::BlockPool -- soft limit
     size_t ram_block_pool_soft_;
 
+    //! part of the BlockPool's RAM holding evicted Blocks compressed
+    size_t ram_block_pool_compressed_;
+
+    //! THRILL_RAM_COMPRESSED, or size_t(-1) for a quarter of the soft limit
+    size_t ram_compressed_ = size_t(-1);
+
     //! total amount of RAM for DIANode data structures such as the reduce
     //! tables. divide by the number of worker threads before use.
     size_t ram_workers_;
@@ -75,6 +83,14 @@ public:
     //! remaining free-floating RAM used for user and Thrill data structures.
     size_t ram_floating_;
 
+    //! credit window of data::Multiplexer streams, or THRILL_NET_CREDITS
+    size_t net_credit_window_ = data::Multiplexer::auto_credit_window;
+
+    //! maximum time data::Multiplexer withholds credit, or
+    //! THRILL_NET_CREDIT_DELAY
+    std::chrono::milliseconds net_credit_max_delay_ =
+        data::Multiplexer::default_credit_max_delay;
+
     //! StageBuilder verbosity flag
     bool verbose_ = true;
 
@@ -95,7 +111,7 @@ public:
     HostContext(size_t local_host_id, const MemoryConfig& mem_config,
                 std::unique_ptr<net::DispatcherThread> dispatcher,
                 std::array<net::GroupPtr, net::Manager::kGroupCount>&& groups,
-                size_t workers_per_host);
+                size_t workers_per_host, size_t num_dispatchers = 1);
 
     //! destructor
     ~HostContext();
@@ -108,12 +124,19 @@ public:
     //! create host log
     std::string MakeHostLogPath(size_t host_rank);
 
+    //! pin a worker thread to a cpu/core and let the BlockPool allocate its
+    //! Blocks on that cpu's NUMA node.
+    void PinWorker(std::thread& thread, size_t local_worker_id, size_t cpu_id);
+
     //! Returns local_host_id_
     size_t local_host_id() const { return local_host_id_; }
 
     //! number of workers per host (all have the same).
     size_t workers_per_host() const { return workers_per_host_; }
 
+    //! number of DispatcherThreads, which are pinned to the last cpus/cores.
+    size_t num_dispatchers() const { return num_dispatchers_; }
+
     //! memory limit of each worker Context for local data structures
     size_t worker_mem_limit() const {
         return mem_config_.ram_workers_ / workers_per_host_;
@@ -169,6 +192,9 @@ private:
     //! number of workers per host (all have the same).
     size_t workers_per_host_;
 
+    //! number of dispatcher threads serving the data multiplexer
+    size_t num_dispatchers_;
+
     //! host-global memory manager for internal memory only
     mem::Manager mem_manager_ { nullptr, "HostContext" };
 
@@ -193,7 +219,8 @@ private:
     //! data block pool
     data::BlockPool block_pool_ {
         mem_config_.ram_block_pool_soft_, mem_config_.ram_block_pool_hard_,
-        &logger_, &mem_manager_, workers_per_host_
+        &logger_, &mem_manager_, workers_per_host_,
+        mem_config_.ram_block_pool_compressed_
     };
 
 #if !THRILL_HAVE_THREAD_SANITIZER
@@ -206,7 +233,9 @@ private:
     //! data multiplexer transmits large amounts of data asynchronously.
     data::Multiplexer data_multiplexer_ {
         mem_manager_, block_pool_,
-        *dispatcher_, net_manager_.GetDataGroup(), workers_per_host_
+        *dispatcher_, net_manager_.GetDataGroup(), workers_per_host_,
+        num_dispatchers_, mem_config_.net_credit_window_,
+        mem_config_.net_credit_max_delay_
     };
 };
 
@@ -325,6 +354,33 @@ public:
 
     //! \}
 
+    //! \name Memory Broker of the current Stage
+    //! \{
+
+    //! Set the amount of memory which is not assigned to any DIANode of the
+    //! Stage which is about to push data. Called by the StageBuilder.
+    void set_stage_mem_available(size_t bytes) { stage_mem_available_ = bytes; }
+
+    //! Amount of memory currently held by the broker of the current Stage.
+    size_t stage_mem_available() const { return stage_mem_available_; }
+
+    //! Request bytes of additional memory from the broker of the current
+    //! Stage. Either grants the full amount and returns true, or nothing.
+    bool RequestStageMemory(size_t bytes) {
+        size_t avail = stage_mem_available_.load();
+        do {
+            if (avail < bytes) return false;
+        } while (!stage_mem_available_.compare_exchange_weak(
+                     avail, avail - bytes));
+        return true;
+    }
+
+    //! Return bytes of unused memory to the broker of the current Stage, where
+    //! other DIANodes of the Stage may request it.
+    void ReturnStageMemory(size_t bytes) { stage_mem_available_ += bytes; }
+
+    //! \}
+
     //! host-global memory config
     const MemoryConfig& mem_config() const { return mem_config_; }
 
@@ -390,6 +446,14 @@ public:
     //! Returns next_dia_id_ to generate DIA::id_ serial.
     size_t next_dia_id() { return ++last_dia_id_; }
 
+    //! Reserve numbers for the given number of Stages, returns the number
+    //! preceding the first. Used as BlockPool eviction hints.
+    size_t ReserveStages(size_t num_stages) {
+        size_t last = last_stage_;
+        last_stage_ += num_stages;
+        return last;
+    }
+
 private:
     //! id among all _local_ hosts (in test program runs)
     size_t local_host_id_;
@@ -427,6 +491,13 @@ private:
     //! the number of valid DIA ids. 0 is reserved for invalid.
     size_t last_dia_id_ = 0;
 
+    //! the number of Stages run or scheduled by the StageBuilder.
+    size_t last_stage_ = 0;
+
+    //! memory returned by DIANodes of the current Stage, which other DIANodes
+    //! of the Stage may request to grow their data structures.
+    std::atomic<size_t> stage_mem_available_ { 0 };
+
 public:
     //! \name Shared Objects
     //! \{
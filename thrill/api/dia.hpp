@@ -885,6 +885,45 @@ public:
         const std::string& filepath,
         size_t max_file_size = 128* 1024* 1024) const;
 
+    /*!
+     * WriteColumnar is a function, which writes a DIA of std::tuple items
+     * column-wise into one or more files per worker. Each file consists of
+     * row groups with min/max statistics of all arithmetic columns, which
+     * allow ReadColumnar to skip row groups and unneeded columns.
+     *
+     * \param filepath Destination of the output file, with the same
+     * `"$$$$$"` and `"#####"` placeholders as WriteBinary.
+     *
+     * \param row_group_size number of rows per row group.
+     *
+     * \param max_file_size size after which a new file is started.
+     *
+     * \ingroup dia_actions
+     */
+    void WriteColumnar(const std::string& filepath,
+                       size_t row_group_size = 128* 1024,
+                       size_t max_file_size = 128* 1024* 1024) const;
+
+    /*!
+     * WriteColumnar is a function, which writes a DIA of std::tuple items
+     * column-wise into one or more files per worker. Each file consists of
+     * row groups with min/max statistics of all arithmetic columns, which
+     * allow ReadColumnar to skip row groups and unneeded columns.
+     *
+     * \param filepath Destination of the output file, with the same
+     * `"$$$$$"` and `"#####"` placeholders as WriteBinary.
+     *
+     * \param row_group_size number of rows per row group.
+     *
+     * \param max_file_size size after which a new file is started.
+     *
+     * \ingroup dia_actions
+     */
+    Future<void> WriteColumnarFuture(
+        const std::string& filepath,
+        size_t row_group_size = 128* 1024,
+        size_t max_file_size = 128* 1024* 1024) const;
+
     //! \}
 
     /*!
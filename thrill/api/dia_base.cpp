@@ -223,9 +223,15 @@ public:
 
         // distribute remaining memory to nodes requesting maximum RAM amount
 
+        // memory not assigned to any DIANode is held by the Stage's memory
+        // broker. DIANodes return unused parts of their share to it, and
+        // others (e.g. reduce tables) request more instead of spilling.
+        size_t broker_mem = mem_limit - const_mem;
+
         if (!max_mem_nodes.empty()) {
             size_t remaining_mem = mem_limit - const_mem;
             remaining_mem /= max_mem_nodes.size();
+            broker_mem -= remaining_mem * max_mem_nodes.size();
 
             if (context_.my_rank() == 0) {
                 LOG << "StageBuilder: distribute remaining worker memory "
@@ -247,6 +253,8 @@ public:
         // old: acquire memory from BlockPool
         // data::BlockPoolMemoryHolder mem_holder(context_.block_pool(), const_mem);
 
+        context_.set_stage_mem_available(broker_mem);
+
         common::StatsTimerStart timer;
         try {
             node_->RunPushData();
@@ -255,11 +263,16 @@ public:
             LOG1 << "StageBuilder: caught exception from PushData()"
                  << " of stage " << *node_ << " targets " << TargetsString()
                  << " - what(): " << e.what();
+            context_.set_stage_mem_available(0);
             throw;
         }
         node_->RemoveAllChildren();
         timer.Stop();
 
+        LOG << "StageBuilder: memory broker holds "
+            << context_.stage_mem_available() << " bytes after PushData()";
+        context_.set_stage_mem_available(0);
+
         sLOG << "FINISH (PUSHDATA) stage" << *node_ << "targets" << TargetsString()
              << "took" << timer << "ms";
 
@@ -414,10 +427,21 @@ void DIABase::RunScope() {
 
     assert(toporder.front().node_.get() == this);
 
+    // pass the execution plan to the BlockPool as eviction hints: the data of
+    // each DIANode is used next when its Stage runs.
+    data::BlockPool& block_pool = context_.block_pool();
+    size_t stage = context_.ReserveStages(toporder.size());
+    for (size_t i = 0; i < toporder.size(); ++i) {
+        block_pool.SetNextUse(
+            toporder[toporder.size() - 1 - i].node_->dia_id(), stage + 1 + i);
+    }
+
     while (!toporder.empty())
     {
         Stage& s = toporder.back();
 
+        block_pool.AdvanceStage(++stage);
+
         if (s.node_->ForwardDataOnly()) {
             toporder.pop_back();
             continue;
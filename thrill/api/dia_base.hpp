@@ -18,6 +18,7 @@
 
 #include <thrill/api/context.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -285,6 +286,23 @@ public:
 
     void set_mem_limit(const DIAMemUse& mem_limit) { mem_limit_ = mem_limit; }
 
+    //! Request bytes of additional memory for the current execution stage
+    //! from the memory returned by other DIANodes of the Stage. Returns true
+    //! and raises mem_limit_ if the full amount was granted.
+    bool RequestMemory(size_t bytes) {
+        if (!context_.RequestStageMemory(bytes)) return false;
+        mem_limit_ = mem_limit_.limit() + bytes;
+        return true;
+    }
+
+    //! Return bytes of mem_limit_ which this DIANode will not use in the
+    //! current execution stage, such that other DIANodes may grow.
+    void ReturnMemory(size_t bytes) {
+        bytes = std::min(bytes, mem_limit_.limit());
+        mem_limit_ = mem_limit_.limit() - bytes;
+        context_.ReturnStageMemory(bytes);
+    }
+
 protected:
     //! \name Fixed DIA Information
     //! \{
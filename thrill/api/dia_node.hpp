@@ -13,11 +13,13 @@
 #define THRILL_API_DIA_NODE_HEADER
 
 #include <thrill/api/dia_base.hpp>
+#include <thrill/common/span.hpp>
 #include <thrill/data/file.hpp>
 #include <tlx/delegate.hpp>
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -39,15 +41,21 @@ class DIANode : public DIABase
 public:
     using Callback = tlx::delegate<void (const ValueType&)>;
 
+    //! callback invoked with arrays of items, see FoldBatchChain()
+    using BatchCallback = tlx::delegate<void (const ValueType*, size_t)>;
+
     struct Child {
         //! reference to child node
-        DIABase  * node;
+        DIABase       * node;
         //! callback to invoke (currently for each item)
-        Callback callback;
+        Callback      callback;
         //! index this node has among the parents of the child (passed to
         //! callbacks), e.g. for ZipNode which has multiple parents and their order
         //! is important.
-        size_t   parent_index;
+        size_t        parent_index;
+        //! optional callback to invoke for arrays of items, which is equivalent
+        //! to calling callback for each item.
+        BatchCallback batch_callback;
     };
 
     /*!
@@ -74,8 +82,10 @@ public:
      * children. This procedure enables the minimization of IO-accesses.
      */
     virtual void AddChild(DIABase* node, const Callback& callback = Callback(),
-                          size_t parent_index = 0) {
-        children_.emplace_back(Child { node, callback, parent_index });
+                          size_t parent_index = 0,
+                          const BatchCallback& batch_callback = BatchCallback()) {
+        children_.emplace_back(
+            Child { node, callback, parent_index, batch_callback });
     }
 
     //! Remove a child from the vector of children. This method is called by the
@@ -165,22 +175,96 @@ public:
 
         if (nonfile_children.size() == 0) return;
 
-        // push into remaining which have a function stack or no direct File*
+        // push into remaining which have a function stack or no direct File*,
+        // items serialized as raw bytes are pushed in place from the Blocks.
         data::File::Reader reader = file.GetReader(consume);
-        while (reader.HasNext()) {
-            ValueType item = reader.Next<ValueType>();
-            for (const Child& child : nonfile_children) {
-                if (child.callback)
-                    child.callback(item);
-            }
-        }
+        PushReader(reader, nonfile_children,
+                   data::is_raw_serialized<ValueType>());
     }
 
 protected:
     //! Callback functions from the child nodes.
     std::vector<Child> children_;
+
+private:
+    //! push items serialized as raw bytes as arrays directly from the Blocks,
+    //! to the children's batch callbacks if they have one.
+    template <typename Reader>
+    void PushReader(Reader& reader, const std::vector<Child>& children,
+                    std::true_type /* raw */) const {
+        while (reader.HasNext()) {
+            common::Span<const ValueType> span =
+                reader.template NextSpan<ValueType>();
+            if (TLX_UNLIKELY(span.empty())) {
+                ValueType item = reader.template Next<ValueType>();
+                for (const Child& child : children) {
+                    if (child.callback)
+                        child.callback(item);
+                }
+                continue;
+            }
+            for (const Child& child : children) {
+                if (child.batch_callback) {
+                    child.batch_callback(span.data(), span.size());
+                }
+                else if (child.callback) {
+                    for (const ValueType& item : span)
+                        child.callback(item);
+                }
+            }
+        }
+    }
+
+    //! push all other items one at a time, std::string items without
+    //! allocating each, see BlockReader::ForEach().
+    template <typename Reader>
+    void PushReader(Reader& reader, const std::vector<Child>& children,
+                    std::false_type /* raw */) const {
+        reader.template ForEach<ValueType>(
+            [&children](const ValueType& item) {
+                for (const Child& child : children) {
+                    if (child.callback)
+                        child.callback(item);
+                }
+            });
+    }
 };
 
+//! FoldBatchChainImpl() for an empty function stack: call the DOp directly.
+template <typename Input, typename Chain, typename BatchFunction>
+BatchFunction FoldBatchChainImpl(const Chain& /* lop_chain */,
+                                 const BatchFunction& pre_op_batch_fn,
+                                 std::true_type /* stack_empty */) {
+    return pre_op_batch_fn;
+}
+
+//! FoldBatchChainImpl() for a non-empty function stack: loop over lop_chain.
+template <typename Input, typename Chain, typename BatchFunction>
+auto FoldBatchChainImpl(const Chain& lop_chain,
+                        const BatchFunction& /* pre_op_batch_fn */,
+                        std::false_type /* stack_empty */) {
+    return [lop_chain](const Input* items, size_t size) {
+               for (size_t i = 0; i < size; ++i)
+                   lop_chain(items[i]);
+           };
+}
+
+/*!
+ * Construct the batch callback of a DOp for AddChild(). If the LOp function
+ * stack of the parent DIA is empty, this is simply pre_op_batch_fn, which the
+ * DOp implements as a tight loop over arrays of items. Otherwise, the folded
+ * function chain lop_chain is run in a loop over each array, which calls into
+ * the delegate only once per array and lets the compiler inline the Map/Filter
+ * lambdas into the loop.
+ */
+template <typename ParentDIA, typename Chain, typename BatchFunction>
+auto FoldBatchChain(const ParentDIA& /* parent */, const Chain& lop_chain,
+                    const BatchFunction& pre_op_batch_fn) {
+    return FoldBatchChainImpl<typename ParentDIA::StackInput>(
+        lop_chain, pre_op_batch_fn,
+        std::integral_constant<bool, ParentDIA::stack_empty>());
+}
+
 //! \}
 
 } // namespace api
@@ -18,8 +18,10 @@
 #include <thrill/api/source_node.hpp>
 #include <thrill/common/item_serialization_tools.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_reader.hpp>
+#include <thrill/data/mapped_file.hpp>
 #include <thrill/net/buffer_builder.hpp>
 #include <thrill/vfs/file_io.hpp>
 
@@ -49,6 +51,9 @@ class ReadBinaryNode final : public SourceNode<ValueType>
     //! for testing old method of pushing items instead of PushFile().
     static constexpr bool debug_no_extfile = false;
 
+    //! for testing reading mapped Blocks using the io layer instead of mmap().
+    static constexpr bool debug_no_mmap = false;
+
 private:
     class VfsFileBlockSource;
 
@@ -145,18 +150,26 @@ public:
 
                 if (fi.range.begin == fi.range.end) continue;
 
-                if (files.contains_remote_uri || debug_no_extfile) {
+                if (files.contains_remote_uri || debug_no_extfile ||
+                    vfs::IsDirectIO(fi.path)) {
                     // push file and range into file list for remote files
-                    // (these cannot be mapped using the io layer)
+                    // (these cannot be mapped using the io layer), and for
+                    // files read with direct I/O bypassing the page cache.
                     my_files_.push_back(fi);
                 }
                 else {
-                    // new method: map blocks into a File using io layer
+                    // new method: map blocks into a File, preferably pointing
+                    // directly into a memory mapping of the file, otherwise
+                    // reading them using the io layer.
+
+                    data::MappedFilePtr mapped = MapFile(fi);
 
-                    foxxll::file_ptr file =
-                        tlx::make_counting<foxxll::syscall_file>(
+                    foxxll::file_ptr file;
+                    if (!mapped) {
+                        file = tlx::make_counting<foxxll::syscall_file>(
                             fi.path,
                             foxxll::file::RDONLY | foxxll::file::NO_LOCK);
+                    }
 
                     size_t item_off = 0;
 
@@ -167,7 +180,9 @@ public:
                             off + data::default_block_size, fi.range.end) - off;
 
                         data::ByteBlockPtr bbp =
-                            context_.block_pool().MapExternalBlock(
+                            mapped ? context_.block_pool().MapMappedBlock(
+                                mapped, off, bsize)
+                            : context_.block_pool().MapExternalBlock(
                                 file, off, bsize);
 
                         size_t item_num =
@@ -270,6 +285,20 @@ private:
     size_t stats_total_bytes = 0;
     size_t stats_total_reads = 0;
 
+    //! memory map the range of a local file, returns nullptr if mapping is not
+    //! supported or fails.
+    static data::MappedFilePtr MapFile(const FileInfo& fi) {
+        if (debug_no_mmap || !data::MappedFile::supported())
+            return data::MappedFilePtr();
+        try {
+            return tlx::make_counting<data::MappedFile>(fi.path, fi.range);
+        }
+        catch (const common::ErrnoException& e) {
+            LOG1 << "ReadBinary: " << e.what() << ", reading file instead.";
+            return data::MappedFilePtr();
+        }
+    }
+
     class VfsFileBlockSource
     {
     public:
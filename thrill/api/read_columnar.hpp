@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * thrill/api/read_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_READ_COLUMNAR_HEADER
+#define THRILL_API_READ_COLUMNAR_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/source_node.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+#include <thrill/data/columnar_format.hpp>
+#include <thrill/net/buffer_reader.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <tlx/string/join.hpp>
+#include <tlx/vector_free.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! Selection of the columns to read in ReadColumnar(), in output order.
+template <size_t... Indexes>
+struct ColumnSelect { };
+
+//! Row group predicate of ReadColumnar() which reads all row groups.
+struct ColumnarAllRowGroups {
+    template <typename Stats>
+    bool operator () (const Stats&) const { return true; }
+};
+
+/*!
+ * A DIANode which reads the columns Indexes of columnar files written by
+ * WriteColumnar() with items of type Schema. Row groups are distributed among
+ * the workers by their byte offset, and each worker reads only the footers of
+ * its files, and only the row groups for which the predicate holds on their
+ * statistics.
+ *
+ * \ingroup api_layer
+ */
+template <typename Schema, typename RowGroupPredicate, size_t... Indexes>
+class ReadColumnarNode final
+    : public SourceNode<
+          std::tuple<typename std::tuple_element<Indexes, Schema>::type...> >
+{
+    static constexpr bool debug = false;
+
+public:
+    using ValueType =
+        std::tuple<typename std::tuple_element<Indexes, Schema>::type...>;
+    using Super = SourceNode<ValueType>;
+    using Super::context_;
+
+    ReadColumnarNode(Context& ctx, const std::vector<std::string>& globlist,
+                     const RowGroupPredicate& predicate)
+        : Super(ctx, "ReadColumnar") {
+
+        vfs::FileList files = vfs::Glob(globlist, vfs::GlobType::File);
+
+        if (files.size() == 0)
+            die("ReadColumnar: no files found in globs: " + tlx::join(' ', globlist));
+        if (files.contains_compressed)
+            die("ReadColumnar: columnar files cannot be compressed.");
+
+        common::Range my_range = context_.CalculateLocalRange(files.total_size);
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            // read the footers of files with row groups starting in my_range
+            if (files.size_inc_psum(i) <= my_range.begin ||
+                files.size_ex_psum(i) >= my_range.end) continue;
+
+            data::ColumnarFooter footer = ReadFooter(files[i]);
+
+            for (const data::ColumnarRowGroup& rg : footer.row_groups) {
+                uint64_t pos = files.size_ex_psum(i) + rg.offset();
+                if (pos < my_range.begin || pos >= my_range.end) continue;
+
+                if (!predicate(data::ColumnarStats<Schema>(rg))) {
+                    stats_skipped_row_groups_++;
+                    continue;
+                }
+                row_groups_.emplace_back(RowGroup { files[i].path, rg });
+            }
+        }
+
+        sLOG << "ReadColumnar:" << row_groups_.size() << "row groups,"
+             << stats_skipped_row_groups_ << "skipped,"
+             << "my_range" << my_range;
+    }
+
+    DIAMemUse PushDataMemUse() final {
+        // the decoded column chunks of a row group and the raw bytes of one
+        // chunk are buffered.
+        size_t row_bytes = 0;
+        using Expander = int[];
+        (void)Expander {
+            (row_bytes +=
+                 sizeof(typename std::tuple_element<Indexes, Schema>::type),
+             0) ...
+        };
+
+        uint64_t mem_use = 0;
+        for (const RowGroup& rg : row_groups_) {
+            uint64_t max_chunk = 0;
+            for (size_t i : std::initializer_list<size_t>{ Indexes... })
+                max_chunk = std::max(max_chunk, rg.info.chunks[i].size);
+            mem_use = std::max(
+                mem_use, rg.info.num_rows * row_bytes + max_chunk);
+        }
+        return static_cast<size_t>(mem_use);
+    }
+
+    void PushData(bool /* consume */) final {
+        std::tuple<
+            std::vector<typename std::tuple_element<Indexes, Schema>::type>...>
+        columns;
+        std::vector<unsigned char> buffer;
+
+        for (const RowGroup& rg : row_groups_) {
+            ReadChunks(rg, columns, buffer,
+                       std::make_index_sequence<sizeof ... (Indexes)>());
+
+            for (size_t r = 0; r < rg.info.num_rows; ++r) {
+                PushRow(columns, r,
+                        std::make_index_sequence<sizeof ... (Indexes)>());
+            }
+        }
+
+        Super::logger_
+            << "class" << "ReadColumnarNode"
+            << "event" << "done"
+            << "total_row_groups" << row_groups_.size()
+            << "skipped_row_groups" << stats_skipped_row_groups_
+            << "total_bytes" << stats_total_bytes_;
+    }
+
+    void Dispose() final {
+        tlx::vector_free(row_groups_);
+    }
+
+private:
+    //! a row group to read
+    struct RowGroup {
+        std::string            path;
+        data::ColumnarRowGroup info;
+    };
+
+    //! row groups of this worker
+    std::vector<RowGroup> row_groups_;
+
+    size_t stats_skipped_row_groups_ = 0;
+    size_t stats_total_bytes_ = 0;
+
+    //! read size bytes at offset of the file at path into out
+    void ReadRange(const std::string& path, uint64_t offset, size_t size,
+                   unsigned char* out) {
+        vfs::ReadStreamPtr stream = vfs::OpenReadStream(
+            path, common::Range(offset, offset + size));
+
+        size_t pos = 0;
+        while (pos < size) {
+            ssize_t rb = stream->read(out + pos, size - pos);
+            if (rb < 0)
+                throw common::ErrnoException("Error reading vfs file");
+            if (rb == 0)
+                die("ReadColumnar: unexpected end of file " << path);
+            pos += rb;
+        }
+        stream->close();
+        stats_total_bytes_ += size;
+    }
+
+    //! read and check the footer of a columnar file
+    data::ColumnarFooter ReadFooter(const vfs::FileInfo& file) {
+        if (file.size < sizeof(data::columnar_magic) +
+            data::columnar_trailer_size)
+            die("ReadColumnar: " << file.path << " is not a columnar file.");
+
+        unsigned char trailer[data::columnar_trailer_size];
+        ReadRange(file.path, file.size - sizeof(trailer), sizeof(trailer),
+                  trailer);
+
+        if (std::memcmp(trailer + sizeof(uint64_t), data::columnar_magic,
+                        sizeof(data::columnar_magic)) != 0)
+            die("ReadColumnar: " << file.path << " is not a columnar file.");
+
+        uint64_t footer_size = 0;
+        for (size_t i = 0; i < sizeof(footer_size); ++i)
+            footer_size |= static_cast<uint64_t>(trailer[i]) << (8 * i);
+
+        if (footer_size > file.size - sizeof(trailer))
+            die("ReadColumnar: " << file.path << " has an invalid footer.");
+
+        std::vector<unsigned char> buffer(footer_size);
+        ReadRange(file.path, file.size - sizeof(trailer) - footer_size,
+                  footer_size, buffer.data());
+
+        net::BufferReader br(buffer.data(), buffer.size());
+        data::ColumnarFooter footer = data::ColumnarFooter::Deserialize(br);
+
+        if (!footer.MatchesSchema<Schema>())
+            die("ReadColumnar: columns of " << file.path <<
+                " do not match the requested tuple type.");
+
+        return footer;
+    }
+
+    template <typename Columns, size_t... Ks>
+    void ReadChunks(const RowGroup& rg, Columns& columns,
+                    std::vector<unsigned char>& buffer,
+                    std::index_sequence<Ks...>) {
+        using Expander = int[];
+        (void)Expander {
+            (ReadChunk(rg, rg.info.chunks[Indexes], buffer,
+                       std::get<Ks>(columns)), 0) ...
+        };
+    }
+
+    template <typename T>
+    void ReadChunk(const RowGroup& rg, const data::ColumnChunkInfo& chunk,
+                   std::vector<unsigned char>& buffer, std::vector<T>& values) {
+        buffer.resize(chunk.size);
+        ReadRange(rg.path, chunk.offset, chunk.size, buffer.data());
+
+        net::BufferReader br(buffer.data(), buffer.size());
+        data::DecodeColumnChunk(br, rg.info.num_rows, values);
+    }
+
+    template <typename Columns, size_t... Ks>
+    void PushRow(const Columns& columns, size_t r, std::index_sequence<Ks...>) {
+        this->PushItem(ValueType(std::get<Ks>(columns)[r] ...));
+    }
+};
+
+/*!
+ * ReadColumnar is a DOp, which reads the selected columns of files written by
+ * WriteColumnar with items of type Schema, and creates a DIA of tuples of the
+ * selected columns. Row groups for which the predicate returns false on their
+ * data::ColumnarStats are skipped without reading them, hence the predicate
+ * must only return false if no row of the group is needed.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ * \param predicate Row group predicate, called with data::ColumnarStats<Schema>
+ *
+ * \ingroup dia_sources
+ */
+template <typename Schema, size_t... Indexes,
+          typename RowGroupPredicate = ColumnarAllRowGroups>
+DIA<std::tuple<typename std::tuple_element<Indexes, Schema>::type...> >
+ReadColumnar(Context& ctx, const std::string& filepath,
+             ColumnSelect<Indexes...>,
+             const RowGroupPredicate& predicate = RowGroupPredicate()) {
+
+    using ReadColumnarNode =
+        api::ReadColumnarNode<Schema, RowGroupPredicate, Indexes...>;
+    using ValueType = typename ReadColumnarNode::ValueType;
+
+    auto node = tlx::make_counting<ReadColumnarNode>(
+        ctx, std::vector<std::string>{ filepath }, predicate);
+
+    return DIA<ValueType>(node);
+}
+
+//! ReadColumnar() of all columns.
+template <typename Schema, typename RowGroupPredicate, size_t... Indexes>
+DIA<Schema> ReadColumnarAll(
+    Context& ctx, const std::string& filepath,
+    const RowGroupPredicate& predicate, std::index_sequence<Indexes...>) {
+    return ReadColumnar<Schema>(
+        ctx, filepath, ColumnSelect<Indexes...>(), predicate);
+}
+
+/*!
+ * ReadColumnar is a DOp, which reads files written by WriteColumnar with items
+ * of type Schema and creates a DIA. Row groups for which the predicate returns
+ * false on their data::ColumnarStats are skipped without reading them, hence
+ * the predicate must only return false if no row of the group is needed.
+ *
+ * \param ctx Reference to the context object
+ * \param filepath Path of the files in the file system
+ * \param predicate Row group predicate, called with data::ColumnarStats<Schema>
+ *
+ * \ingroup dia_sources
+ */
+template <typename Schema, typename RowGroupPredicate = ColumnarAllRowGroups>
+DIA<Schema> ReadColumnar(
+    Context& ctx, const std::string& filepath,
+    const RowGroupPredicate& predicate = RowGroupPredicate()) {
+    return ReadColumnarAll<Schema>(
+        ctx, filepath, predicate,
+        std::make_index_sequence<std::tuple_size<Schema>::value>());
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::ColumnSelect;
+
+//! imported from api namespace
+using api::ReadColumnar;
+
+} // namespace thrill
+
+#endif // !THRILL_API_READ_COLUMNAR_HEADER
+
+/******************************************************************************/
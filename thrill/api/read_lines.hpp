@@ -25,6 +25,8 @@
 
 #include <tlx/string/join.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -36,6 +38,10 @@ namespace api {
  * A DIANode which performs a line-based Read operation. Reads a file from the
  * file system and delivers it as a DIA.
  *
+ * Uncompressed files and block compressed gzip files (BGZF, e.g. from bgzip)
+ * are split among all workers. Any other compressed file is read by a single
+ * worker.
+ *
  * \ingroup api_layer
  */
 class ReadLinesNode final : public SourceNode<std::string>
@@ -57,6 +63,16 @@ public:
         if (filelist_.size() == 0)
             die("ReadLines: no files found in globs: " + tlx::join(' ', globlist));
 
+        // compressed files can be split among workers only if all are
+        // splittable, otherwise each is read by a single worker.
+        splittable_ = true;
+        for (const vfs::FileInfo& fi : filelist_) {
+            if (fi.IsCompressed() && !vfs::IsSplittableCompressed(fi.path)) {
+                splittable_ = false;
+                break;
+            }
+        }
+
         sLOG << "ReadLines: creating for" << globlist.size() << "globs"
              << "matching" << filelist_.size() << "files";
     }
@@ -72,7 +88,16 @@ public:
     }
 
     void PushData(bool /* consume */) final {
-        if (filelist_.contains_compressed) {
+        if (filelist_.contains_compressed && splittable_) {
+            InputLineIteratorSplittable it(
+                filelist_, *this, local_storage_);
+
+            // Hook Read
+            while (it.HasNext()) {
+                this->PushItem(it.Next());
+            }
+        }
+        else if (filelist_.contains_compressed) {
             InputLineIteratorCompressed it(
                 filelist_, *this, local_storage_);
 
@@ -99,6 +124,9 @@ private:
     //! system.
     bool local_storage_;
 
+    //! true, if all compressed files can be split at member boundaries.
+    bool splittable_;
+
     class InputLineIterator
     {
     public:
@@ -140,6 +168,45 @@ private:
         size_t total_reads_ = 0;
         size_t total_elements_ = 0;
 
+        /*!
+         * Append the bytes up to the next newline in the buffer to data_ and
+         * skip the newline. Returns false if the buffer contains no newline,
+         * then all remaining bytes were appended. The newline is found with
+         * memchr(), which the C library implements with SIMD instructions.
+         */
+        bool AppendLine() {
+            unsigned char* end = buffer_.end();
+            if (TLX_UNLIKELY(current_ >= end)) return false;
+
+            unsigned char* newline = static_cast<unsigned char*>(
+                std::memchr(current_, '\n', end - current_));
+
+            if (TLX_UNLIKELY(newline == nullptr)) {
+                data_.append(reinterpret_cast<const char*>(current_),
+                             end - current_);
+                current_ = end;
+                return false;
+            }
+
+            data_.append(reinterpret_cast<const char*>(current_),
+                         newline - current_);
+            current_ = newline + 1;
+            return true;
+        }
+
+        //! Skip the bytes up to and including the next newline in the buffer.
+        //! Returns false if the buffer contains no newline.
+        bool SkipLine() {
+            unsigned char* end = buffer_.end();
+            if (TLX_UNLIKELY(current_ >= end)) return false;
+
+            unsigned char* newline = static_cast<unsigned char*>(
+                std::memchr(current_, '\n', end - current_));
+
+            current_ = newline ? newline + 1 : end;
+            return newline != nullptr;
+        }
+
         bool ReadBlock(vfs::ReadStreamPtr& file,
                        net::BufferBuilder& buffer) {
             read_timer.Start();
@@ -214,12 +281,7 @@ private:
                 // find next newline, discard all previous data as previous
                 // worker already covers it
                 while (!found_n) {
-                    while (current_ < buffer_.end()) {
-                        if (TLX_UNLIKELY(*current_++ == '\n')) {
-                            found_n = true;
-                            break;
-                        }
-                    }
+                    found_n = SkipLine();
                     // no newline found: read new data into buffer_builder
                     if (!found_n) {
                         offset_ += buffer_.size();
@@ -240,15 +302,9 @@ private:
             total_elements_++;
             data_.clear();
             while (true) {
-                while (TLX_LIKELY(current_ < buffer_.end())) {
-                    if (TLX_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
-                }
+                if (TLX_LIKELY(AppendLine()))
+                    return data_;
+
                 offset_ += buffer_.size();
                 if (!ReadBlock(stream_, buffer_)) {
                     LOG << "ReadLines: opening next file";
@@ -362,15 +418,8 @@ private:
             total_elements_++;
             data_.clear();
             while (true) {
-                while (current_ < buffer_.end()) {
-                    if (TLX_UNLIKELY(*current_ == '\n')) {
-                        current_++;
-                        return data_;
-                    }
-                    else {
-                        data_.push_back(*current_++);
-                    }
-                }
+                if (TLX_LIKELY(AppendLine()))
+                    return data_;
 
                 if (!ReadBlock(stream_, buffer_)) {
                     LOG << "ReadLines: opening new compressed file!";
@@ -438,6 +487,184 @@ private:
         //! File handle to files_[file_nr_]
         vfs::ReadStreamPtr stream_;
     };
+
+    /*!
+     * InputLineIterator for lists of uncompressed and splittable compressed
+     * files, which splits all files among the workers. Each byte of a file has
+     * a position: its offset for uncompressed files, and the offset of its
+     * member for compressed files. A worker emits all lines whose preceding
+     * newline has a position in its range, plus the first line of a file
+     * starting in its range.
+     */
+    class InputLineIteratorSplittable : public InputLineIterator
+    {
+    public:
+        //! Creates an instance of iterator that reads file line based
+        InputLineIteratorSplittable(const vfs::FileList& files,
+                                    ReadLinesNode& node, bool local_storage)
+            : InputLineIterator(files, node) {
+
+            // Go to start of 'local part'.
+            if (local_storage) {
+                my_range_ = node_.context_.CalculateLocalRangeOnHost(
+                    files.total_size);
+            }
+            else {
+                my_range_ = node_.context_.CalculateLocalRange(
+                    files.total_size);
+            }
+
+            file_nr_ = 0;
+            buffer_.Reserve(read_size);
+            data_.reserve(4 * 1024);
+
+            if (my_range_.begin >= my_range_.end) {
+                file_nr_ = files_.size();
+                return;
+            }
+
+            while (files_[file_nr_].size_inc_psum() <= my_range_.begin) {
+                file_nr_++;
+            }
+
+            OpenFile();
+        }
+
+        //! returns the next element if one exists
+        //!
+        //! does no checks whether a next element exists!
+        const std::string& Next() {
+            total_elements_++;
+            data_.clear();
+            at_file_begin_ = false;
+            while (true) {
+                if (TLX_LIKELY(AppendLine())) {
+                    last_newline_ = Position(current_ - 1);
+                    return data_;
+                }
+                if (!ReadChunk()) {
+                    // EOF = newline per definition
+                    file_done_ = true;
+                    return data_;
+                }
+            }
+        }
+
+        //! returns true, if an element is available in local part
+        bool HasNext() {
+            while (file_nr_ < files_.size()) {
+                if (!file_done_) {
+                    if (current_ >= buffer_.end() && !ReadChunk()) {
+                        file_done_ = true;
+                    }
+                    else if (at_file_begin_ ? local_end_ != 0
+                             : last_newline_ < local_end_) {
+                        return true;
+                    }
+                    else {
+                        // the remaining lines belong to the next worker
+                        file_done_ = true;
+                    }
+                }
+
+                if (stream_) stream_->close();
+                ++file_nr_;
+
+                if (files_.size_ex_psum(file_nr_) >= my_range_.end) {
+                    file_nr_ = files_.size();
+                    return false;
+                }
+
+                OpenFile();
+            }
+            return false;
+        }
+
+    private:
+        //! File handle to files_[file_nr_]
+        vfs::ReadStreamPtr stream_;
+        //! Member-wise file handle if files_[file_nr_] is compressed
+        vfs::MemberReadStreamPtr member_stream_;
+        //! Position of the current block, if the file is uncompressed
+        uint64_t chunk_offset_;
+        //! Position of the next block, if the file is uncompressed
+        uint64_t next_offset_;
+        //! local end of my_range_ in the current file
+        uint64_t local_end_;
+        //! Position of the newline preceding the next line
+        uint64_t last_newline_;
+        //! whether the next line is the first line of the file
+        bool at_file_begin_;
+        //! whether no more lines of the current file are read
+        bool file_done_;
+
+        //! open files_[file_nr_] at the local begin of my_range_ and skip the
+        //! partial line, which is emitted by the previous worker.
+        void OpenFile() {
+            const vfs::FileInfo& fi = files_[file_nr_];
+            uint64_t base = fi.size_ex_psum;
+            uint64_t local_begin = std::max<uint64_t>(my_range_.begin, base);
+            local_begin -= base;
+            local_end_ = std::min<uint64_t>(my_range_.end, base + fi.size);
+            local_end_ -= base;
+
+            sLOG << "ReadLines: opening splittable file" << file_nr_
+                 << "local range" << local_begin << local_end_;
+
+            if (fi.IsCompressed()) {
+                member_stream_ = vfs::OpenMemberReadStream(
+                    fi.path, local_begin);
+                stream_ = member_stream_;
+            }
+            else {
+                member_stream_ = vfs::MemberReadStreamPtr();
+                stream_ = vfs::OpenReadStream(
+                    fi.path, common::Range(local_begin, 0));
+            }
+
+            next_offset_ = local_begin;
+            last_newline_ = local_begin;
+            at_file_begin_ = (local_begin == 0);
+            buffer_.set_size(0);
+            current_ = buffer_.begin();
+
+            if (!stream_) {
+                // no member starts in or after the local range
+                file_done_ = true;
+                return;
+            }
+
+            file_done_ = !ReadChunk();
+
+            if (!file_done_ && !at_file_begin_) {
+                while (true) {
+                    if (SkipLine()) {
+                        last_newline_ = Position(current_ - 1);
+                        break;
+                    }
+                    if (!ReadChunk()) {
+                        file_done_ = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        //! read next block of the current file
+        bool ReadChunk() {
+            chunk_offset_ = next_offset_;
+            bool more = ReadBlock(stream_, buffer_);
+            next_offset_ += buffer_.size();
+            return more;
+        }
+
+        //! position of a byte in the current block
+        uint64_t Position(const unsigned char* p) const {
+            if (member_stream_)
+                return member_stream_->member_offset();
+            return chunk_offset_ + (p - buffer_.begin());
+        }
+    };
 };
 
 /*!
@@ -18,6 +18,8 @@
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <future>
 #include <vector>
 
 namespace thrill {
@@ -62,6 +64,13 @@ public:
     void StopPreOp(size_t /* parent_index */) final {
         // Push local elements to children
         writer_.Close();
+
+        // start the prefix sum of the local sizes, which is communicated while
+        // the parent pushes to further children and until Execute().
+        size_t local_size = file_.num_items();
+        local_rank_ = context_.net.PrefixSumAsync(
+            local_size, std::plus<size_t>(), size_t(0), /* inclusive */ false);
+        global_size_ = context_.net.AllReduceAsync(local_size);
     }
 
     //! Executes the rebalance operation.
@@ -72,8 +81,8 @@ public:
         local_size = file_.num_items();
         sLOG << "local_size" << local_size;
 
-        size_t local_rank = local_size;
-        size_t global_size = context_.net.ExPrefixSumTotal(local_rank);
+        size_t local_rank = local_rank_.get();
+        size_t global_size = global_size_.get();
         sLOG << "local_rank" << local_rank;
         sLOG << "global_size" << global_size;
 
@@ -116,6 +125,10 @@ private:
 
     //! CatStream for exchange
     data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+
+    //! exclusive prefix sum and total of the local sizes, started in
+    //! StopPreOp().
+    std::shared_future<size_t> local_rank_, global_size_;
 };
 
 template <typename ValueType, typename Stack>
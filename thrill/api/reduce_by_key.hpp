@@ -127,10 +127,16 @@ public:
         auto pre_op_fn = [this](const ValueType& input) {
                              return pre_phase_.Insert(input);
                          };
+        auto pre_op_batch_fn = [this](const ValueType* items, size_t size) {
+                                   for (size_t i = 0; i < size; ++i)
+                                       pre_phase_.Insert(items[i]);
+                               };
         // close the function stack with our pre op and register it at
         // parent node for output
         auto lop_chain = parent.stack().push(pre_op_fn).fold();
-        parent.node()->AddChild(this, lop_chain);
+        parent.node()->AddChild(
+            this, lop_chain, 0,
+            FoldBatchChain(parent, lop_chain, pre_op_batch_fn));
     }
 
     DIAMemUse PreOpMemUse() final {
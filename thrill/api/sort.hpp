@@ -22,6 +22,7 @@
 #include <thrill/common/porting.hpp>
 #include <thrill/common/qsort.hpp>
 #include <thrill/common/reservoir_sampling.hpp>
+#include <thrill/common/span.hpp>
 #include <thrill/core/multiway_merge.hpp>
 #include <thrill/data/file.hpp>
 #include <thrill/net/group.hpp>
@@ -240,6 +241,13 @@ public:
                 << "Start multi-way-merge of" << files_.size() << "files"
                 << "with prefetch" << prefetch;
 
+            // the final merge only holds the prefetched Blocks of each File,
+            // return the rest of our share to the Stage's other DIANodes.
+            size_t merge_mem =
+                files_.size() * (prefetch + data::default_block_size);
+            if (merge_mem < DIABase::mem_limit_.limit())
+                this->ReturnMemory(DIABase::mem_limit_.limit() - merge_mem);
+
             // construct output merger of remaining Files
             std::vector<data::File::Reader> seq;
             seq.reserve(files_.size());
@@ -677,7 +685,9 @@ private:
         while (reader.HasNext()) {
             if (vec.size() < capacity_half ||
                 (vec.size() < capacity && !mem::memory_exceeded)) {
-                vec.push_back(reader.template Next<ValueType>());
+                size_t limit = mem::memory_exceeded ? capacity_half : capacity;
+                AppendItems(reader, vec, limit - vec.size(),
+                            data::is_raw_serialized<ValueType>());
             }
             else {
                 SortAndWriteToFile(vec);
@@ -693,6 +703,26 @@ private:
         }
     }
 
+    //! append up to max_items from the reader to vec, items serialized as raw
+    //! bytes are copied in bulk from the Blocks.
+    template <typename Reader>
+    void AppendItems(Reader& reader, std::vector<ValueType>& vec,
+                     size_t max_items, std::true_type /* raw */) {
+        common::Span<const ValueType> span =
+            reader.template NextSpan<ValueType>(max_items);
+        if (span.empty())
+            vec.push_back(reader.template Next<ValueType>());
+        else
+            vec.insert(vec.end(), span.begin(), span.end());
+    }
+
+    //! append the next item from the reader to vec.
+    template <typename Reader>
+    void AppendItems(Reader& reader, std::vector<ValueType>& vec,
+                     size_t /* max_items */, std::false_type /* raw */) {
+        vec.push_back(reader.template Next<ValueType>());
+    }
+
     void SortAndWriteToFile(std::vector<ValueType>& vec) {
 
         LOG << "SortAndWriteToFile() " << vec.size()
@@ -719,9 +749,7 @@ private:
 
         files_.emplace_back(context_.GetFile(this));
         auto writer = files_.back().GetWriter();
-        for (const ValueType& elem : vec) {
-            writer.Put(elem);
-        }
+        writer.PutBatch(vec.data(), vec.size());
         writer.Close();
 
         write_time.Stop();
@@ -58,6 +58,7 @@ public:
     using Super = DIANode<ValueType>;
     using Super::context_;
     using Callback = typename Super::Callback;
+    using BatchCallback = typename Super::BatchCallback;
 
     enum class ChildStatus { NEW, PUSHING, DONE };
 
@@ -157,10 +158,12 @@ public:
     /*!
      * Enables children to push their "folded" function chains to their parent.
      * This way the parent can push all its result elements to each of the
-     * children. This procedure enables the minimization of IO-accesses.
+     * children. This procedure enables the minimization of IO-accesses. Batch
+     * callbacks are not used, since UnionNode pushes items one at a time.
      */
     void AddChild(DIABase* node, const Callback& callback,
-                  size_t parent_index = 0) final {
+                  size_t parent_index = 0,
+                  const BatchCallback& = BatchCallback()) final {
         children_.emplace_back(UnionChild {
                                    node, callback, parent_index,
                                    ChildStatus::NEW, std::vector<size_t>(num_inputs_)
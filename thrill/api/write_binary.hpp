@@ -58,10 +58,15 @@ public:
         auto pre_op_fn = [=](const ValueType& input) {
                              return PreOp(input);
                          };
+        auto pre_op_batch_fn = [=](const ValueType* items, size_t size) {
+                                   return PreOpBatch(items, size);
+                               };
         // close the function stack with our pre op and register it at parent
         // node for output
         auto lop_chain = parent.stack().push(pre_op_fn).fold();
-        parent.node()->AddChild(this, lop_chain);
+        parent.node()->AddChild(
+            this, lop_chain, 0,
+            FoldBatchChain(parent, lop_chain, pre_op_batch_fn));
     }
 
     DIAMemUse PreOpMemUse() final {
@@ -92,6 +97,12 @@ public:
         }
     }
 
+    //! PreOp() for an array of items.
+    void PreOpBatch(const ValueType* items, size_t size) {
+        for (size_t i = 0; i < size; ++i)
+            PreOp(items[i]);
+    }
+
     //! Closes the output file
     void StopPreOp(size_t /* parent_index */) final {
         sLOG << "closing file" << out_pathbase_;
@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * thrill/api/write_columnar.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_WRITE_COLUMNAR_HEADER
+#define THRILL_API_WRITE_COLUMNAR_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/context.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/data/columnar_format.hpp>
+#include <thrill/vfs/file_io.hpp>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+//! WriteColumnar() is only defined for DIAs of std::tuple items.
+template <typename ValueType>
+class WriteColumnarNode;
+
+/*!
+ * ActionNode which writes a DIA of std::tuple items into columnar files (see
+ * data::ColumnarFooter), one or more per worker. Rows are buffered per column
+ * and written as row groups of row_group_size rows.
+ *
+ * \ingroup api_layer
+ */
+template <typename... Columns>
+class WriteColumnarNode<std::tuple<Columns...> > final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = ActionNode;
+    using Super::context_;
+
+    using ValueType = std::tuple<Columns...>;
+
+    static constexpr size_t num_columns = sizeof ... (Columns);
+
+    //! number of values per encoded page of a column chunk
+    static constexpr size_t page_items = 4096;
+
+    template <typename ParentDIA>
+    WriteColumnarNode(const ParentDIA& parent,
+                      const std::string& path_out,
+                      size_t row_group_size, size_t max_file_size)
+        : ActionNode(parent.ctx(), "WriteColumnar",
+                     { parent.id() }, { parent.node() }),
+          out_pathbase_(path_out),
+          row_group_size_(row_group_size),
+          max_file_size_(max_file_size) {
+
+        die_unless(row_group_size_ > 0);
+        if (vfs::IsCompressed(out_pathbase_)) {
+            die("WriteColumnar: columnar files are encoded already and cannot"
+                " be compressed: " << out_pathbase_);
+        }
+
+        footer_.SetSchema<ValueType>();
+
+        auto pre_op_fn = [=](const ValueType& input) {
+                             return PreOp(input);
+                         };
+        // close the function stack with our pre op and register it at parent
+        // node for output
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        // the buffered rows of a row group, the encoded chunk of one column,
+        // and a Block for the output stream.
+        size_t row_bytes = 0, max_column_bytes = 0;
+        using Expander = int[];
+        (void)Expander {
+            (row_bytes += sizeof(Columns),
+             max_column_bytes = std::max(max_column_bytes, sizeof(Columns)),
+             0) ...
+        };
+        return row_group_size_ * (row_bytes + max_column_bytes)
+               + data::default_block_size;
+    }
+
+    //! writer preop: append item to the column buffers, write full row groups.
+    void PreOp(const ValueType& input) {
+        stats_total_elements_++;
+
+        Append(input, std::index_sequence_for<Columns...>());
+        if (++rows_ == row_group_size_)
+            WriteRowGroup();
+    }
+
+    //! Closes the output file
+    void StopPreOp(size_t /* parent_index */) final {
+        if (rows_ != 0) WriteRowGroup();
+        if (stream_) CloseFile();
+
+        Super::logger_
+            << "class" << "WriteColumnarNode"
+            << "total_elements" << stats_total_elements_
+            << "total_row_groups" << stats_total_row_groups_
+            << "total_bytes" << stats_total_bytes_;
+    }
+
+    void Execute() final { }
+
+private:
+    //! Base path of the output file.
+    std::string out_pathbase_;
+
+    //! File serial number for this worker
+    size_t out_serial_ = 0;
+
+    //! Number of rows per row group
+    size_t row_group_size_;
+
+    //! Size after which a new file is started
+    size_t max_file_size_;
+
+    //! current output file
+    vfs::WriteStreamPtr stream_;
+
+    //! bytes written to current output file
+    uint64_t file_size_ = 0;
+
+    //! footer of current output file
+    data::ColumnarFooter footer_;
+
+    //! buffered values of the current row group, one vector per column
+    std::tuple<std::vector<Columns>...> columns_;
+
+    //! number of buffered rows
+    size_t rows_ = 0;
+
+    size_t stats_total_elements_ = 0;
+    size_t stats_total_row_groups_ = 0;
+    size_t stats_total_bytes_ = 0;
+
+    template <size_t... Is>
+    void Append(const ValueType& input, std::index_sequence<Is...>) {
+        using Expander = int[];
+        (void)Expander {
+            (std::get<Is>(columns_).push_back(std::get<Is>(input)), 0) ...
+        };
+    }
+
+    void Write(const void* data, size_t size) {
+        stream_->write(data, size);
+        file_size_ += size;
+        stats_total_bytes_ += size;
+    }
+
+    //! encode the buffered rows as a row group into the current file
+    void WriteRowGroup() {
+        if (!stream_) OpenNextFile();
+
+        data::ColumnarRowGroup rg;
+        rg.num_rows = rows_;
+        rg.chunks.resize(num_columns);
+        WriteChunks(rg, std::index_sequence_for<Columns...>());
+
+        footer_.row_groups.emplace_back(std::move(rg));
+        stats_total_row_groups_++;
+        rows_ = 0;
+
+        if (file_size_ >= max_file_size_) CloseFile();
+    }
+
+    template <size_t... Is>
+    void WriteChunks(data::ColumnarRowGroup& rg, std::index_sequence<Is...>) {
+        using Expander = int[];
+        (void)Expander { (WriteChunk<Is>(rg.chunks[Is]), 0) ... };
+    }
+
+    template <size_t Index>
+    void WriteChunk(data::ColumnChunkInfo& info) {
+        auto& values = std::get<Index>(columns_);
+
+        data::ColumnChunkBuilder bb;
+        data::EncodeColumnChunk(values, page_items, bb, info);
+        values.clear();
+
+        info.offset = file_size_;
+        info.size = bb.size();
+        Write(bb.data(), bb.size());
+    }
+
+    //! open the next file and write the magic
+    void OpenNextFile() {
+        // construct path from pattern containing ### and $$$
+        std::string out_path = vfs::FillFilePattern(
+            out_pathbase_, context_.my_rank(), out_serial_++);
+
+        sLOG << "OpenNextFile() out_path" << out_path;
+
+        stream_ = vfs::OpenWriteStream(out_path);
+        file_size_ = 0;
+        footer_.row_groups.clear();
+
+        Write(data::columnar_magic, sizeof(data::columnar_magic));
+    }
+
+    //! write footer, footer size and magic, and close the file
+    void CloseFile() {
+        net::BufferBuilder bb;
+        footer_.Serialize(bb);
+        Write(bb.data(), bb.size());
+
+        uint64_t footer_size = bb.size();
+        unsigned char size_bytes[sizeof(footer_size)];
+        for (size_t i = 0; i < sizeof(footer_size); ++i)
+            size_bytes[i] = static_cast<unsigned char>(footer_size >> (8 * i));
+        Write(size_bytes, sizeof(size_bytes));
+        Write(data::columnar_magic, sizeof(data::columnar_magic));
+
+        stream_->close();
+        stream_ = vfs::WriteStreamPtr();
+    }
+};
+
+template <typename... Columns>
+constexpr size_t WriteColumnarNode<std::tuple<Columns...> >::page_items;
+
+template <typename ValueType, typename Stack>
+void DIA<ValueType, Stack>::WriteColumnar(
+    const std::string& filepath, size_t row_group_size,
+    size_t max_file_size) const {
+
+    using WriteColumnarNode = api::WriteColumnarNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteColumnarNode>(
+        *this, filepath, row_group_size, max_file_size);
+
+    node->RunScope();
+}
+
+template <typename ValueType, typename Stack>
+Future<void> DIA<ValueType, Stack>::WriteColumnarFuture(
+    const std::string& filepath, size_t row_group_size,
+    size_t max_file_size) const {
+
+    using WriteColumnarNode = api::WriteColumnarNode<ValueType>;
+
+    auto node = tlx::make_counting<WriteColumnarNode>(
+        *this, filepath, row_group_size, max_file_size);
+
+    return Future<void>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_WRITE_COLUMNAR_HEADER
+
+/******************************************************************************/
@@ -13,6 +13,7 @@
 #define THRILL_COMMON_HASH_HEADER
 
 #include <thrill/common/config.hpp>
+#include <tlx/container/string_view.hpp>
 #include <tlx/define/attribute_fallthrough.hpp>
 
 #include <array>
@@ -109,6 +110,12 @@ struct HashDataSwitch<std::string> {
     static size_t size(const std::string& s) { return s.length(); }
 };
 
+template <>
+struct HashDataSwitch<tlx::string_view> {
+    static const char * ptr(const tlx::string_view& s) { return s.data(); }
+    static size_t size(const tlx::string_view& s) { return s.size(); }
+};
+
 #ifdef THRILL_HAVE_SSE4_2
 /**
  * A CRC32C hasher using SSE4.2 intrinsics.
@@ -25,6 +25,8 @@
 #include <tlx/string/starts_with.hpp>
 #include <tlx/string/trim.hpp>
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <limits>
@@ -855,11 +857,170 @@ void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger) {
               new LinuxProcStats(logger), /* own_task */ true);
 }
 
+/******************************************************************************/
+// cgroup Memory Limits and Pressure
+
+//! directory of the cgroup of this process, which is either a cgroup v2
+//! directory or the v1 memory controller's directory. Empty if not found.
+struct CGroupPath {
+    std::string dir;
+    bool v2 = false;
+};
+
+static CGroupPath FindCGroupPath() {
+    CGroupPath cg;
+
+    std::ifstream in("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(in, line)) {
+        // format: hierarchy-ID:controller-list:cgroup-path
+        std::string::size_type c1 = line.find(':');
+        if (c1 == std::string::npos) continue;
+        std::string::size_type c2 = line.find(':', c1 + 1);
+        if (c2 == std::string::npos) continue;
+
+        std::string controllers = line.substr(c1 + 1, c2 - c1 - 1);
+        std::string path = line.substr(c2 + 1);
+        if (path == "/") path.clear();
+
+        if (controllers.empty() && line.compare(0, c1, "0") == 0) {
+            // cgroup v2 unified hierarchy, which wins if it has a memory
+            // controller
+            std::string dir = "/sys/fs/cgroup" + path;
+            if (access((dir + "/memory.current").c_str(), R_OK) == 0) {
+                cg.dir = dir, cg.v2 = true;
+                return cg;
+            }
+        }
+        else {
+            tlx::split_view(
+                ',', controllers, [&](const tlx::string_view& c) {
+                    if (c == "memory")
+                        cg.dir = "/sys/fs/cgroup/memory" + path;
+                });
+        }
+    }
+
+    // inside containers the v1 path may not be mapped, use the root.
+    if (!cg.dir.empty() &&
+        access((cg.dir + "/memory.limit_in_bytes").c_str(), R_OK) != 0)
+        cg.dir = "/sys/fs/cgroup/memory";
+
+    return cg;
+}
+
+//! cached cgroup path of this process
+static const CGroupPath& GetCGroupPath() {
+    static CGroupPath cg = FindCGroupPath();
+    return cg;
+}
+
+//! read a single number from a cgroup file, "max" and values beyond 2^62 are
+//! returned as 0 (unlimited).
+static bool ReadCGroupValue(const std::string& path, size_t& value) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line)) return false;
+    tlx::trim(&line);
+    if (line == "max") {
+        value = 0;
+        return true;
+    }
+    char* endptr;
+    unsigned long long v = strtoull(line.c_str(), &endptr, 10);
+    if (endptr == line.c_str() || *endptr != 0) return false;
+    value = v >= (1llu << 62) ? 0 : static_cast<size_t>(v);
+    return true;
+}
+
+size_t LinuxCGroupMemoryLimit() {
+    const CGroupPath& cg = GetCGroupPath();
+    if (cg.dir.empty()) return 0;
+
+    size_t limit = 0;
+    auto apply = [&limit](size_t v) {
+                     if (v != 0 && (limit == 0 || v < limit)) limit = v;
+                 };
+
+    if (!cg.v2) {
+        size_t v;
+        if (ReadCGroupValue(cg.dir + "/memory.limit_in_bytes", v))
+            apply(v);
+        return limit;
+    }
+
+    // walk up the hierarchy, since parents may have tighter limits
+    const std::string root = "/sys/fs/cgroup";
+    std::string dir = cg.dir;
+    for ( ; ; ) {
+        size_t v;
+        if (ReadCGroupValue(dir + "/memory.max", v))
+            apply(v);
+        if (ReadCGroupValue(dir + "/memory.high", v))
+            apply(v);
+
+        if (dir.size() <= root.size()) break;
+        dir.resize(dir.rfind('/'));
+    }
+    return limit;
+}
+
+bool ReadLinuxMemoryPressure(LinuxMemoryPressure& mp) {
+    const CGroupPath& cg = GetCGroupPath();
+
+    // PSI of the cgroup, else system-wide
+    std::ifstream in;
+    if (cg.v2)
+        in.open(cg.dir + "/memory.pressure");
+    if (!in.is_open())
+        in.open("/proc/pressure/memory");
+    if (!in.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        double avg10;
+        if (sscanf(line.c_str(), "some avg10=%lf", &avg10) == 1)
+            mp.some_avg10 = avg10;
+        else if (sscanf(line.c_str(), "full avg10=%lf", &avg10) == 1)
+            mp.full_avg10 = avg10;
+    }
+
+    // anonymous memory of the cgroup: page cache (e.g. of the foxxll disk
+    // files) is reclaimed by the kernel and not counted.
+    mp.usage = 0;
+    if (!cg.dir.empty()) {
+        std::ifstream stat(cg.dir + "/memory.stat");
+        const char* key = cg.v2 ? "anon " : "total_rss ";
+        while (std::getline(stat, line)) {
+            if (tlx::starts_with(line, key)) {
+                mp.usage = std::strtoull(
+                    line.c_str() + std::strlen(key), nullptr, 10);
+                break;
+            }
+        }
+    }
+    if (mp.usage == 0) {
+        // resident set size of this process
+        std::ifstream statm("/proc/self/statm");
+        unsigned long long size, resident;
+        if (statm >> size >> resident)
+            mp.usage = resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    mp.limit = LinuxCGroupMemoryLimit();
+    return true;
+}
+
 #else
 
 void StartLinuxProcStatsProfiler(ProfileThread&, JsonLogger&)
 { }
 
+size_t LinuxCGroupMemoryLimit() { return 0; }
+
+bool ReadLinuxMemoryPressure(LinuxMemoryPressure&) { return false; }
+
 #endif  // __linux__
 
 } // namespace common
@@ -15,6 +15,8 @@
 #ifndef THRILL_COMMON_LINUX_PROC_STATS_HEADER
 #define THRILL_COMMON_LINUX_PROC_STATS_HEADER
 
+#include <cstddef>
+
 namespace thrill {
 namespace common {
 
@@ -25,6 +27,27 @@ class ProfileThread;
 //! launch profiler task
 void StartLinuxProcStatsProfiler(ProfileThread& sched, JsonLogger& logger);
 
+//! Memory limit of the cgroup (v2 memory.max and memory.high, or v1
+//! memory.limit_in_bytes) this process runs in, including all parent cgroups,
+//! or 0 if not limited or not on Linux.
+size_t LinuxCGroupMemoryLimit();
+
+//! Memory pressure and usage as read by ReadLinuxMemoryPressure().
+struct LinuxMemoryPressure {
+    //! percentage of time in the last 10 seconds in which some or all tasks
+    //! were stalled waiting for memory (PSI).
+    double some_avg10 = 0, full_avg10 = 0;
+    //! anonymous memory used by the cgroup, or RSS of the process
+    size_t usage = 0;
+    //! memory limit of the cgroup, or 0 if not limited
+    size_t limit = 0;
+};
+
+//! Read the memory pressure stall information (PSI) of this process' cgroup,
+//! or the system-wide one, and the current memory usage. Returns false if PSI
+//! is not available.
+bool ReadLinuxMemoryPressure(LinuxMemoryPressure& mp);
+
 } // namespace common
 } // namespace thrill
 
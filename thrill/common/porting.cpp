@@ -16,10 +16,14 @@
 #include <thrill/common/system_exception.hpp>
 
 #include <tlx/string/replace.hpp>
+#include <tlx/string/trim.hpp>
 #include <tlx/unused.hpp>
 
 #include <fcntl.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <mutex>
 #include <sstream>
@@ -36,6 +40,10 @@
 
 #endif
 
+#if __linux__
+#include <sys/syscall.h>
+#endif
+
 namespace thrill {
 namespace common {
 
@@ -140,6 +148,143 @@ void SetCpuAffinity(size_t cpu_id) {
 #endif
 }
 
+/******************************************************************************/
+// NUMA Topology
+
+//! parse a list of ranges like "0-7,16-23"
+static std::vector<size_t> ParseRangeList(const std::string& list) {
+    std::vector<size_t> out;
+    std::istringstream ls(list);
+    std::string range;
+    while (std::getline(ls, range, ',')) {
+        range = tlx::trim(range);
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        size_t first = std::stoul(range.substr(0, dash));
+        size_t last = dash == std::string::npos
+                      ? first : std::stoul(range.substr(dash + 1));
+        for (size_t i = first; i <= last; ++i)
+            out.push_back(i);
+    }
+    return out;
+}
+
+NumaTopology NumaTopology::Parse(const ReadFile& read_file, size_t num_cpus) {
+    NumaTopology t;
+    t.cpu_node.resize(num_cpus, 0);
+
+    // node ids may have holes, e.g. after hot-unplugging a node.
+    std::string online;
+    if (!read_file("online", online)) return t;
+
+    size_t max_node = 0;
+    for (size_t node : ParseRangeList(online)) {
+        std::string cpulist;
+        if (!read_file("node" + std::to_string(node) + "/cpulist", cpulist))
+            continue;
+
+        for (size_t cpu : ParseRangeList(cpulist)) {
+            if (cpu >= num_cpus) continue;
+            t.cpu_node[cpu] = node;
+            t.cpus_by_node.push_back(cpu);
+        }
+        max_node = std::max(max_node, node);
+    }
+    t.num_nodes = max_node + 1;
+    return t;
+}
+
+size_t NumaTopology::WorkerCpu(
+    size_t worker, size_t num_workers, size_t num_reserved) const {
+    size_t num_cpus = cpu_node.size();
+    if (num_cpus == 0 || num_workers == 0) return worker;
+
+    // the DispatcherThreads are pinned to the last cpus, keep workers off
+    // them unless that would make workers share cpus.
+    size_t limit = num_workers + num_reserved <= num_cpus
+                   ? num_cpus - num_reserved : num_cpus;
+
+    if (num_nodes <= 1 || cpus_by_node.empty())
+        return worker % limit;
+
+    std::vector<size_t> cpus;
+    for (size_t cpu : cpus_by_node) {
+        if (cpu < limit) cpus.push_back(cpu);
+    }
+    if (cpus.empty()) cpus = cpus_by_node;
+
+    size_t n = cpus.size();
+    return cpus[(worker * n / num_workers) % n];
+}
+
+namespace {
+
+const NumaTopology& GetNumaTopology() {
+    static NumaTopology topology = NumaTopology::Parse(
+        [](const std::string& name, std::string& content) {
+#if __linux__ && !THRILL_ON_TRAVIS
+            std::ifstream in("/sys/devices/system/node/" + name);
+            if (!in.good()) return false;
+            std::getline(in, content);
+            return true;
+#else
+            tlx::unused(name, content);
+            return false;
+#endif
+        },
+        std::max(std::thread::hardware_concurrency(), 1u));
+    return topology;
+}
+
+} // namespace
+
+size_t NumaNodes() {
+    return GetNumaTopology().num_nodes;
+}
+
+size_t NumaNodeOfCpu(size_t cpu_id) {
+    const NumaTopology& t = GetNumaTopology();
+    if (t.cpu_node.empty()) return 0;
+    return t.cpu_node[cpu_id % t.cpu_node.size()];
+}
+
+size_t NumaWorkerCpu(size_t worker, size_t num_workers, size_t num_reserved) {
+    return GetNumaTopology().WorkerCpu(worker, num_workers, num_reserved);
+}
+
+bool NumaBindMemory(void* ptr, size_t size, size_t node, bool move) {
+#if __linux__ && !THRILL_ON_TRAVIS && defined(SYS_mbind)
+    // constants from <numaif.h>, which is part of libnuma
+    static constexpr int mpol_preferred = 1;
+    static constexpr unsigned mpol_mf_move = 1 << 1;
+    static constexpr size_t bits = 8 * sizeof(unsigned long);
+
+    if (NumaNodes() <= 1 || node >= NumaNodes()) return false;
+
+    // mbind() requires page aligned ranges.
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    if (reinterpret_cast<uintptr_t>(ptr) % page_size != 0) return false;
+
+    std::vector<unsigned long> mask(node / bits + 1);
+    mask[node / bits] = 1ul << (node % bits);
+
+    long rc = syscall(SYS_mbind, ptr, size, mpol_preferred, mask.data(),
+                      mask.size() * bits + 1, move ? mpol_mf_move : 0);
+    if (rc != 0) {
+        static std::atomic<bool> s_warned { false };
+        if (!s_warned.exchange(true))
+            LOG1 << "Error calling mbind(): " << strerror(errno);
+        return false;
+    }
+    return true;
+#else
+    tlx::unused(ptr, size, node, move);
+    return false;
+#endif
+}
+
+/******************************************************************************/
+
 std::string GetHostname() {
 #if __linux__
     char buffer[64];
@@ -20,9 +20,11 @@
 using ssize_t = SSIZE_T;
 #endif
 
+#include <functional>
 #include <string>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 #include <dirent.h>
 
@@ -62,6 +64,46 @@ void SetCpuAffinity(std::thread& thread, size_t cpu_id);
 //! set cpu/core affinity of current thread
 void SetCpuAffinity(size_t cpu_id);
 
+//! NUMA topology of the system's cpus
+struct NumaTopology {
+    //! node of each cpu
+    std::vector<size_t> cpu_node;
+    //! cpus ordered by node, empty if there is no NUMA information
+    std::vector<size_t> cpus_by_node;
+    //! number of nodes, which is one more than the highest node id
+    size_t num_nodes = 1;
+
+    //! function reading a file of /sys/devices/system/node, returns false if
+    //! it does not exist.
+    using ReadFile = std::function<bool(const std::string& name,
+                                        std::string& content)>;
+
+    //! Parse the topology of num_cpus cpus from the files "online" and
+    //! "node<N>/cpulist". Without them, all cpus are on node 0.
+    static NumaTopology Parse(const ReadFile& read_file, size_t num_cpus);
+
+    //! cpu/core to pin a worker to, see NumaWorkerCpu().
+    size_t WorkerCpu(size_t worker, size_t num_workers,
+                     size_t num_reserved) const;
+};
+
+//! number of NUMA nodes of the system, 1 if unknown
+size_t NumaNodes();
+
+//! NUMA node of a cpu/core, 0 if unknown
+size_t NumaNodeOfCpu(size_t cpu_id);
+
+//! cpu/core to pin a worker to, such that the workers are spread evenly across
+//! the NUMA nodes with consecutive workers on the same node. The last
+//! num_reserved cpus, to which the DispatcherThreads are pinned, are excluded
+//! only if each worker still gets a cpu of its own.
+size_t NumaWorkerCpu(size_t worker, size_t num_workers,
+                     size_t num_reserved = 0);
+
+//! set the preferred NUMA node of the pages in [ptr, ptr + size), and migrate
+//! pages already present if move is set. returns false if not supported.
+bool NumaBindMemory(void* ptr, size_t size, size_t node, bool move);
+
 //! get hostname
 std::string GetHostname();
 
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * thrill/common/span.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_SPAN_HEADER
+#define THRILL_COMMON_SPAN_HEADER
+
+#include <cassert>
+#include <cstddef>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * A non-owning view of a contiguous array of items, a minimal std::span. Used
+ * to hand out items in place, e.g. directly from pinned Block memory.
+ */
+template <typename Type>
+class Span
+{
+public:
+    using value_type = Type;
+    using iterator = Type*;
+
+    //! construct an empty span
+    Span() = default;
+
+    //! construct a span of size items at data
+    Span(Type* data, size_t size) : data_(data), size_(size) { }
+
+    //! pointer to the first item
+    Type * data() const { return data_; }
+
+    //! number of items
+    size_t size() const { return size_; }
+
+    //! whether the span contains no items
+    bool empty() const { return size_ == 0; }
+
+    iterator begin() const { return data_; }
+    iterator end() const { return data_ + size_; }
+
+    Type& operator [] (size_t i) const {
+        assert(i < size_);
+        return data_[i];
+    }
+
+private:
+    //! pointer to the first item
+    Type* data_ = nullptr;
+
+    //! number of items
+    size_t size_ = 0;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_SPAN_HEADER
+
+/******************************************************************************/
@@ -31,6 +31,10 @@ template <typename Key, typename HashFunction = std::hash<Key> >
 class ReduceByHash
 {
 public:
+    //! local indexes do not depend on the number of buckets, hence tables may
+    //! enlarge their partitions after Initialize().
+    static constexpr bool growable = true;
+
     struct Result {
         //! which partition number the item belongs to.
         size_t partition_id;
@@ -84,6 +88,10 @@ template <typename Key>
 class ReduceByIndex
 {
 public:
+    //! buckets map to fixed index ranges, hence the number of buckets may not
+    //! change after Initialize().
+    static constexpr bool growable = false;
+
     struct Result {
         //! which partition number the item belongs to.
         size_t partition_id;
@@ -340,7 +340,8 @@ public:
             return;
         }
 
-        if (partition_size_[partition_id] == num_buckets_per_partition_)
+        if (partition_size_[partition_id] == num_buckets_per_partition_ &&
+            !GrowTable())
             return;
 
         size_t new_size = std::min(
@@ -365,6 +366,62 @@ public:
             = new_size * config_.limit_partition_fill_rate();
     }
 
+    //! Double the maximum size of all partitions with memory requested from
+    //! the Stage's memory broker, instead of spilling a partition which reached
+    //! its maximum size. Returns false if no memory was granted.
+    bool GrowTable() {
+        if (!IndexFunction::growable || TLX_UNLIKELY(mem::memory_exceeded))
+            return false;
+
+        size_t new_buckets_per_partition = 2 * num_buckets_per_partition_;
+        size_t extra_bytes =
+            num_buckets_per_partition_ * num_partitions_ * sizeof(TableItem);
+
+        // while moving, the old and the new table of twice the size are
+        // allocated, hence request the new table's size for the peak.
+        if (!this->ctx_.RequestStageMemory(2 * extra_bytes))
+            return false;
+
+        sLOG << "Growing table from" << num_buckets_per_partition_
+             << "to" << new_buckets_per_partition << "buckets per partition";
+
+        TableItem* new_items = static_cast<TableItem*>(
+            operator new (
+                (new_buckets_per_partition * num_partitions_ + 1)
+                * sizeof(TableItem)));
+
+        // move the valid range of each partition to its new position, the
+        // local indexes remain unchanged.
+        for (size_t id = 0; id < num_partitions_; ++id) {
+            TableItem* iter = items_ + id * num_buckets_per_partition_;
+            TableItem* pend = iter + partition_size_[id];
+            TableItem* out = new_items + id * new_buckets_per_partition;
+
+            for ( ; iter != pend; ++iter, ++out) {
+                new (out)TableItem(std::move(*iter));
+                iter->~TableItem();
+            }
+        }
+
+        size_t new_num_buckets = new_buckets_per_partition * num_partitions_;
+        if (sentinel_partition_ != invalid_partition_) {
+            new (new_items + new_num_buckets)TableItem(
+                std::move(items_[num_buckets_]));
+            items_[num_buckets_].~TableItem();
+        }
+
+        operator delete (items_);
+        items_ = new_items;
+
+        // the old table's memory is free again, return it to the broker.
+        this->ctx_.ReturnStageMemory(extra_bytes);
+
+        num_buckets_per_partition_ = new_buckets_per_partition;
+        num_buckets_ = new_num_buckets;
+        limit_memory_bytes_ += extra_bytes;
+        return true;
+    }
+
     //! \name Spilling Mechanisms to External Memory Files
     //! \{
 
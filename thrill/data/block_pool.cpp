@@ -8,24 +8,40 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/linux_proc_stats.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/porting.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
 #include <thrill/mem/aligned_allocator.hpp>
+#include <thrill/mem/malloc_tracker.hpp>
 #include <thrill/mem/pool.hpp>
+#include <thrill/mem/slab_allocator.hpp>
 
+#include <foxxll/common/config.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/iostats.hpp>
+#include <foxxll/mng/block_alloc_strategy.hpp>
 #include <tlx/container/lru_cache.hpp>
 #include <tlx/die.hpp>
 #include <tlx/math/is_power_of_two.hpp>
 #include <tlx/string/join_generic.hpp>
+#include <tlx/unused.hpp>
+
+#if THRILL_HAVE_LZ4
+#include <lz4.h>
+#elif THRILL_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <set>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -50,6 +66,69 @@ static constexpr bool debug_mem = false;
 //! debug block eviction: evict, write complete, read complete
 static constexpr bool debug_em = false;
 
+/******************************************************************************/
+// Codec of the compressed tier: LZ4 if available, else fast zlib.
+
+#if THRILL_HAVE_LZ4 || THRILL_HAVE_ZLIB
+static constexpr bool have_block_compression = true;
+#else
+static constexpr bool have_block_compression = false;
+#endif
+
+//! maximum compressed size of size bytes
+static size_t CompressBound(size_t size) {
+#if THRILL_HAVE_LZ4
+    return static_cast<size_t>(LZ4_compressBound(static_cast<int>(size)));
+#elif THRILL_HAVE_ZLIB
+    return static_cast<size_t>(compressBound(size));
+#else
+    return size;
+#endif
+}
+
+//! compress size bytes from src into dst, returns compressed size or 0.
+static size_t CompressBlock(
+    const Byte* src, size_t size, Byte* dst, size_t dst_size) {
+#if THRILL_HAVE_LZ4
+    int n = LZ4_compress_default(
+        reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+        static_cast<int>(size), static_cast<int>(dst_size));
+    return n > 0 ? static_cast<size_t>(n) : 0;
+#elif THRILL_HAVE_ZLIB
+    uLongf n = dst_size;
+    if (compress2(dst, &n, src, size, Z_BEST_SPEED) != Z_OK) return 0;
+    return static_cast<size_t>(n);
+#else
+    tlx::unused(src, size, dst, dst_size);
+    return 0;
+#endif
+}
+
+//! size of the buffer of a compressed copy of csize bytes, which is padded to
+//! foxxll::BlockAlignment such that it can be written to disks with O_DIRECT.
+static size_t CompressedCapacity(size_t csize) {
+    return (csize + foxxll::BlockAlignment - 1)
+           / foxxll::BlockAlignment * foxxll::BlockAlignment;
+}
+
+//! decompress src_size bytes from src into exactly size bytes at dst.
+static void DecompressBlock(
+    const Byte* src, size_t src_size, Byte* dst, size_t size) {
+#if THRILL_HAVE_LZ4
+    int n = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(src), reinterpret_cast<char*>(dst),
+        static_cast<int>(src_size), static_cast<int>(size));
+    die_unequal(n, static_cast<int>(size));
+#elif THRILL_HAVE_ZLIB
+    uLongf n = size;
+    die_unequal(uncompress(dst, &n, src, src_size), Z_OK);
+    die_unequal(n, size);
+#else
+    tlx::unused(src, src_size, dst, size);
+    die("BlockPool: compressed Block without compression codec");
+#endif
+}
+
 /******************************************************************************/
 // std::new_handler() which gets called when malloc() returns nullptr
 
@@ -223,6 +302,186 @@ std::ostream& operator << (std::ostream& os, const BlockPool::PinCount& p) {
     return os;
 }
 
+/******************************************************************************/
+// BlockPool::EvictionSet
+
+/*!
+ * Set of unpinned ByteBlocks in memory, which are candidates for eviction. The
+ * ByteBlocks are kept in one list per DIANode holding them, ordered by the time
+ * they were unpinned, and the list to evict from is selected using the next-use
+ * hints from the StageBuilder: first Blocks of DIANodes without a hint in LRU
+ * order, then those used furthest in the future, and last untagged Blocks,
+ * which belong to the running Stage.
+ */
+class BlockPool::EvictionSet
+{
+public:
+    //! insert an unpinned ByteBlock, it must not be in the set.
+    void put(ByteBlock* block_ptr) {
+        size_t dia_id = block_ptr->eviction_dia_id_ = block_ptr->dia_id();
+        block_ptr->eviction_seq_ = ++seq_;
+
+        List& list = lists_[dia_id];
+        if (list.empty()) {
+            list.emplace(block_ptr->eviction_seq_, block_ptr);
+            Link(dia_id, list);
+        }
+        else {
+            // the oldest ByteBlock and hence the list's order is unchanged
+            list.emplace(block_ptr->eviction_seq_, block_ptr);
+        }
+        ++size_;
+    }
+
+    //! check whether the ByteBlock is in the set.
+    bool exists(ByteBlock* block_ptr) const {
+        auto it = lists_.find(block_ptr->eviction_dia_id_);
+        if (it == lists_.end()) return false;
+        auto bt = it->second.find(block_ptr->eviction_seq_);
+        return bt != it->second.end() && bt->second == block_ptr;
+    }
+
+    //! remove the ByteBlock, it must be in the set.
+    void erase(ByteBlock* block_ptr) {
+        auto it = lists_.find(block_ptr->eviction_dia_id_);
+        die_unless(it != lists_.end());
+        Unlink(it->first, it->second);
+        die_unequal(it->second.erase(block_ptr->eviction_seq_), 1u);
+        if (it->second.empty())
+            lists_.erase(it);
+        else
+            Link(it->first, it->second);
+        --size_;
+    }
+
+    //! remove and return the next victim ByteBlock.
+    ByteBlock * pop() {
+        die_unless(size_ != 0);
+
+        size_t dia_id;
+        if (!lru_order_.empty())
+            dia_id = lru_order_.begin()->second;
+        else if (!hint_order_.empty())
+            dia_id = hint_order_.rbegin()->second;
+        else
+            dia_id = 0;
+
+        auto it = lists_.find(dia_id);
+        die_unless(it != lists_.end());
+        Unlink(it->first, it->second);
+        ByteBlock* block_ptr = it->second.begin()->second;
+        it->second.erase(it->second.begin());
+        if (it->second.empty())
+            lists_.erase(it);
+        else
+            Link(it->first, it->second);
+        --size_;
+        return block_ptr;
+    }
+
+    //! number of ByteBlocks in the set.
+    size_t size() const { return size_; }
+
+    //! check whether Blocks of DIANode dia_id are used within the next stages.
+    bool UsedWithin(size_t dia_id, size_t stages) const {
+        // untagged Blocks are probably used by the running Stage
+        if (dia_id == 0) return true;
+        auto it = next_use_.find(dia_id);
+        return it != next_use_.end() && it->second <= stage_ + stages;
+    }
+
+    //! set Stage at which the Blocks of DIANode dia_id are used next, keeps
+    //! the earlier hint if both are ahead of the current Stage.
+    void SetNextUse(size_t dia_id, size_t stage) {
+        if (dia_id == 0) return;
+        auto lt = lists_.find(dia_id);
+        if (lt != lists_.end()) Unlink(dia_id, lt->second);
+
+        auto it = next_use_.find(dia_id);
+        if (it == next_use_.end())
+            next_use_.emplace(dia_id, stage);
+        else if (it->second < stage_ || stage < it->second)
+            it->second = stage;
+
+        if (lt != lists_.end()) Link(dia_id, lt->second);
+    }
+
+    //! advance the current Stage and drop obsolete hints, the Blocks of these
+    //! DIANodes are evicted in LRU order again.
+    void AdvanceStage(size_t stage) {
+        if (stage <= stage_) return;
+        stage_ = stage;
+        for (auto it = next_use_.begin(); it != next_use_.end(); ) {
+            if (it->second >= stage_) {
+                ++it;
+                continue;
+            }
+            auto lt = lists_.find(it->first);
+            if (lt != lists_.end()) Unlink(it->first, lt->second);
+            size_t dia_id = it->first;
+            it = next_use_.erase(it);
+            if (lt != lists_.end()) Link(dia_id, lt->second);
+        }
+    }
+
+private:
+    //! unpinned ByteBlocks of a DIANode by the time they were unpinned
+    using List = std::map<
+        size_t, ByteBlock*, std::less<>,
+        mem::GPoolAllocator<std::pair<const size_t, ByteBlock*> > >;
+
+    //! ordered set of (key, DIANode id) pairs
+    using Order = std::set<
+        std::pair<size_t, size_t>, std::less<>,
+        mem::GPoolAllocator<std::pair<size_t, size_t> > >;
+
+    //! lists of unpinned ByteBlocks, one per DIANode id
+    std::unordered_map<
+        size_t, List, std::hash<size_t>, std::equal_to<>,
+        mem::GPoolAllocator<std::pair<const size_t, List> > > lists_;
+
+    //! DIANodes without next-use hint, by the time their oldest ByteBlock was
+    //! unpinned
+    Order lru_order_;
+
+    //! DIANodes with next-use hint, by the Stage of their next use
+    Order hint_order_;
+
+    //! next-use Stage of DIANodes
+    std::unordered_map<
+        size_t, size_t, std::hash<size_t>, std::equal_to<>,
+        mem::GPoolAllocator<std::pair<const size_t, size_t> > > next_use_;
+
+    //! number of currently running Stage
+    size_t stage_ = 0;
+
+    //! counter of put() calls, orders ByteBlocks by the time they were unpinned
+    size_t seq_ = 0;
+
+    //! total number of ByteBlocks in all lists
+    size_t size_ = 0;
+
+    //! insert the non-empty list of DIANode dia_id into its eviction order
+    void Link(size_t dia_id, const List& list) {
+        if (dia_id == 0) return;
+        auto it = next_use_.find(dia_id);
+        if (it == next_use_.end())
+            lru_order_.emplace(list.begin()->first, dia_id);
+        else
+            hint_order_.emplace(it->second, dia_id);
+    }
+
+    //! remove the list of DIANode dia_id from its eviction order
+    void Unlink(size_t dia_id, const List& list) {
+        if (dia_id == 0) return;
+        auto it = next_use_.find(dia_id);
+        if (it == next_use_.end())
+            lru_order_.erase(std::make_pair(list.begin()->first, dia_id));
+        else
+            hint_order_.erase(std::make_pair(it->second, dia_id));
+    }
+};
+
 /******************************************************************************/
 // BlockPool::Data
 
@@ -253,12 +512,41 @@ public:
     //! is reached. 0 for no limit.
     size_t hard_ram_limit_;
 
+    //! \name Memory Pressure Adaptation
+    //! \{
+
+    //! soft and hard limit as configured, which are scaled down by
+    //! ram_limit_factor_ under memory pressure.
+    const size_t base_soft_ram_limit_, base_hard_ram_limit_;
+
+    //! current factor on the configured limits
+    double ram_limit_factor_ = 1.0;
+
+    //! lowest factor on the configured limits
+    static constexpr double min_ram_limit_factor = 0.5;
+
+    //! PSI stall percentage beyond which the limits are lowered, and below
+    //! which they are slowly raised again.
+    static constexpr double high_pressure = 10.0, low_pressure = 1.0;
+
+    //! last memory pressure reading
+    common::LinuxMemoryPressure mem_pressure_;
+
+    //! lower the limits under memory pressure such that Blocks are evicted
+    //! early, and raise them again when the pressure is gone.
+    void IntAdaptToMemoryPressure(
+        std::unique_lock<std::mutex>& lock, bool have_pressure);
+
+    //! \}
+
     //! print a message on the first block evicted to external memory
     bool notify_em_used_ = false;
 
-    //! list of all blocks that are _in_memory_ but are _not_ pinned.
-    tlx::LruCacheSet<
-        ByteBlock*, mem::GPoolAllocator<ByteBlock*> > unpinned_blocks_;
+    //! called when memory is released, see SetReleaseCallback()
+    ReleaseCallback release_callback_;
+
+    //! set of all blocks that are _in_memory_ but are _not_ pinned.
+    EvictionSet unpinned_blocks_;
 
     //! set of ByteBlocks currently begin written to EM.
     WritingMap writing_;
@@ -271,6 +559,55 @@ public:
         ByteBlock*, std::hash<ByteBlock*>, std::equal_to<>,
         mem::GPoolAllocator<ByteBlock*> > swapped_;
 
+    //! evicted ByteBlocks held compressed in RAM, in LRU order: when the tier
+    //! is full, the least recently compressed are demoted to EM.
+    tlx::LruCacheSet<ByteBlock*, mem::GPoolAllocator<ByteBlock*> > compressed_;
+
+    //! ByteBlocks being compressed without holding the lock, mapped to whether
+    //! a pin or DestroyBlock() canceled their eviction.
+    std::unordered_map<
+        ByteBlock*, bool, std::hash<ByteBlock*>, std::equal_to<>,
+        mem::GPoolAllocator<std::pair<ByteBlock* const, bool> > > compressing_;
+
+    //! condition variable signaled when compressing a ByteBlock completes
+    std::condition_variable cv_compress_complete_;
+
+    //! RAM available for compressed ByteBlocks, 0 if the tier is disabled.
+    size_t compressed_ram_limit_;
+
+    //! spill tier of disks flagged "flash" in the disk config, e.g. NVMe.
+    static constexpr size_t fast_tier = 0;
+
+    //! spill tier of all other disks, e.g. HDDs.
+    static constexpr size_t slow_tier = 1;
+
+    //! horizon in Stages within which Blocks are hot and go to the fast tier
+    static constexpr size_t fast_tier_horizon = 1;
+
+    //! allocation and I/O statistics of an external memory tier
+    struct EmTier {
+        //! whether disks of this tier are configured
+        bool available = false;
+        //! total size of the tier's disks, 0 if they autogrow.
+        uint64_t capacity = 0;
+        //! number of bytes allocated in the tier
+        size_t allocated_bytes = 0;
+        //! total number of bytes written to and read from the tier
+        size_t written_bytes = 0, read_bytes = 0;
+        //! written_bytes and read_bytes at the previous profile tick
+        size_t prev_written_bytes = 0, prev_read_bytes = 0;
+        //! number of I/O requests in flight, and its maximum since last tick
+        size_t queue_depth = 0, max_queue_depth = 0;
+
+        //! count a started I/O request
+        void StartIo() {
+            max_queue_depth = std::max(max_queue_depth, ++queue_depth);
+        }
+    };
+
+    //! external memory tiers to spill Blocks to
+    std::array<EmTier, 2> em_tiers_;
+
     //! I/O layer stats when BlockPool was created.
     foxxll::stats_data io_stats_first_;
 
@@ -284,9 +621,20 @@ public:
     //! I/O. Allocations are counted via mem_manager_.
     mem::AlignedAllocator<Byte, mem::Allocator<char> > aligned_alloc_;
 
+    //! Huge page backed slabs for ByteBlocks of power of two sizes up to 2 MiB,
+    //! which are recycled. Mapped chunks, including cached free slabs, are
+    //! counted via mem_manager_.
+    mem::SlabAllocator slab_alloc_;
+
     //! next unique File id
     std::atomic<size_t> next_file_id_ { 0 };
 
+    //! NUMA node of each local worker, or size_t(-1) if unknown.
+    std::vector<std::atomic<size_t> > worker_numa_node_;
+
+    //! bytes of the prefetch budget reserved by File readers of each worker
+    std::vector<size_t> prefetch_reserved_;
+
     //! number of unpinned bytes
     Counter unpinned_bytes_;
 
@@ -305,6 +653,20 @@ public:
     //! number of bytes currently being read from to EM.
     Counter reading_bytes_;
 
+    //! total uncompressed number of bytes in compressed blocks
+    Counter compressed_bytes_;
+
+    //! number of bytes in RAM used by compressed blocks, including those
+    //! being demoted to EM.
+    Counter compressed_ram_bytes_;
+
+    //! number of bytes in RAM of compressed blocks being demoted to EM.
+    size_t demoting_ram_bytes_ = 0;
+
+    //! idle scratch buffers to compress ByteBlocks into, with their sizes.
+    //! These bypass malloc tracking.
+    std::vector<std::pair<Byte*, size_t> > compress_scratch_;
+
     //! total number of ByteBlocks allocated
     size_t total_byte_blocks_ = 0;
 
@@ -328,12 +690,38 @@ public:
 public:
     Data(BlockPool& block_pool,
          size_t soft_ram_limit, size_t hard_ram_limit,
-         size_t workers_per_host)
+         size_t workers_per_host, size_t compressed_ram_limit)
         : soft_ram_limit_(soft_ram_limit),
           hard_ram_limit_(hard_ram_limit),
+          base_soft_ram_limit_(soft_ram_limit),
+          base_hard_ram_limit_(hard_ram_limit),
+          compressed_ram_limit_(
+              have_block_compression ? compressed_ram_limit : 0),
           bm_(foxxll::block_manager::get_instance()),
           aligned_alloc_(mem::Allocator<char>(block_pool.mem_manager_)),
-          pin_count_(workers_per_host) { }
+          slab_alloc_(&block_pool.mem_manager_),
+          worker_numa_node_(workers_per_host),
+          prefetch_reserved_(workers_per_host),
+          pin_count_(workers_per_host) {
+
+        for (std::atomic<size_t>& node : worker_numa_node_)
+            node = size_t(-1);
+
+        foxxll::config* config = foxxll::config::get_instance();
+        for (size_t i = 0; i < config->disks_number(); ++i) {
+            const foxxll::disk_config& disk = config->disk(i);
+            EmTier& tier = em_tiers_[disk.flash ? fast_tier : slow_tier];
+            // an autogrowing disk makes the tier unbounded
+            if (!tier.available || tier.capacity != 0)
+                tier.capacity = disk.autogrow ? 0 : tier.capacity + disk.size;
+            tier.available = true;
+        }
+    }
+
+    ~Data() {
+        for (const std::pair<Byte*, size_t>& scratch : compress_scratch_)
+            mem::bypass_free(scratch.first, scratch.second);
+    }
 
     //! Updates the memory manager for internal memory. If the hard limit is
     //! reached, the call is blocked intil memory is free'd
@@ -343,17 +731,74 @@ public:
     //! BlockPool::RequestInternalMemory calls
     void IntReleaseInternalMemory(size_t size);
 
+    //! Returns whether any worker pins the block. Decided by the per-worker
+    //! pin counts, which the lock-free paths never change from or to zero,
+    //! while total_pins_ may include a fast path pin which is rolled back.
+    static bool IntIsPinned(const ByteBlock* block_ptr) {
+        for (const std::atomic<size_t>& pc : block_ptr->pin_count_) {
+            if (pc.load() != 0) return true;
+        }
+        return false;
+    }
+
     //! Unpins a block. If all pins are removed, the block might be swapped.
     //! Returns immediately. Actual unpinning is async.
     void IntUnpinBlock(
         BlockPool& bp, ByteBlock* block_ptr, size_t local_worker_id);
 
-    //! Evict a block from the lru list into external memory
-    foxxll::request_ptr IntEvictBlockLRU();
+    //! Evict a block from the lru list into external memory. May release the
+    //! lock while compressing the block.
+    foxxll::request_ptr IntEvictBlockLRU(std::unique_lock<std::mutex>& lock);
+
+    //! Evict a block into the compressed tier or external memory. The block
+    //! must be unpinned and not swapped. May release the lock while
+    //! compressing the block.
+    foxxll::request_ptr IntEvictBlock(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
+
+    //! Write size bytes of a block's data at data into external memory, which
+    //! is either data_ or the compressed copy.
+    foxxll::request_ptr IntWriteBlock(
+        ByteBlock* block_ptr, Byte* data, size_t size);
+
+    //! Select the external memory tier to evict a block to: hot Blocks, which
+    //! are small or used again within fast_tier_horizon Stages, go to the fast
+    //! tier while it has room, all others to the slow tier.
+    size_t IntSelectEmTier(ByteBlock* block_ptr);
+
+    //! Allocate memory for a ByteBlock, from slab_alloc_ if possible. Needs no
+    //! lock.
+    Byte * AllocateData(size_t size);
+
+    //! Deallocate memory of a ByteBlock. Needs no lock.
+    void DeallocateData(Byte* data, size_t size);
 
-    //! Evict a block into external memory. The block must be unpinned and not
-    //! swapped.
-    foxxll::request_ptr IntEvictBlock(ByteBlock* block_ptr);
+    //! Prefer the NUMA node of the worker for new ByteBlock memory, returns
+    //! the node or size_t(-1). Needs no lock.
+    size_t BindToWorkerNode(Byte* data, size_t size, size_t local_worker_id);
+
+    //! Free a block's external memory allocation.
+    void IntDeleteEmBlock(ByteBlock* block_ptr);
+
+    //! Evict a block into the compressed tier, compressing it without holding
+    //! the lock. Returns false if the data does not compress well, and true if
+    //! the block was compressed or its eviction was canceled meanwhile.
+    bool IntCompressBlock(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
+
+    //! Cancel the eviction of a block which is being compressed and wait for
+    //! it to return to the unpinned blocks. Returns false if the block was not
+    //! being compressed.
+    bool IntWaitCompressing(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
+
+    //! Demote the least recently compressed block of the compressed tier by
+    //! writing its compressed copy to external memory.
+    void IntDemoteCompressedLRU();
+
+    //! Release the compressed copy of a block in RAM. compressed_size_ is
+    //! kept, since the copy may still be in external memory.
+    void IntReleaseCompressed(ByteBlock* block_ptr);
 
     //! \name Block Statistics
     //! \{
@@ -367,6 +812,13 @@ public:
     //! \}
 };
 
+constexpr size_t BlockPool::Data::fast_tier;
+constexpr size_t BlockPool::Data::slow_tier;
+constexpr size_t BlockPool::Data::fast_tier_horizon;
+constexpr double BlockPool::Data::min_ram_limit_factor;
+constexpr double BlockPool::Data::high_pressure;
+constexpr double BlockPool::Data::low_pressure;
+
 /******************************************************************************/
 // BlockPool
 
@@ -375,12 +827,13 @@ BlockPool::BlockPool(size_t workers_per_host)
 
 BlockPool::BlockPool(size_t soft_ram_limit, size_t hard_ram_limit,
                      common::JsonLogger* logger, mem::Manager* mem_manager,
-                     size_t workers_per_host)
+                     size_t workers_per_host, size_t compressed_ram_limit)
     : logger_(logger),
       mem_manager_(mem_manager, "BlockPool"),
       workers_per_host_(workers_per_host),
       d_(std::make_unique<Data>(
-             *this, soft_ram_limit, hard_ram_limit, workers_per_host)) {
+             *this, soft_ram_limit, hard_ram_limit, workers_per_host,
+             compressed_ram_limit)) {
 
     die_unless(hard_ram_limit >= soft_ram_limit);
     {
@@ -398,7 +851,8 @@ BlockPool::BlockPool(size_t soft_ram_limit, size_t hard_ram_limit,
     logger_ << "class" << "BlockPool"
             << "event" << "create"
             << "soft_ram_limit" << soft_ram_limit
-            << "hard_ram_limit" << hard_ram_limit;
+            << "hard_ram_limit" << hard_ram_limit
+            << "compressed_ram_limit" << d_->compressed_ram_limit_;
 }
 
 BlockPool::~BlockPool() {
@@ -464,6 +918,7 @@ BlockPool::~BlockPool() {
     die_unequal(d_->total_ram_bytes_, 0u);
     die_unequal(d_->total_bytes_, 0u);
     die_unequal(d_->unpinned_blocks_.size(), 0u);
+    die_unequal(d_->compressed_.size(), 0u);
 
     LOGC(debug_pin)
         << "~BlockPool()"
@@ -498,7 +953,8 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     // allocate block memory. -- unlock mutex for that time, since it may
     // require block eviction.
     lock.unlock();
-    Byte* data = d_->aligned_alloc_.allocate(size);
+    Byte* data = d_->AllocateData(size);
+    size_t numa_node = d_->BindToWorkerNode(data, size, local_worker_id);
     LOGC(debug_alloc)
         << "ByteBlock aligned_alloc: " << (void*)data << " size " << size;
     lock.lock();
@@ -506,6 +962,7 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     // create tlx::CountingPtr, no need for special make_shared()-equivalent
     PinnedByteBlockPtr block_ptr(
         mem::GPool().make<ByteBlock>(this, data, size), local_worker_id);
+    block_ptr->numa_node_ = numa_node;
     ++d_->total_byte_blocks_;
     d_->total_bytes_ += size;
     d_->max_total_bytes_ = std::max(d_->max_total_bytes_, d_->total_bytes_.value);
@@ -544,13 +1001,54 @@ ByteBlockPtr BlockPool::MapExternalBlock(
     return block_ptr;
 }
 
+ByteBlockPtr BlockPool::MapMappedBlock(
+    const MappedFilePtr& file, uint64_t offset, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ByteBlockPtr block_ptr(
+        mem::GPool().make<ByteBlock>(this, file, offset, size));
+    ++d_->total_byte_blocks_;
+    d_->max_total_bytes_ = std::max(d_->max_total_bytes_, d_->total_bytes_.value);
+    d_->total_bytes_ += size;
+
+    LOGC(debug_blc)
+        << "BlockPool::MapMappedBlock()"
+        << " ptr=" << block_ptr.get()
+        << " offset=" << offset
+        << " size=" << size;
+
+    return block_ptr;
+}
+
 //! Pins a block by swapping it in if required.
 PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     assert(local_worker_id < workers_per_host_);
-    std::unique_lock<std::mutex> lock(mutex_);
 
     ByteBlock* block_ptr = block.byte_block().get();
 
+    // fast path without locking: if the worker already holds a pin, only its
+    // pin count is incremented. The total pins are incremented first and
+    // rolled back if the worker's pins dropped to zero meanwhile, such that
+    // total_pins_ never drops below the sum of the per-worker pin counts.
+    std::atomic<size_t>& pin_count = block_ptr->pin_count_[local_worker_id];
+    size_t p = pin_count.load(std::memory_order_relaxed);
+    if (p > 0) {
+        ++block_ptr->total_pins_;
+        while (p > 0) {
+            if (pin_count.compare_exchange_weak(p, p + 1)) {
+                LOGC(debug_pin)
+                    << "BlockPool::PinBlock block=" << &block
+                    << " already pinned by thread, fast path";
+
+                return PinRequestPtr(
+                    mem::GPool().make<PinRequest>(
+                        this, PinnedBlock(block, local_worker_id)));
+            }
+        }
+        --block_ptr->total_pins_;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
     if (block_ptr->pin_count_[local_worker_id] > 0) {
         // We may get a Block who's underlying is already pinned, since
         // PinnedBlock become Blocks when transfered between Files or delivered
@@ -569,7 +1067,7 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
-    if (block_ptr->total_pins_ > 0) {
+    if (Data::IntIsPinned(block_ptr)) {
         // This block was already pinned by another thread, hence we only need
         // to get a pin for the new thread.
 
@@ -588,9 +1086,14 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
-    // check that not writing the block.
+    // check that not compressing or writing the block.
     WritingMap::iterator write_it;
-    while ((write_it = d_->writing_.find(block_ptr)) != d_->writing_.end()) {
+    for (;;) {
+        // cancel compression and wait for it, which releases the lock.
+        if (d_->IntWaitCompressing(lock, block_ptr)) continue;
+
+        if ((write_it = d_->writing_.find(block_ptr)) == d_->writing_.end())
+            break;
 
         LOGC(debug_em)
             << "BlockPool::PinBlock() block=" << block_ptr
@@ -652,6 +1155,95 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
+    if (block_ptr->compressed_)
+    {
+        // evicted block in the compressed tier, decompress it synchronously.
+
+        d_->IntRequestInternalMemory(lock, block_ptr->size());
+
+        if (!d_->compressed_.exists(block_ptr) ||
+            d_->reading_.find(block_ptr) != d_->reading_.end()) {
+            // another worker pinned the block while waiting for memory.
+            d_->IntReleaseInternalMemory(block_ptr->size());
+            lock.unlock();
+            return PinBlock(block, local_worker_id);
+        }
+
+        d_->pin_count_.Increment(local_worker_id, block_ptr->size());
+
+        // register as being read, such that concurrent pins of other workers
+        // wait for the decompression.
+        PinRequestPtr read(
+            mem::GPool().make<PinRequest>(
+                this, PinnedBlock(block, local_worker_id), /* ready */ false));
+        d_->reading_[block_ptr] = read;
+
+        d_->compressed_.erase(block_ptr);
+        d_->compressed_bytes_ -= block_ptr->size();
+        d_->reading_bytes_ += block_ptr->size();
+
+        LOGC(debug_em)
+            << "BlockPool::PinBlock block=" << block
+            << " decompressing from RAM"
+            << d_->pin_count_;
+
+        // allocate block memory and decompress without holding the lock. the
+        // PinRequest holds a reference, hence the block cannot be destroyed.
+        lock.unlock();
+        Byte* data = d_->AllocateData(block_ptr->size());
+        block_ptr->numa_node_ =
+            d_->BindToWorkerNode(data, block_ptr->size(), local_worker_id);
+        DecompressBlock(block_ptr->compressed_, block_ptr->compressed_size_,
+                        data, block_ptr->size());
+        lock.lock();
+
+        block_ptr->data_ = data;
+        d_->IntReleaseCompressed(block_ptr);
+        block_ptr->compressed_size_ = 0;
+
+        IntIncBlockPinCount(block_ptr, local_worker_id);
+
+        read->ready_ = true;
+        d_->reading_bytes_ -= block_ptr->size();
+        d_->reading_.erase(block_ptr);
+        cv_read_complete_.notify_all();
+
+        return read;
+    }
+
+    if (block_ptr->mapped_file_)
+    {
+        // mapped block whose pages were dropped: the page cache holds the
+        // data, hence only account the memory and let the kernel read ahead.
+
+        d_->IntRequestInternalMemory(lock, block_ptr->size());
+
+        if (block_ptr->in_memory()) {
+            // another worker pinned the block while waiting for memory.
+            d_->IntReleaseInternalMemory(block_ptr->size());
+            lock.unlock();
+            return PinBlock(block, local_worker_id);
+        }
+
+        block_ptr->data_ =
+            block_ptr->mapped_file_->data(block_ptr->mapped_offset_);
+
+        IntIncBlockPinCount(block_ptr, local_worker_id);
+        d_->pin_count_.Increment(local_worker_id, block_ptr->size());
+
+        LOGC(debug_em)
+            << "BlockPool::PinBlock block=" << block
+            << " pinned from mapped file"
+            << d_->pin_count_;
+
+        lock.unlock();
+        block_ptr->mapped_file_->WillNeed(
+            block_ptr->mapped_offset_, block_ptr->size());
+
+        return PinRequestPtr(mem::GPool().make<PinRequest>(
+                                 this, PinnedBlock(block, local_worker_id)));
+    }
+
     // else need to initiate an async read to get the data.
 
     die_unless(block_ptr->em_bid_.storage);
@@ -670,15 +1262,25 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
             this, PinnedBlock(block, local_worker_id), /* ready */ false));
     d_->reading_[block_ptr] = read;
 
-    // allocate block memory.
+    // allocate block memory, and a buffer for the compressed copy if the
+    // block was demoted from the compressed tier.
+    size_t compressed_size = block_ptr->compressed_size_;
     lock.unlock();
     Byte* data = read->byte_block()->data_ =
-        d_->aligned_alloc_.allocate(block_ptr->size());
+        d_->AllocateData(block_ptr->size());
+    block_ptr->numa_node_ =
+        d_->BindToWorkerNode(data, block_ptr->size(), local_worker_id);
+    Byte* compressed =
+        compressed_size != 0
+        ? d_->aligned_alloc_.allocate(CompressedCapacity(compressed_size))
+        : nullptr;
     lock.lock();
+    block_ptr->compressed_ = compressed;
 
     if (!block_ptr->ext_file_) {
         d_->swapped_.erase(block_ptr);
         d_->swapped_bytes_ -= block_ptr->size();
+        d_->em_tiers_[block_ptr->em_tier_].StartIo();
     }
 
     LOGC(debug_em)
@@ -690,7 +1292,8 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     read->req_ =
         block_ptr->em_bid_.storage->aread(
             // parameters for the read
-            data, block_ptr->em_bid_.offset, block_ptr->size(),
+            compressed ? compressed : data, block_ptr->em_bid_.offset,
+            block_ptr->em_bid_.size,
             // construct an immediate CompletionHandler callback
             foxxll::completion_handler::make<
                 PinRequest, &PinRequest::OnComplete>(*read));
@@ -700,6 +1303,45 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
     return read;
 }
 
+void BlockPool::SetReleaseCallback(const ReleaseCallback& callback) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->release_callback_ = callback;
+}
+
+void BlockPool::SetNextUse(size_t dia_id, size_t stage) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->unpinned_blocks_.SetNextUse(dia_id, stage);
+}
+
+void BlockPool::AdvanceStage(size_t stage) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    d_->unpinned_blocks_.AdvanceStage(stage);
+}
+
+void BlockPool::SetWorkerNumaNode(size_t local_worker_id, size_t numa_node) {
+    assert(local_worker_id < workers_per_host_);
+    d_->worker_numa_node_[local_worker_id] = numa_node;
+}
+
+void BlockPool::MigrateToWorker(
+    const PinnedBlock& block, size_t local_worker_id) {
+    assert(local_worker_id < workers_per_host_);
+
+    ByteBlock* block_ptr = block.byte_block().get();
+    size_t node = d_->worker_numa_node_[local_worker_id];
+
+    // moving pages costs about as much as reading them remotely once, hence
+    // only full Blocks, which are usually stored and read again, are moved.
+    if (node == size_t(-1) || block_ptr->numa_node_ == node ||
+        block_ptr->mapped_file_ ||
+        block_ptr->size() < default_block_size)
+        return;
+
+    if (common::NumaBindMemory(
+            block_ptr->data_, block_ptr->size(), node, /* move */ true))
+        block_ptr->numa_node_ = node;
+}
+
 std::pair<size_t, size_t> BlockPool::MaxMergeDegreePrefetch(size_t num_files) {
     size_t avail_bytes = hard_ram_limit() / workers_per_host_ / 2;
     size_t avail_blocks = avail_bytes / default_block_size;
@@ -716,17 +1358,46 @@ std::pair<size_t, size_t> BlockPool::MaxMergeDegreePrefetch(size_t num_files) {
     }
 }
 
+size_t BlockPool::ReservePrefetch(
+    size_t local_worker_id, size_t size, bool force) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(local_worker_id < workers_per_host_);
+    size_t& reserved = d_->prefetch_reserved_[local_worker_id];
+
+    if (!force && d_->hard_ram_limit_ != 0) {
+        size_t budget = d_->hard_ram_limit_ / workers_per_host_ / 2;
+        size = reserved >= budget ? 0 : std::min(size, budget - reserved);
+    }
+    reserved += size;
+    return size;
+}
+
+void BlockPool::ReleasePrefetch(size_t local_worker_id, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(local_worker_id < workers_per_host_);
+    size_t& reserved = d_->prefetch_reserved_[local_worker_id];
+    die_unless(reserved >= size);
+    reserved -= size;
+}
+
 void PinRequest::OnComplete(foxxll::request* req, bool success) {
     return block_pool_->OnReadComplete(this, req, success);
 }
 
 void BlockPool::OnReadComplete(
     PinRequest* read, foxxll::request* req, bool success) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     ByteBlock* block_ptr = read->block_.byte_block().get();
     size_t block_size = block_ptr->size();
 
+    // decompress a block demoted from the compressed tier before locking.
+    if (success && block_ptr->compressed_) {
+        req->check_errors();
+        DecompressBlock(block_ptr->compressed_, block_ptr->compressed_size_,
+                        read->byte_block()->data_, block_size);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
     LOGC(debug_em)
         << "OnReadComplete():"
         << " req " << req << " block " << *block_ptr
@@ -734,6 +1405,21 @@ void BlockPool::OnReadComplete(
         << " from " << block_ptr->em_bid_ << " success = " << success;
     req->check_errors();
 
+    if (!block_ptr->ext_file_) {
+        Data::EmTier& tier = d_->em_tiers_[block_ptr->em_tier_];
+        --tier.queue_depth;
+        if (success) tier.read_bytes += block_ptr->em_bid_.size;
+    }
+
+    if (block_ptr->compressed_) {
+        d_->aligned_alloc_.deallocate(
+            block_ptr->compressed_,
+            CompressedCapacity(block_ptr->compressed_size_));
+        block_ptr->compressed_ = nullptr;
+        // a canceled read leaves the compressed copy on disk
+        if (success) block_ptr->compressed_size_ = 0;
+    }
+
     if (!success)
     {
         // request was canceled. this is not an I/O error, but intentional,
@@ -748,7 +1434,7 @@ void BlockPool::OnReadComplete(
         sLOGC(debug_alloc)
             << "ByteBlock  deallocate"
             << (void*)read->byte_block()->data_ << "size" << block_size;
-        d_->aligned_alloc_.deallocate(read->byte_block()->data_, block_size);
+        d_->DeallocateData(read->byte_block()->data_, block_size);
 
         d_->IntReleaseInternalMemory(block_size);
 
@@ -763,10 +1449,8 @@ void BlockPool::OnReadComplete(
         // set pin on ByteBlock
         IntIncBlockPinCount(block_ptr, read->block_.local_worker_id_);
 
-        if (!block_ptr->ext_file_) {
-            d_->bm_->delete_block(block_ptr->em_bid_);
-            block_ptr->em_bid_ = foxxll::BID<0>();
-        }
+        if (!block_ptr->ext_file_)
+            d_->IntDeleteEmBlock(block_ptr);
     }
 
     read->ready_ = true;
@@ -794,7 +1478,9 @@ void BlockPool::OnReadComplete(
 }
 
 void BlockPool::IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
-    std::unique_lock<std::mutex> lock(mutex_);
+    // fast path without locking: the worker already holds a pin, hence neither
+    // its pin count nor the total pins can be zero, and the Block is neither in
+    // the LRU list nor being evicted.
     assert(local_worker_id < workers_per_host_);
     die_unless(block_ptr->pin_count_[local_worker_id] > 0);
     return IntIncBlockPinCount(block_ptr, local_worker_id);
@@ -803,26 +1489,48 @@ void BlockPool::IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
 void BlockPool::IntIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
     assert(local_worker_id < workers_per_host_);
 
-    ++block_ptr->pin_count_[local_worker_id];
+    // total pins first, see PinBlock()
     ++block_ptr->total_pins_;
+    ++block_ptr->pin_count_[local_worker_id];
 
     LOGC(debug_pin)
         << "BlockPool::IncBlockPinCount()"
         << " byte_block=" << block_ptr
         << " ++block.pin_count[" << local_worker_id << "]="
-        << block_ptr->pin_count_[local_worker_id]
-        << " ++block.total_pins_=" << block_ptr->total_pins_
-        << d_->pin_count_;
+        << block_ptr->pin_count(local_worker_id)
+        << " ++block.total_pins_=" << block_ptr->total_pins_.load();
 }
 
 void BlockPool::DecBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id) {
+    assert(local_worker_id < workers_per_host_);
+
+    // fast path without locking: if the worker keeps at least one pin, the
+    // Block stays pinned and no BlockPool state changes.
+    std::atomic<size_t>& pin_count = block_ptr->pin_count_[local_worker_id];
+    size_t p = pin_count.load(std::memory_order_relaxed);
+    while (p > 1) {
+        if (pin_count.compare_exchange_weak(p, p - 1)) {
+            --block_ptr->total_pins_;
+
+            LOGC(debug_pin)
+                << "BlockPool::DecBlockPinCount()"
+                << " byte_block=" << block_ptr
+                << " --block.pin_count[" << local_worker_id << "]=" << p - 1
+                << " local_worker_id=" << local_worker_id
+                << " fast path";
+            return;
+        }
+    }
+
+    // slow path: the worker's last pin is released, the Block may become
+    // unpinned and must be registered in the LRU list.
     std::unique_lock<std::mutex> lock(mutex_);
 
-    assert(local_worker_id < workers_per_host_);
     die_unless(block_ptr->pin_count_[local_worker_id] > 0);
     die_unless(block_ptr->total_pins_ > 0);
 
-    size_t p = --block_ptr->pin_count_[local_worker_id];
+    p = --block_ptr->pin_count_[local_worker_id];
+
     size_t tp = --block_ptr->total_pins_;
 
     LOGC(debug_pin)
@@ -845,7 +1553,7 @@ void BlockPool::Data::IntUnpinBlock(
 
     pin_count_.Decrement(local_worker_id, block_ptr->size());
 
-    if (block_ptr->total_pins_ != 0) {
+    if (IntIsPinned(block_ptr)) {
         LOGC(debug_pin)
             << "BlockPool::IntUnpinBlock()"
             << " --block.total_pins_=" << block_ptr->total_pins_;
@@ -880,7 +1588,13 @@ size_t BlockPool::Data::int_total_blocks() noexcept {
 
     return pin_count_.total_pins_
            + unpinned_blocks_.size() + writing_.size()
-           + swapped_.size() + reading_.size();
+           + swapped_.size() + reading_.size() + compressed_.size()
+           + compressing_.size();
+}
+
+size_t BlockPool::soft_ram_limit() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->soft_ram_limit_;
 }
 
 size_t BlockPool::hard_ram_limit() noexcept {
@@ -888,6 +1602,11 @@ size_t BlockPool::hard_ram_limit() noexcept {
     return d_->hard_ram_limit_;
 }
 
+size_t BlockPool::total_ram_bytes() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->total_ram_bytes_;
+}
+
 size_t BlockPool::total_bytes() noexcept {
     std::unique_lock<std::mutex> lock(mutex_);
     return d_->int_total_bytes();
@@ -904,11 +1623,12 @@ size_t BlockPool::Data::int_total_bytes() noexcept {
         << " unpinned_bytes_=" << unpinned_bytes_
         << " writing_bytes_=" << writing_bytes_
         << " swapped_bytes_=" << swapped_bytes_
-        << " reading_bytes_=" << reading_bytes_;
+        << " reading_bytes_=" << reading_bytes_
+        << " compressed_bytes_=" << compressed_bytes_;
 
     return pin_count_.total_pinned_bytes_
            + unpinned_bytes_ + writing_bytes_
-           + swapped_bytes_ + reading_bytes_;
+           + swapped_bytes_ + reading_bytes_ + compressed_bytes_;
 }
 
 size_t BlockPool::pinned_blocks() noexcept {
@@ -931,6 +1651,31 @@ size_t BlockPool::swapped_blocks() noexcept {
     return d_->swapped_.size();
 }
 
+size_t BlockPool::compressed_blocks() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->compressed_.size();
+}
+
+size_t BlockPool::em_tier_bytes(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->em_tiers_[tier].allocated_bytes;
+}
+
+size_t BlockPool::em_tier_written_bytes(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->em_tiers_[tier].written_bytes;
+}
+
+size_t BlockPool::em_tier_read_bytes(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->em_tiers_[tier].read_bytes;
+}
+
+size_t BlockPool::em_tier_queue_depth(size_t tier) noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->em_tiers_[tier].queue_depth;
+}
+
 size_t BlockPool::reading_blocks() noexcept {
     std::unique_lock<std::mutex> lock(mutex_);
     return d_->reading_.size();
@@ -951,67 +1696,89 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     // delete pin_count_ -> mark block as being deleted
     block_ptr->pin_count_.clear();
 
-    do {
-        if (block_ptr->in_memory())
-        {
-            // block was evicted, may still be writing to EM.
-            WritingMap::iterator it = d_->writing_.find(block_ptr);
-            if (it != d_->writing_.end()) {
-                // get reference count to request, since complete handler
-                // removes it from the map.
-                foxxll::request_ptr req = it->second;
-
-                LOGC(debug_em)
-                    << "DestroyBlock()"
-                    << " canceling write I/O request " << req
-                    << " for block " << *block_ptr;
-
-                lock.unlock();
-                // cancel I/O request
-                if (!req->cancel()) {
-                    // must still wait for cancellation to complete and the I/O
-                    // handler.
-                    req->wait();
-                }
-                lock.lock();
-
-                // recheck whether block is being written, it may have been
-                // evicting the unlocked time.
-                continue;
+    for (;;) {
+        // block may be compressed into the compressed tier, cancel and wait.
+        if (d_->IntWaitCompressing(lock, block_ptr))
+            continue;
+
+        // block was evicted or demoted from the compressed tier, may still be
+        // writing to EM.
+        WritingMap::iterator write_it = d_->writing_.find(block_ptr);
+        if (write_it != d_->writing_.end()) {
+            // get reference count to request, since complete handler
+            // removes it from the map.
+            foxxll::request_ptr req = write_it->second;
+
+            LOGC(debug_em)
+                << "DestroyBlock()"
+                << " canceling write I/O request " << req
+                << " for block " << *block_ptr;
+
+            lock.unlock();
+            // cancel I/O request
+            if (!req->cancel()) {
+                // must still wait for cancellation to complete and the I/O
+                // handler.
+                req->wait();
             }
+            lock.lock();
+
+            // recheck whether block is being written, it may have been
+            // evicting the unlocked time.
+            continue;
         }
-        else
-        {
-            // block was being pinned. cancel read operation
-            ReadingMap::iterator it = d_->reading_.find(block_ptr);
-            if (it != d_->reading_.end()) {
-                // get reference count to request, since complete handler
-                // removes it from the map.
-                foxxll::request_ptr req = it->second->req_;
-
-                LOGC(debug_em)
-                    << "DestroyBlock()"
-                    << " canceling read I/O request " << req
-                    << " for block " << *block_ptr;
-
-                lock.unlock();
-                // cancel I/O request
-                if (!req->cancel()) {
-                    // must still wait for cancellation to complete and the I/O
-                    // handler.
-                    req->wait();
-                }
-                lock.lock();
-
-                // recheck whether block is being read, it may have been
-                // evicting again in the unlocked time.
-                continue;
+
+        // block was being pinned. cancel read operation
+        ReadingMap::iterator read_it = d_->reading_.find(block_ptr);
+        if (!block_ptr->in_memory() && read_it != d_->reading_.end()) {
+            // get reference count to request, since complete handler
+            // removes it from the map.
+            foxxll::request_ptr req = read_it->second->req_;
+
+            LOGC(debug_em)
+                << "DestroyBlock()"
+                << " canceling read I/O request " << req
+                << " for block " << *block_ptr;
+
+            lock.unlock();
+            // cancel I/O request
+            if (!req->cancel()) {
+                // must still wait for cancellation to complete and the I/O
+                // handler.
+                req->wait();
             }
+            lock.lock();
+
+            // recheck whether block is being read, it may have been
+            // evicting again in the unlocked time.
+            continue;
         }
+
+        break;
     }
-    while (0); // NOLINT
 
-    if (block_ptr->ext_file_ && block_ptr->in_memory())
+    if (block_ptr->mapped_file_ && block_ptr->in_memory())
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " mapped block, in memory: release accounted memory.";
+
+        die_unless(d_->unpinned_blocks_.exists(block_ptr));
+        d_->unpinned_blocks_.erase(block_ptr);
+        d_->unpinned_bytes_ -= block_ptr->size();
+
+        // the pages are dropped when the MappedFile is unmapped.
+        block_ptr->data_ = nullptr;
+
+        d_->IntReleaseInternalMemory(block_ptr->size());
+    }
+    else if (block_ptr->mapped_file_)
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " mapped block, not in memory: nothing to do.";
+    }
+    else if (block_ptr->ext_file_ && block_ptr->in_memory())
     {
         LOGC(debug_blc)
             << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
@@ -1025,7 +1792,7 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
@@ -1037,6 +1804,17 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
             << " external block, but not in memory: nothing to do, thus just"
             << " delete the reference";
     }
+    else if (block_ptr->compressed_)
+    {
+        LOGC(debug_blc)
+            << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
+            << " block in compressed tier, release compressed copy";
+
+        die_unless(d_->compressed_.exists(block_ptr));
+        d_->compressed_.erase(block_ptr);
+        d_->compressed_bytes_ -= block_ptr->size();
+        d_->IntReleaseCompressed(block_ptr);
+    }
     else if (block_ptr->in_memory())
     {
         LOGC(debug_blc)
@@ -1052,7 +1830,7 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
@@ -1069,8 +1847,7 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
         d_->swapped_.erase(it);
         d_->swapped_bytes_ -= block_ptr->size();
 
-        d_->bm_->delete_block(block_ptr->em_bid_);
-        block_ptr->em_bid_ = foxxll::BID<0>();
+        d_->IntDeleteEmBlock(block_ptr);
     }
 
     assert(d_->total_byte_blocks_ > 0);
@@ -1102,12 +1879,19 @@ void BlockPool::Data::IntRequestInternalMemory(
         << " unpinned_blocks_.size()=" << unpinned_blocks_.size()
         << " swapped_.size()=" << swapped_.size();
 
+    // free slabs cached for reuse occupy RAM as well, hence unmap empty slab
+    // chunks which exceed the soft limit before evicting blocks.
+    size_t slab_cached = slab_alloc_.cached_bytes();
+    if (soft_ram_limit_ != 0 && total_ram_bytes_ + slab_cached > soft_ram_limit_)
+        slab_alloc_.ReleaseCached(
+            total_ram_bytes_ + slab_cached - soft_ram_limit_);
+
     while (soft_ram_limit_ != 0 &&
            unpinned_blocks_.size() &&
            total_ram_bytes_ + requested_bytes_ > soft_ram_limit_ + writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        IntEvictBlockLRU();
+        IntEvictBlockLRU(lock);
     }
 
     // wait up to 60 seconds for other threads to free up memory or pins
@@ -1123,7 +1907,7 @@ void BlockPool::Data::IntRequestInternalMemory(
                total_ram_bytes_ + requested_bytes_ > hard_ram_limit_ + writing_bytes_)
         {
             // evict blocks: schedule async writing which increases writing_bytes_.
-            IntEvictBlockLRU();
+            IntEvictBlockLRU(lock);
         }
 
         cv_memory_change_.wait_for(lock, std::chrono::seconds(1));
@@ -1186,7 +1970,7 @@ void BlockPool::AdviseFree(size_t size) {
            d_->total_ram_bytes_ + d_->requested_bytes_ + size > d_->hard_ram_limit_ + d_->writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        d_->IntEvictBlockLRU();
+        d_->IntEvictBlockLRU(lock);
     }
 }
 void BlockPool::ReleaseInternalMemory(size_t size) {
@@ -1205,6 +1989,11 @@ void BlockPool::Data::IntReleaseInternalMemory(size_t size) {
     total_ram_bytes_ -= size;
 
     cv_memory_change_.notify_all();
+
+    if (release_callback_) {
+        release_callback_(
+            size, soft_ram_limit_ != 0 && total_ram_bytes_ > soft_ram_limit_);
+    }
 }
 
 void BlockPool::EvictBlock(ByteBlock* block_ptr) {
@@ -1216,7 +2005,7 @@ void BlockPool::EvictBlock(ByteBlock* block_ptr) {
     d_->unpinned_blocks_.erase(block_ptr);
     d_->unpinned_bytes_ -= block_ptr->size();
 
-    d_->IntEvictBlock(block_ptr);
+    d_->IntEvictBlock(lock, block_ptr);
 }
 
 foxxll::request_ptr BlockPool::GetAnyWriting() {
@@ -1227,10 +2016,11 @@ foxxll::request_ptr BlockPool::GetAnyWriting() {
 
 foxxll::request_ptr BlockPool::EvictBlockLRU() {
     std::unique_lock<std::mutex> lock(mutex_);
-    return d_->IntEvictBlockLRU();
+    return d_->IntEvictBlockLRU(lock);
 }
 
-foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU() {
+foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU(
+    std::unique_lock<std::mutex>& lock) {
 
     if (!unpinned_blocks_.size()) return foxxll::request_ptr();
 
@@ -1238,13 +2028,29 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlockLRU() {
     die_unless(block_ptr);
     unpinned_bytes_ -= block_ptr->size();
 
-    return IntEvictBlock(block_ptr);
+    return IntEvictBlock(lock, block_ptr);
 }
 
-foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
+foxxll::request_ptr BlockPool::Data::IntEvictBlock(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
 
     // die_unless(block_ptr->block_pool_ == this);
 
+    if (block_ptr->mapped_file_) {
+        // if in mapped file -> drop pages from the mapping without writing
+
+        LOGC(debug_em)
+            << "EvictBlock(): " << block_ptr << " - " << *block_ptr
+            << " from mapped file " << block_ptr->mapped_file_;
+
+        block_ptr->mapped_file_->DontNeed(
+            block_ptr->mapped_offset_, block_ptr->size());
+        block_ptr->data_ = nullptr;
+
+        IntReleaseInternalMemory(block_ptr->size());
+        return foxxll::request_ptr();
+    }
+
     if (block_ptr->ext_file_) {
         // if in external file -> free memory without writing
 
@@ -1256,13 +2062,23 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         IntReleaseInternalMemory(block_ptr->size());
         return foxxll::request_ptr();
     }
 
+    // keep block compressed in RAM, write to EM only if it does not compress.
+    if (compressed_ram_limit_ != 0 && IntCompressBlock(lock, block_ptr))
+        return foxxll::request_ptr();
+
+    return IntWriteBlock(block_ptr, block_ptr->data_, block_ptr->size());
+}
+
+foxxll::request_ptr BlockPool::Data::IntWriteBlock(
+    ByteBlock* block_ptr, Byte* data, size_t size) {
+
     if (!notify_em_used_) {
         std::cerr << "Thrill: evicting first Block to external memory. "
             "Be aware, that unexpected" << std::endl;
@@ -1273,20 +2089,28 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
 
     die_unless(block_ptr->em_bid_.storage == nullptr);
 
-    // allocate EM block
-    block_ptr->em_bid_.size = block_ptr->size();
-    bm_->new_block(foxxll::fully_random(), block_ptr->em_bid_);
+    // allocate EM block on the selected tier
+    block_ptr->em_bid_.size = size;
+    size_t tier = block_ptr->em_tier_ = IntSelectEmTier(block_ptr);
+    if (!em_tiers_[fast_tier].available || !em_tiers_[slow_tier].available)
+        bm_->new_block(foxxll::fully_random(), block_ptr->em_bid_);
+    else if (tier == fast_tier)
+        bm_->new_block(foxxll::random_cyclic_flash(), block_ptr->em_bid_);
+    else
+        bm_->new_block(foxxll::random_cyclic_disk(), block_ptr->em_bid_);
 
     LOGC(debug_em)
         << "EvictBlock(): " << block_ptr << " - " << *block_ptr
-        << " to em_bid " << block_ptr->em_bid_;
+        << " to em_bid " << block_ptr->em_bid_ << " on tier " << tier;
 
-    writing_bytes_ += block_ptr->size();
+    em_tiers_[tier].allocated_bytes += size;
+    em_tiers_[tier].StartIo();
+    writing_bytes_ += size;
 
     // initiate writing to EM.
     foxxll::request_ptr req =
         block_ptr->em_bid_.storage->awrite(
-            block_ptr->data_, block_ptr->em_bid_.offset, block_ptr->size(),
+            data, block_ptr->em_bid_.offset, size,
             // construct an immediate CompletionHandler callback
             foxxll::completion_handler::make<
                 ByteBlock, &ByteBlock::OnWriteComplete>(block_ptr));
@@ -1294,6 +2118,197 @@ foxxll::request_ptr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
     return (writing_[block_ptr] = std::move(req));
 }
 
+size_t BlockPool::Data::IntSelectEmTier(ByteBlock* block_ptr) {
+    const EmTier& fast = em_tiers_[fast_tier];
+    if (!fast.available) return slow_tier;
+    if (!em_tiers_[slow_tier].available) return fast_tier;
+
+    bool hot =
+        block_ptr->size() < default_block_size ||
+        unpinned_blocks_.UsedWithin(
+            block_ptr->dia_id(), fast_tier_horizon);
+
+    // keep a tenth of the fast tier free for hot Blocks evicted later.
+    bool room =
+        fast.capacity == 0 ||
+        (fast.allocated_bytes + block_ptr->em_bid_.size) * 10 <=
+        fast.capacity * 9;
+
+    return hot && room ? fast_tier : slow_tier;
+}
+
+Byte* BlockPool::Data::AllocateData(size_t size) {
+    if (mem::SlabAllocator::is_slab_size(size)) {
+        if (Byte* data = static_cast<Byte*>(slab_alloc_.allocate(size)))
+            return data;
+    }
+    return aligned_alloc_.allocate(size);
+}
+
+void BlockPool::Data::DeallocateData(Byte* data, size_t size) {
+    if (mem::SlabAllocator::is_slab_size(size) && slab_alloc_.owns(data))
+        return slab_alloc_.deallocate(data, size);
+    aligned_alloc_.deallocate(data, size);
+}
+
+size_t BlockPool::Data::BindToWorkerNode(
+    Byte* data, size_t size, size_t local_worker_id) {
+    size_t node = worker_numa_node_[local_worker_id];
+    // binding parts of a huge page backed slab chunk would split huge pages
+    if (node == size_t(-1) || size < mem::SlabAllocator::chunk_size ||
+        !common::NumaBindMemory(data, size, node, /* move */ false))
+        return size_t(-1);
+    return node;
+}
+
+void BlockPool::Data::IntDeleteEmBlock(ByteBlock* block_ptr) {
+    EmTier& tier = em_tiers_[block_ptr->em_tier_];
+    die_unless(tier.allocated_bytes >= block_ptr->em_bid_.size);
+    tier.allocated_bytes -= block_ptr->em_bid_.size;
+
+    bm_->delete_block(block_ptr->em_bid_);
+    block_ptr->em_bid_ = foxxll::BID<0>();
+}
+
+bool BlockPool::Data::IntCompressBlock(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
+    size_t size = block_ptr->size();
+
+    // take an idle scratch buffer
+    std::pair<Byte*, size_t> scratch(nullptr, 0);
+    if (!compress_scratch_.empty()) {
+        scratch = compress_scratch_.back();
+        compress_scratch_.pop_back();
+    }
+
+    // compress without holding the lock, like writing a block is asynchronous.
+    // Until done, the block is counted as being written, and pins and
+    // DestroyBlock() wait in IntWaitCompressing().
+    compressing_[block_ptr] = false;
+    writing_bytes_ += size;
+    lock.unlock();
+
+    size_t bound = CompressBound(size);
+    if (scratch.second < bound) {
+        if (scratch.first)
+            mem::bypass_free(scratch.first, scratch.second);
+        scratch.first = static_cast<Byte*>(mem::bypass_malloc(bound));
+        scratch.second = scratch.first ? bound : 0;
+    }
+
+    size_t csize = scratch.first
+                   ? CompressBlock(block_ptr->data_, size,
+                                   scratch.first, scratch.second)
+                   : 0;
+
+    // keep only blocks which shrink by at least a quarter. The copy is aligned
+    // and padded such that it can be written to EM when the tier is full.
+    size_t ccap = CompressedCapacity(csize);
+    Byte* compressed = nullptr;
+    if (csize != 0 && ccap <= size - size / 4 &&
+        ccap <= compressed_ram_limit_) {
+        compressed = aligned_alloc_.allocate(ccap);
+        std::copy(scratch.first, scratch.first + csize, compressed);
+        std::fill(compressed + csize, compressed + ccap, Byte(0));
+    }
+
+    lock.lock();
+
+    if (scratch.first)
+        compress_scratch_.emplace_back(scratch);
+
+    auto it = compressing_.find(block_ptr);
+    die_unless(it != compressing_.end());
+    bool canceled = it->second;
+    compressing_.erase(it);
+    writing_bytes_ -= size;
+    cv_compress_complete_.notify_all();
+
+    if (canceled) {
+        // eviction was canceled by a pin or because the block was deleted,
+        // like a canceled write in OnWriteComplete().
+        if (compressed)
+            aligned_alloc_.deallocate(compressed, ccap);
+
+        if (!block_ptr->is_deleted()) {
+            die_unless(!unpinned_blocks_.exists(block_ptr));
+            unpinned_blocks_.put(block_ptr);
+            unpinned_bytes_ += size;
+        }
+        return true;
+    }
+
+    if (!compressed) return false;
+
+    // make room in a full tier by demoting the least recently compressed
+    // blocks to EM, instead of writing the new block there.
+    while (compressed_.size() != 0 &&
+           compressed_ram_bytes_ - demoting_ram_bytes_ + ccap >
+           compressed_ram_limit_) {
+        IntDemoteCompressedLRU();
+    }
+
+    LOGC(debug_em)
+        << "EvictBlock(): " << block_ptr << " - " << *block_ptr
+        << " compressed to " << csize << " bytes";
+
+    // release memory
+    sLOGC(debug_alloc)
+        << "ByteBlock deallocate"
+        << (void*)block_ptr->data_ << "size" << size;
+    DeallocateData(block_ptr->data_, size);
+    block_ptr->data_ = nullptr;
+
+    block_ptr->compressed_ = compressed;
+    block_ptr->compressed_size_ = csize;
+    compressed_.put(block_ptr);
+    compressed_bytes_ += size;
+    compressed_ram_bytes_ += ccap;
+
+    // the compressed copy remains accounted as internal memory.
+    IntReleaseInternalMemory(size - ccap);
+    return true;
+}
+
+bool BlockPool::Data::IntWaitCompressing(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
+    auto it = compressing_.find(block_ptr);
+    if (it == compressing_.end()) return false;
+
+    LOGC(debug_em)
+        << "BlockPool: block=" << block_ptr
+        << " is currently being compressed, canceling.";
+
+    it->second = true;
+    while (compressing_.find(block_ptr) != compressing_.end())
+        cv_compress_complete_.wait(lock);
+    return true;
+}
+
+void BlockPool::Data::IntDemoteCompressedLRU() {
+    ByteBlock* block_ptr = compressed_.pop();
+    compressed_bytes_ -= block_ptr->size();
+    demoting_ram_bytes_ += CompressedCapacity(block_ptr->compressed_size_);
+
+    LOGC(debug_em)
+        << "EvictBlock(): " << block_ptr << " - " << *block_ptr
+        << " demoting compressed copy to EM";
+
+    // OnWriteComplete() releases the compressed copy. The padding is written
+    // too, since O_DIRECT requires aligned sizes and offsets.
+    IntWriteBlock(block_ptr, block_ptr->compressed_,
+                  CompressedCapacity(block_ptr->compressed_size_));
+}
+
+void BlockPool::Data::IntReleaseCompressed(ByteBlock* block_ptr) {
+    size_t ccap = CompressedCapacity(block_ptr->compressed_size_);
+    aligned_alloc_.deallocate(block_ptr->compressed_, ccap);
+    block_ptr->compressed_ = nullptr;
+
+    compressed_ram_bytes_ -= ccap;
+    IntReleaseInternalMemory(ccap);
+}
+
 void BlockPool::OnWriteComplete(
     ByteBlock* block_ptr, foxxll::request* req, bool success) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -1306,9 +2321,31 @@ void BlockPool::OnWriteComplete(
 
     die_unless(!block_ptr->ext_file_);
     die_unequal(d_->writing_.erase(block_ptr), 1u);
-    d_->writing_bytes_ -= block_ptr->size();
+    d_->writing_bytes_ -= block_ptr->em_bid_.size;
 
-    if (!success)
+    Data::EmTier& tier = d_->em_tiers_[block_ptr->em_tier_];
+    --tier.queue_depth;
+    if (success) tier.written_bytes += block_ptr->em_bid_.size;
+
+    if (block_ptr->compressed_)
+    {
+        // demoted compressed copy from the compressed tier
+        d_->demoting_ram_bytes_ -=
+            CompressedCapacity(block_ptr->compressed_size_);
+
+        if (!success) {
+            // canceled by a pin or a deletion: keep it in the compressed tier
+            d_->compressed_.put(block_ptr);
+            d_->compressed_bytes_ += block_ptr->size();
+            d_->IntDeleteEmBlock(block_ptr);
+        }
+        else {
+            d_->swapped_.insert(block_ptr);
+            d_->swapped_bytes_ += block_ptr->size();
+            d_->IntReleaseCompressed(block_ptr);
+        }
+    }
+    else if (!success)
     {
         // request was canceled. this is not an I/O error, but intentional,
         // e.g. because the block was deleted or if it was re-pinned while being
@@ -1320,8 +2357,7 @@ void BlockPool::OnWriteComplete(
             d_->unpinned_bytes_ += block_ptr->size();
         }
 
-        d_->bm_->delete_block(block_ptr->em_bid_);
-        block_ptr->em_bid_ = foxxll::BID<0>();
+        d_->IntDeleteEmBlock(block_ptr);
     }
     else
     {
@@ -1334,7 +2370,7 @@ void BlockPool::OnWriteComplete(
         sLOGC(debug_alloc)
             << "ByteBlock deallocate"
             << (void*)block_ptr->data_ << "size" << block_ptr->size();
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->DeallocateData(block_ptr->data_, block_ptr->size());
         block_ptr->data_ = nullptr;
 
         d_->IntReleaseInternalMemory(block_ptr->size());
@@ -1342,8 +2378,16 @@ void BlockPool::OnWriteComplete(
 }
 
 void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
+    // read memory pressure without holding the lock
+    common::LinuxMemoryPressure mem_pressure;
+    bool have_pressure = common::ReadLinuxMemoryPressure(mem_pressure);
+
     std::unique_lock<std::mutex> lock(mutex_);
 
+    if (have_pressure)
+        d_->mem_pressure_ = mem_pressure;
+    d_->IntAdaptToMemoryPressure(lock, have_pressure);
+
     foxxll::stats_data stnow(*foxxll::stats::get_instance());
     foxxll::stats_data stf = stnow - d_->io_stats_first_;
     foxxll::stats_data stp = stnow - d_->io_stats_prev_;
@@ -1362,6 +2406,9 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
     size_t reading_bytes = d_->reading_bytes_.hmax_update();
     size_t pinned_bytes = d_->pin_count_.total_pinned_bytes_.hmax_update();
 
+    Data::EmTier& fast = d_->em_tiers_[Data::fast_tier];
+    Data::EmTier& slow = d_->em_tiers_[Data::slow_tier];
+
     logger_ << "class" << "BlockPool"
             << "event" << "profile"
             << "total_blocks" << d_->int_total_blocks()
@@ -1376,6 +2423,9 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "unpinned_bytes" << unpinned_bytes
             << "swapped_blocks" << d_->swapped_.size()
             << "swapped_bytes" << d_->swapped_bytes_.hmax_update()
+            << "compressed_blocks" << d_->compressed_.size()
+            << "compressed_bytes" << d_->compressed_bytes_.hmax_update()
+            << "compressed_ram_bytes" << d_->compressed_ram_bytes_.hmax_update()
             << "max_pinned_blocks" << d_->pin_count_.max_pins
             << "max_pinned_bytes" << d_->pin_count_.max_pinned_bytes
             << "writing_blocks" << d_->writing_.size()
@@ -1392,7 +2442,89 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << "wr_ops" << stp.get_write_count()
             << "wr_bytes" << stp.get_write_bytes()
             << "wr_speed" << static_cast<double>(stp.get_write_bytes()) / elapsed
-            << "disk_allocation" << d_->bm_->current_allocation();
+            << "disk_allocation" << d_->bm_->current_allocation()
+            << "slab_mapped_bytes" << d_->slab_alloc_.mapped_bytes()
+            << "slab_cached_bytes" << d_->slab_alloc_.cached_bytes()
+            << "slab_huge_chunks" << d_->slab_alloc_.huge_chunks()
+            << "fast_allocated_bytes" << fast.allocated_bytes
+            << "fast_wr_bytes" << fast.written_bytes - fast.prev_written_bytes
+            << "fast_wr_speed"
+            << static_cast<double>(fast.written_bytes - fast.prev_written_bytes) / elapsed
+            << "fast_rd_bytes" << fast.read_bytes - fast.prev_read_bytes
+            << "fast_rd_speed"
+            << static_cast<double>(fast.read_bytes - fast.prev_read_bytes) / elapsed
+            << "fast_queue_depth" << fast.queue_depth
+            << "fast_max_queue_depth" << fast.max_queue_depth
+            << "slow_allocated_bytes" << slow.allocated_bytes
+            << "slow_wr_bytes" << slow.written_bytes - slow.prev_written_bytes
+            << "slow_wr_speed"
+            << static_cast<double>(slow.written_bytes - slow.prev_written_bytes) / elapsed
+            << "slow_rd_bytes" << slow.read_bytes - slow.prev_read_bytes
+            << "slow_rd_speed"
+            << static_cast<double>(slow.read_bytes - slow.prev_read_bytes) / elapsed
+            << "slow_queue_depth" << slow.queue_depth
+            << "slow_max_queue_depth" << slow.max_queue_depth
+            << "mem_pressure_some" << d_->mem_pressure_.some_avg10
+            << "mem_pressure_full" << d_->mem_pressure_.full_avg10
+            << "mem_usage" << d_->mem_pressure_.usage
+            << "mem_cgroup_limit" << d_->mem_pressure_.limit
+            << "soft_ram_limit" << d_->soft_ram_limit_
+            << "hard_ram_limit" << d_->hard_ram_limit_;
+
+    for (Data::EmTier& tier : d_->em_tiers_) {
+        tier.prev_written_bytes = tier.written_bytes;
+        tier.prev_read_bytes = tier.read_bytes;
+        tier.max_queue_depth = tier.queue_depth;
+    }
+}
+
+void BlockPool::Data::IntAdaptToMemoryPressure(
+    std::unique_lock<std::mutex>& lock, bool have_pressure) {
+    if (!have_pressure || base_soft_ram_limit_ == 0)
+        return;
+
+    const common::LinuxMemoryPressure& mp = mem_pressure_;
+
+    bool high = mp.some_avg10 >= high_pressure ||
+                (mp.limit != 0 && mp.usage > mp.limit / 10 * 9);
+    bool low = mp.some_avg10 < low_pressure &&
+               (mp.limit == 0 || mp.usage < mp.limit / 4 * 3);
+
+    double factor = ram_limit_factor_;
+    if (high)
+        factor = std::max(min_ram_limit_factor, factor * 0.8);
+    else if (low)
+        factor = std::min(1.0, factor * 1.1);
+
+    if (factor == ram_limit_factor_)
+        return;
+
+    ram_limit_factor_ = factor;
+    soft_ram_limit_ = static_cast<size_t>(
+        static_cast<double>(base_soft_ram_limit_) * factor);
+    // the hard limit must stay above the pinned Blocks, which cannot be
+    // evicted, else memory requests would wait forever.
+    hard_ram_limit_ = std::max<size_t>(
+        static_cast<size_t>(static_cast<double>(base_hard_ram_limit_) * factor),
+        pin_count_.total_pinned_bytes_);
+
+    LOG << "BlockPool: memory pressure"
+        << " some=" << mp.some_avg10 << "% full=" << mp.full_avg10 << "%"
+        << " usage=" << mp.usage << " limit=" << mp.limit
+        << ", scaling RAM limits by " << factor
+        << " to soft_ram_limit_=" << soft_ram_limit_
+        << " hard_ram_limit_=" << hard_ram_limit_;
+
+    // evict unpinned Blocks beyond the lowered soft limit now, instead of
+    // waiting for the next memory request (or the kernel's OOM killer).
+    while (unpinned_blocks_.size() &&
+           total_ram_bytes_ + requested_bytes_ > soft_ram_limit_ + writing_bytes_)
+    {
+        IntEvictBlockLRU(lock);
+    }
+
+    // raised limits may unblock waiting memory requests
+    cv_memory_change_.notify_all();
 }
 
 size_t BlockPool::next_file_id() {
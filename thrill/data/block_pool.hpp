@@ -70,10 +70,15 @@ public:
      * allocated. the BlockPool will create a child manager.
      *
      * \param workers_per_host number of workers on this host.
+     *
+     * \param compressed_ram_limit amount (bytes) of RAM in which evicted
+     * ByteBlocks are kept compressed. When it is full, the oldest compressed
+     * ByteBlocks are written to disk. Enter 0 to disable the compressed tier.
      */
     BlockPool(size_t soft_ram_limit, size_t hard_ram_limit,
               common::JsonLogger* logger,
-              mem::Manager* mem_manager, size_t workers_per_host);
+              mem::Manager* mem_manager, size_t workers_per_host,
+              size_t compressed_ram_limit = 0);
 
     //! Checks that all blocks were freed
     ~BlockPool();
@@ -117,10 +122,17 @@ public:
     ByteBlockPtr MapExternalBlock(
         const foxxll::file_ptr& file, uint64_t offset, size_t size);
 
+    //! Allocate a byte block which points into a memory mapped file, used to
+    //! map local system files to data::File without copying them.
+    ByteBlockPtr MapMappedBlock(
+        const MappedFilePtr& file, uint64_t offset, size_t size);
+
     //! Increment a ByteBlock's pin count, requires the pin count to be > 0.
+    //! Does not lock the BlockPool.
     void IncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
-    //! Decrement a ByteBlock's pin count and possibly unpin it.
+    //! Decrement a ByteBlock's pin count and possibly unpin it. Locks the
+    //! BlockPool only if the worker's last pin on the ByteBlock is released.
     void DecBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
     //! Destroys the block. Called by ByteBlockPtr's deleter.
@@ -133,9 +145,16 @@ public:
     //! \name Block Statistics
     //! \{
 
+    //! Soft limit on amount of memory used for ByteBlock
+    size_t soft_ram_limit() noexcept;
+
     //! Hard limit on amount of memory used for ByteBlock
     size_t hard_ram_limit() noexcept;
 
+    //! Total number of bytes currently used in RAM by ByteBlocks and reserved
+    //! internal memory
+    size_t total_ram_bytes() noexcept;
+
     //! Total number of allocated blocks of this block pool
     size_t total_blocks() noexcept;
 
@@ -160,6 +179,22 @@ public:
     //! Total number of blocks currently begin read from EM.
     size_t reading_blocks() noexcept;
 
+    //! Total number of evicted blocks kept compressed in RAM
+    size_t compressed_blocks() noexcept;
+
+    //! Number of bytes allocated in an external memory tier: 0 is the fast
+    //! tier of disks flagged "flash", 1 the slow tier of all other disks.
+    size_t em_tier_bytes(size_t tier) noexcept;
+
+    //! Total number of bytes written to an external memory tier
+    size_t em_tier_written_bytes(size_t tier) noexcept;
+
+    //! Total number of bytes read from an external memory tier
+    size_t em_tier_read_bytes(size_t tier) noexcept;
+
+    //! Number of I/O requests in flight on an external memory tier
+    size_t em_tier_queue_depth(size_t tier) noexcept;
+
     //! \}
 
     //! \name Methods for ProfileTask
@@ -176,6 +211,64 @@ public:
     //! files. additionally calculate the prefetch size of each File.
     std::pair<size_t, size_t> MaxMergeDegreePrefetch(size_t num_files);
 
+    //! \name Prefetch Budget
+    //! \{
+
+    //! Reserve up to size bytes of the worker's budget for prefetching Blocks,
+    //! which is half of its share of the hard RAM limit, like in
+    //! MaxMergeDegreePrefetch(). Returns the number of bytes granted, which is
+    //! always size if force is set.
+    size_t ReservePrefetch(size_t local_worker_id, size_t size,
+                           bool force = false);
+
+    //! Release bytes reserved with ReservePrefetch().
+    void ReleasePrefetch(size_t local_worker_id, size_t size);
+
+    //! \}
+
+    //! \name Eviction Hints
+    //! \{
+
+    //! Set the Stage number at which the Blocks in Files of DIANode dia_id are
+    //! used next. Unpinned Blocks are evicted approximating Belady's algorithm:
+    //! first those without known future use, then those used furthest ahead.
+    void SetNextUse(size_t dia_id, size_t stage);
+
+    //! Advance the number of the currently running Stage, which makes earlier
+    //! next-use hints obsolete.
+    void AdvanceStage(size_t stage);
+
+    //! \}
+
+    //! \name Memory Release Notification
+    //! \{
+
+    //! callback with the number of bytes released and whether the BlockPool
+    //! remains above its soft limit.
+    using ReleaseCallback =
+        std::function<void(size_t size, bool above_soft_limit)>;
+
+    //! Set a callback which is called whenever ByteBlocks or reserved internal
+    //! memory are released, e.g. by eviction or by a reader consuming Blocks.
+    //! It is called while the BlockPool is locked, hence it must not call the
+    //! BlockPool. Pass nullptr to remove it.
+    void SetReleaseCallback(const ReleaseCallback& callback);
+
+    //! \}
+
+    //! \name NUMA Placement
+    //! \{
+
+    //! Set the NUMA node of a worker's cpu. ByteBlocks allocated or swapped in
+    //! for the worker prefer memory of this node.
+    void SetWorkerNumaNode(size_t local_worker_id, size_t numa_node);
+
+    //! Migrate the pages of a full pinned Block to the NUMA node of the worker
+    //! which is going to consume it, if that node differs.
+    void MigrateToWorker(const PinnedBlock& block, size_t local_worker_id);
+
+    //! \}
+
 private:
     //! locked before internal state is changed
     std::mutex mutex_;
@@ -199,6 +292,9 @@ private:
     //! substructure containing pin counters
     struct PinCount;
 
+    //! set of unpinned ByteBlocks ordered for eviction
+    class EvictionSet;
+
     //! pimpl data structure
     class Data;
 
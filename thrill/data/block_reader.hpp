@@ -15,15 +15,21 @@
 #include <thrill/common/config.hpp>
 #include <thrill/common/item_serialization_tools.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/span.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/serialization.hpp>
 
 #include <tlx/define.hpp>
+#include <tlx/container/string_view.hpp>
 #include <tlx/die.hpp>
 #include <tlx/string/hexdump.hpp>
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -91,19 +97,21 @@ public:
         assert(num_items_ > 0);
         --num_items_;
 
-        if (self_verify && typecode_verify_) {
-            // for self-verification, T is prefixed with its hash code
-            size_t code = GetRaw<size_t>();
-            if (code != typeid(T).hash_code()) {
-                die("BlockReader::Next() attempted to retrieve item "
-                    "with different typeid! - expected "
-                    << tlx::hexdump_type(typeid(T).hash_code())
-                    << " got " << tlx::hexdump_type(code));
-            }
-        }
+        VerifyTypecode<T>();
         return Serialization<BlockReader, T>::Deserialize(*this);
     }
 
+    //! NextStringView() reads a complete std::string item without allocating
+    //! it, see GetStringView() for how long the view is valid.
+    tlx::string_view NextStringView() {
+        assert(HasNext());
+        assert(num_items_ > 0);
+        --num_items_;
+
+        VerifyTypecode<std::string>();
+        return GetStringView();
+    }
+
     //! Next() reads a complete item T, without item counter or self
     //! verification
     template <typename T>
@@ -113,6 +121,51 @@ public:
         return Serialization<BlockReader, T>::Deserialize(*this);
     }
 
+    /*!
+     * NextSpan() returns up to max_items items of type T, which must be
+     * serialized as raw bytes, as a span directly over the pinned Block
+     * memory. The span contains only items which lie completely in the current
+     * Block and stays valid until the next reading call. It is empty if no more
+     * items are available, or if the next item straddles a Block boundary, is
+     * not aligned to alignof(T) in memory, or is prefixed with a
+     * self-verification typecode; then read it with Next().
+     */
+    template <typename T>
+    TLX_ATTRIBUTE_ALWAYS_INLINE
+    common::Span<const T> NextSpan(
+        size_t max_items = std::numeric_limits<size_t>::max()) {
+        static_assert(is_raw_serialized<T>::value,
+                      "NextSpan() requires items serialized as raw bytes.");
+
+        if (!HasNext() || (self_verify && typecode_verify_))
+            return common::Span<const T>();
+
+        // items after odd-sized items or in Blocks of odd size are unaligned
+        if (reinterpret_cast<uintptr_t>(current_) % alignof(T) != 0)
+            return common::Span<const T>();
+
+        size_t n = std::min(
+            std::min(max_items, num_items_),
+            static_cast<size_t>(end_ - current_) / sizeof(T));
+
+        const T* begin = reinterpret_cast<const T*>(current_);
+        current_ += n * sizeof(T);
+        num_items_ -= n;
+        return common::Span<const T>(begin, n);
+    }
+
+    /*!
+     * Read all remaining items and call functor f(const T&) for each. For
+     * items serialized as raw bytes, this runs over spans of the Blocks
+     * without per item boundary checks, and std::string items are read into
+     * one reused string instead of allocating each.
+     */
+    template <typename T, typename Functor>
+    void ForEach(Functor&& f) {
+        ForEachImpl<T>(std::forward<Functor>(f), is_raw_serialized<T>(),
+                       std::is_same<T, std::string>());
+    }
+
     //! HasNext() returns true if at least one more item is available.
     TLX_ATTRIBUTE_ALWAYS_INLINE
     bool HasNext() {
@@ -309,6 +362,27 @@ public:
         return *this;
     }
 
+    /*!
+     * Fetch a string written by PutString() as a view without allocating. If
+     * the string lies completely in the current Block, the view points into the
+     * pinned Block, otherwise it is assembled in a buffer of the reader. Either
+     * way, the view is valid only until the next call of the reader, including
+     * HasNext(), which may release the Block.
+     */
+    tlx::string_view GetStringView() {
+        size_t size = this->GetVarint();
+
+        if (TLX_LIKELY(current_ + size <= end_)) {
+            const char* begin = reinterpret_cast<const char*>(current_);
+            current_ += size;
+            return tlx::string_view(begin, size);
+        }
+
+        string_buffer_.resize(size);
+        Read(&string_buffer_[0], size);
+        return tlx::string_view(string_buffer_.data(), size);
+    }
+
     //! Fetch a single byte from the current block, advancing the cursor.
     Byte GetByte() {
         // loop, since blocks can actually be empty.
@@ -367,6 +441,60 @@ private:
     //! BlockReader, this is false to needed to read external files.
     bool typecode_verify_;
 
+    //! buffer of GetStringView() for strings straddling Blocks
+    std::string string_buffer_;
+
+    //! check the hash code prefixed to items in self-verification mode
+    template <typename T>
+    TLX_ATTRIBUTE_ALWAYS_INLINE
+    void VerifyTypecode() {
+        if (self_verify && typecode_verify_) {
+            // for self-verification, T is prefixed with its hash code
+            size_t code = GetRaw<size_t>();
+            if (code != typeid(T).hash_code()) {
+                die("BlockReader::Next() attempted to retrieve item "
+                    "with different typeid! - expected "
+                    << tlx::hexdump_type(typeid(T).hash_code())
+                    << " got " << tlx::hexdump_type(code));
+            }
+        }
+    }
+
+    //! ForEach() for items serialized as raw bytes: iterate over spans.
+    template <typename T, typename Functor>
+    void ForEachImpl(Functor&& f, std::true_type /* raw */,
+                     std::false_type /* string */) {
+        while (HasNext()) {
+            common::Span<const T> span = NextSpan<T>();
+            if (TLX_UNLIKELY(span.empty())) {
+                f(Next<T>());
+                continue;
+            }
+            for (const T& item : span)
+                f(item);
+        }
+    }
+
+    //! ForEach() for std::string items: assign views to a reused string.
+    template <typename T, typename Functor>
+    void ForEachImpl(Functor&& f, std::false_type /* raw */,
+                     std::true_type /* string */) {
+        std::string item;
+        while (HasNext()) {
+            tlx::string_view view = NextStringView();
+            item.assign(view.data(), view.size());
+            f(static_cast<const std::string&>(item));
+        }
+    }
+
+    //! ForEach() for all other items: deserialize one at a time.
+    template <typename T, typename Functor>
+    void ForEachImpl(Functor&& f, std::false_type /* raw */,
+                     std::false_type /* string */) {
+        while (HasNext())
+            f(Next<T>());
+    }
+
     //! Call source_.NextBlock with appropriate parameters
     bool NextBlock() {
         // first release old pin.
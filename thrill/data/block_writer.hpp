@@ -334,6 +334,56 @@ public:
         return *this;
     }
 
+    /*!
+     * PutBatch appends n complete items from an array. Items serialized as raw
+     * bytes are copied in bulk into the Blocks, only items straddling a Block
+     * boundary are written individually. All other items, sinks whose
+     * allocation can fail, and self-verifying builds fall back to Put().
+     */
+    template <typename T>
+    BlockWriter& PutBatch(const T* items, size_t n) {
+        assert(!closed_);
+
+        if (!is_raw_serialized<T>::value || self_verify ||
+            BlockSink::allocate_can_fail_) {
+            for (size_t i = 0; i < n; ++i)
+                Put<T>(items[i]);
+            return *this;
+        }
+
+        try {
+            while (n != 0) {
+                if (TLX_UNLIKELY(current_ == end_))
+                    Flush(), AllocateBlock();
+
+                size_t fit = std::min(
+                    n, static_cast<size_t>(end_ - current_) / sizeof(T));
+
+                if (TLX_UNLIKELY(fit == 0)) {
+                    // next item straddles the Block boundary
+                    PutUnsafe<T>(*items);
+                    ++items, --n;
+                    continue;
+                }
+
+                if (TLX_UNLIKELY(nitems_ == 0))
+                    first_offset_ = current_ - bytes_->begin();
+
+                std::copy(reinterpret_cast<const Byte*>(items),
+                          reinterpret_cast<const Byte*>(items + fit), current_);
+                current_ += fit * sizeof(T);
+                nitems_ += fit;
+                items += fit, n -= fit;
+            }
+        }
+        catch (FullException&) {
+            throw std::runtime_error(
+                      "BlockSink was full even though declared infinite");
+        }
+
+        return *this;
+    }
+
     //! \}
 
     //! \name Appending Write Functions
@@ -17,6 +17,7 @@
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace thrill {
 namespace data {
@@ -42,6 +43,16 @@ ByteBlock::ByteBlock(
       ext_file_(ext_file)
 { }
 
+ByteBlock::ByteBlock(
+    BlockPool* block_pool, const MappedFilePtr& mapped_file,
+    uint64_t offset, size_t size)
+    : data_(nullptr), size_(size),
+      block_pool_(block_pool),
+      pin_count_(block_pool_->workers_per_host()),
+      mapped_file_(mapped_file),
+      mapped_offset_(offset)
+{ }
+
 void ByteBlock::Deleter::operator () (ByteBlock* bb) const {
     sLOG << "ByteBlock[" << bb << "]::deleter()"
          << "pin_count_" << bb->pin_count_str();
@@ -61,7 +72,8 @@ void ByteBlock::Deleter::operator () (const ByteBlock* bb) const {
 }
 
 std::string ByteBlock::pin_count_str() const {
-    return "[" + tlx::join(',', pin_count_) + "]";
+    std::vector<size_t> pin_count(pin_count_.begin(), pin_count_.end());
+    return "[" + tlx::join(',', pin_count) + "]";
 }
 
 void ByteBlock::IncPinCount(size_t local_worker_id) {
@@ -81,8 +93,10 @@ std::ostream& operator << (std::ostream& os, const ByteBlock& b) {
        << " data_=" << static_cast<const void*>(b.data_)
        << " size_=" << b.size_
        << " block_pool_=" << b.block_pool_
-       << " total_pins_=" << b.total_pins_
-       << " ext_file_=" << b.ext_file_;
+       << " total_pins_=" << b.total_pins_.load()
+       << " ext_file_=" << b.ext_file_
+       << " mapped_file_=" << b.mapped_file_
+       << " compressed_size_=" << b.compressed_size_;
     return os << "]";
 }
 
@@ -12,12 +12,14 @@
 #ifndef THRILL_DATA_BYTE_BLOCK_HEADER
 #define THRILL_DATA_BYTE_BLOCK_HEADER
 
+#include <thrill/data/mapped_file.hpp>
 #include <thrill/mem/pool.hpp>
 
 #include <foxxll/io/file.hpp>
 #include <foxxll/mng/bid.hpp>
 #include <tlx/counting_ptr.hpp>
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -86,6 +88,9 @@ public:
     //! Returns whether the ByteBlock is in an external file.
     bool has_ext_file() const { return ext_file_.get() != nullptr; }
 
+    //! Returns whether the ByteBlock points into a MappedFile.
+    bool is_mapped() const { return mapped_file_.get() != nullptr; }
+
     //! return current pin count
     size_t pin_count(size_t local_worker_id) const {
         return pin_count_[local_worker_id];
@@ -104,6 +109,12 @@ public:
         return pin_count_.empty();
     }
 
+    //! DIANode whose File last received this ByteBlock, used as eviction hint
+    size_t dia_id() const { return dia_id_; }
+
+    //! set DIANode whose File holds this ByteBlock
+    void set_dia_id(size_t dia_id) { dia_id_ = dia_id; }
+
     //! increment pin count, must be >= 1 before.
     void IncPinCount(size_t local_worker_id);
 
@@ -121,21 +132,55 @@ private:
     //! reference to BlockPool for deletion.
     BlockPool* block_pool_;
 
-    //! counts the number of pins in this block per thread_id.
-    std::vector<size_t, mem::GPoolAllocator<size_t> > pin_count_;
+    //! counts the number of pins in this block per thread_id. The counters are
+    //! atomic such that BlockPool can change a worker's pins without locking as
+    //! long as they do not drop to zero.
+    std::vector<std::atomic<size_t>,
+                mem::GPoolAllocator<std::atomic<size_t> > > pin_count_;
 
     //! counts the total number of pins, the data_ may be swapped out when this
     //! reaches zero.
-    size_t total_pins_ = 0;
+    std::atomic<size_t> total_pins_ { 0 };
+
+    //! DIANode whose File last received this ByteBlock, 0 if unknown.
+    std::atomic<size_t> dia_id_ { 0 };
+
+    //! preferred NUMA node of data_, or size_t(-1) if unknown.
+    std::atomic<size_t> numa_node_ { size_t(-1) };
+
+    //! DIANode id under which the ByteBlock is listed in BlockPool's eviction
+    //! set while it is unpinned.
+    size_t eviction_dia_id_ = 0;
+
+    //! time at which the ByteBlock was listed in BlockPool's eviction set,
+    //! orders its Blocks without next-use hint by LRU.
+    size_t eviction_seq_ = 0;
 
     //! external memory block, which contains a pointer to foxxll::file, an
     //! offset into the file, and (unfortunately) also the size.
     foxxll::BID<0> em_bid_;
 
+    //! BlockPool's external memory tier on which em_bid_ was allocated.
+    size_t em_tier_ = 0;
+
     //! shared pointer to external file, if this is != nullptr then the Block
     //! was created for directly reading binary files.
     foxxll::file_ptr ext_file_;
 
+    //! memory mapped file, if this is != nullptr then data_ points into the
+    //! mapping while the ByteBlock is in memory.
+    MappedFilePtr mapped_file_;
+
+    //! offset of the ByteBlock in mapped_file_
+    uint64_t mapped_offset_ = 0;
+
+    //! compressed copy of data_ while the ByteBlock is held in BlockPool's
+    //! compressed tier, otherwise nullptr.
+    Byte* compressed_ = nullptr;
+
+    //! size of the compressed copy in bytes
+    size_t compressed_size_ = 0;
+
     // BlockPool is a friend to call ctor and to manipulate data_.
     friend class BlockPool;
     // Block is a friend to call {Increase,Reduce}PinCount()
@@ -162,6 +207,10 @@ private:
     ByteBlock(BlockPool* block_pool, const foxxll::file_ptr& ext_file,
               int64_t offset, size_t size);
 
+    //! Constructor to initialize ByteBlock as a view of a MappedFile area.
+    ByteBlock(BlockPool* block_pool, const MappedFilePtr& mapped_file,
+              uint64_t offset, size_t size);
+
     friend std::ostream& operator << (std::ostream& os, const ByteBlock& b);
 
     //! forwarded to block_pool_
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace thrill {
@@ -35,7 +36,7 @@ CatStreamData::CatStreamData(StreamSetBase* stream_set_base,
     remaining_closing_blocks_ = (num_hosts() - 1) * workers_per_host();
 
     queues_.reserve(num_workers());
-    seq_.resize(num_workers());
+    seq_ = std::vector<SeqReordering>(num_workers());
 
     // construct StreamSink array
     for (size_t host = 0; host < num_hosts(); ++host) {
@@ -238,12 +239,18 @@ struct CatStreamData::SeqReordering {
 
     //! queue of waiting Blocks, ordered by sequence number
     std::map<uint32_t, Block> waiting_;
+
+    //! Blocks from one sender may be delivered concurrently by several
+    //! DispatcherThreads if the connection is striped.
+    std::mutex                mutex_;
 };
 
 void CatStreamData::OnStreamBlock(size_t from, uint32_t seq, Block&& b) {
     assert(from < queues_.size());
     rx_timespan_.StartEventually();
 
+    std::unique_lock<std::mutex> lock(seq_[from].mutex_);
+
     LOG << "OnCatStreamBlock"
         << " from=" << from
         << " seq=" << seq
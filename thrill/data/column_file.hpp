@@ -0,0 +1,630 @@
+/*******************************************************************************
+ * thrill/data/column_file.hpp
+ *
+ * Columnar (struct-of-arrays) storage of std::tuple items in one File per
+ * column, with lightweight per-column encodings.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_COLUMN_FILE_HEADER
+#define THRILL_DATA_COLUMN_FILE_HEADER
+
+#include <thrill/data/file.hpp>
+#include <thrill/data/serialization.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+//! Encodings of the pages of a column in a ColumnFile.
+enum class ColumnEncoding : uint8_t {
+    //! raw item bytes
+    Plain = 0,
+    //! sorted dictionary of distinct items and 1 or 2 byte indexes into it
+    Dictionary = 1,
+    //! pairs of (run length, item)
+    RunLength = 2,
+    //! minimum item and the differences to it in as few bytes as needed, only
+    //! for integral types.
+    FrameOfReference = 3,
+    //! choose the encoding with the smallest size for each page
+    Auto = 255
+};
+
+namespace detail {
+
+//! whether frame-of-reference encoding applies to items of type T
+template <typename T>
+struct can_frame_of_reference
+    : public std::integral_constant<
+          bool, std::is_integral<T>::value && !std::is_same<T, bool>::value> { };
+
+/*!
+ * Encoder and decoder for pages of items of a column. A page is stored as a
+ * single item in the column's File: the encoding byte, the number of items and
+ * the encoded payload. Items are compared by their raw bytes, since all column
+ * types are serialized as raw bytes.
+ */
+template <typename T>
+class ColumnPageCodec
+{
+public:
+    static_assert(is_raw_serialized<T>::value,
+                  "ColumnFile columns must be serialized as raw bytes.");
+
+    //! write a page using the given encoding, or the smallest if Auto.
+    template <typename Writer>
+    static void Encode(const std::vector<T>& page, ColumnEncoding encoding,
+                       Writer& writer) {
+        if (encoding == ColumnEncoding::Auto)
+            encoding = Choose(page);
+
+        // dictionary indexes have at most two bytes: store pages with more
+        // distinct items plainly, which is what Auto would do.
+        if (encoding == ColumnEncoding::Dictionary &&
+            MakeDictionary(page).size() > max_dictionary_size)
+            encoding = ColumnEncoding::Plain;
+
+        writer.MarkItem();
+        writer.PutByte(static_cast<Byte>(encoding));
+        writer.PutVarint(page.size());
+
+        switch (encoding) {
+        case ColumnEncoding::Dictionary:
+            return EncodeDictionary(page, writer);
+        case ColumnEncoding::RunLength:
+            return EncodeRunLength(page, writer);
+        case ColumnEncoding::FrameOfReference:
+            return EncodeFrameOfReference(
+                page, writer, can_frame_of_reference<T>());
+        default:
+            writer.Append(page.data(), page.size() * sizeof(T));
+        }
+    }
+
+    //! read the next page into the (cleared) vector page.
+    template <typename Reader>
+    static void Decode(Reader& reader, std::vector<T>& page) {
+        ColumnEncoding encoding = static_cast<ColumnEncoding>(reader.GetByte());
+        page.resize(reader.GetVarint());
+
+        switch (encoding) {
+        case ColumnEncoding::Plain:
+            reader.Read(page.data(), page.size() * sizeof(T));
+            return;
+        case ColumnEncoding::Dictionary:
+            return DecodeDictionary(reader, page);
+        case ColumnEncoding::RunLength:
+            return DecodeRunLength(reader, page);
+        case ColumnEncoding::FrameOfReference:
+            return DecodeFrameOfReference(
+                reader, page, can_frame_of_reference<T>());
+        default:
+            die("ColumnFile: invalid column page encoding "
+                << static_cast<unsigned>(encoding));
+        }
+    }
+
+    //! the encoding with the smallest encoded page size
+    static ColumnEncoding Choose(const std::vector<T>& page) {
+        ColumnEncoding best = ColumnEncoding::Plain;
+        size_t best_size = page.size() * sizeof(T);
+
+        auto consider = [&](ColumnEncoding e, size_t size) {
+                            if (size < best_size)
+                                best = e, best_size = size;
+                        };
+
+        consider(ColumnEncoding::RunLength, RunLengthSize(page));
+        consider(ColumnEncoding::Dictionary, DictionarySize(page));
+        consider(ColumnEncoding::FrameOfReference,
+                 FrameOfReferenceSize(page, can_frame_of_reference<T>()));
+
+        return best;
+    }
+
+private:
+    //! maximum number of distinct items of a dictionary encoded page
+    static constexpr size_t max_dictionary_size = 65536;
+
+    static bool Equal(const T& a, const T& b) {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    static bool Less(const T& a, const T& b) {
+        return std::memcmp(&a, &b, sizeof(T)) < 0;
+    }
+
+    static size_t VarintSize(size_t v) {
+        size_t size = 1;
+        while (v >= 128) v >>= 7, ++size;
+        return size;
+    }
+
+    //! number of bytes needed to store values up to v
+    static size_t ByteWidth(uint64_t v) {
+        size_t width = 0;
+        while (v != 0) v >>= 8, ++width;
+        return width;
+    }
+
+    template <typename Writer>
+    static void PutWidth(Writer& writer, uint64_t v, size_t width) {
+        for (size_t i = 0; i < width; ++i, v >>= 8)
+            writer.PutByte(static_cast<Byte>(v & 0xFF));
+    }
+
+    template <typename Reader>
+    static uint64_t GetWidth(Reader& reader, size_t width) {
+        uint64_t v = 0;
+        for (size_t i = 0; i < width; ++i)
+            v |= static_cast<uint64_t>(reader.GetByte()) << (8 * i);
+        return v;
+    }
+
+    /**************************************************************************/
+
+    static size_t RunLengthSize(const std::vector<T>& page) {
+        size_t size = 0;
+        for (size_t i = 0; i < page.size(); ) {
+            size_t j = i + 1;
+            while (j < page.size() && Equal(page[i], page[j])) ++j;
+            size += VarintSize(j - i) + sizeof(T);
+            i = j;
+        }
+        return size;
+    }
+
+    template <typename Writer>
+    static void EncodeRunLength(const std::vector<T>& page, Writer& writer) {
+        for (size_t i = 0; i < page.size(); ) {
+            size_t j = i + 1;
+            while (j < page.size() && Equal(page[i], page[j])) ++j;
+            writer.PutVarint(j - i);
+            writer.Append(&page[i], sizeof(T));
+            i = j;
+        }
+    }
+
+    template <typename Reader>
+    static void DecodeRunLength(Reader& reader, std::vector<T>& page) {
+        for (size_t i = 0; i < page.size(); ) {
+            size_t run = reader.GetVarint();
+            die_unless(run != 0 && i + run <= page.size());
+            T item;
+            reader.Read(&item, sizeof(T));
+            std::fill(page.begin() + i, page.begin() + i + run, item);
+            i += run;
+        }
+    }
+
+    /**************************************************************************/
+
+    //! sorted distinct items of the page
+    static std::vector<T> MakeDictionary(const std::vector<T>& page) {
+        std::vector<T> dict = page;
+        std::sort(dict.begin(), dict.end(), Less);
+        dict.erase(std::unique(dict.begin(), dict.end(), Equal), dict.end());
+        return dict;
+    }
+
+    static size_t DictionarySize(const std::vector<T>& page) {
+        // dictionary encoding only pays off for few distinct items
+        if (page.empty() || sizeof(T) <= 1)
+            return page.size() * sizeof(T);
+        size_t dict_size = MakeDictionary(page).size();
+        if (dict_size > max_dictionary_size)
+            return page.size() * sizeof(T);
+        return VarintSize(dict_size) + dict_size * sizeof(T) + 1
+               + page.size() * ByteWidth(dict_size - 1);
+    }
+
+    template <typename Writer>
+    static void EncodeDictionary(const std::vector<T>& page, Writer& writer) {
+        std::vector<T> dict = MakeDictionary(page);
+        die_unless(dict.size() <= max_dictionary_size);
+        size_t width = dict.empty() ? 0 : ByteWidth(dict.size() - 1);
+
+        writer.PutVarint(dict.size());
+        writer.Append(dict.data(), dict.size() * sizeof(T));
+        writer.PutByte(static_cast<Byte>(width));
+
+        for (const T& item : page) {
+            size_t index =
+                std::lower_bound(dict.begin(), dict.end(), item, Less)
+                - dict.begin();
+            PutWidth(writer, index, width);
+        }
+    }
+
+    template <typename Reader>
+    static void DecodeDictionary(Reader& reader, std::vector<T>& page) {
+        std::vector<T> dict(reader.GetVarint());
+        reader.Read(dict.data(), dict.size() * sizeof(T));
+        size_t width = reader.GetByte();
+
+        for (T& item : page) {
+            size_t index = GetWidth(reader, width);
+            die_unless(index < dict.size());
+            item = dict[index];
+        }
+    }
+
+    /**************************************************************************/
+
+    using Unsigned = typename std::conditional<
+              can_frame_of_reference<T>::value,
+              std::make_unsigned<T>, std::common_type<uint64_t> >::type::type;
+
+    //! minimum item and difference between maximum and minimum
+    static std::pair<T, uint64_t> FrameOfReferenceRange(
+        const std::vector<T>& page) {
+        auto minmax = std::minmax_element(page.begin(), page.end());
+        return std::make_pair(
+            *minmax.first,
+            static_cast<uint64_t>(static_cast<Unsigned>(
+                                      static_cast<Unsigned>(*minmax.second) -
+                                      static_cast<Unsigned>(*minmax.first))));
+    }
+
+    static size_t FrameOfReferenceSize(
+        const std::vector<T>& page, std::true_type) {
+        if (page.empty()) return 0;
+        return sizeof(T) + 1 +
+               page.size() * ByteWidth(FrameOfReferenceRange(page).second);
+    }
+
+    static size_t FrameOfReferenceSize(
+        const std::vector<T>& page, std::false_type) {
+        return page.size() * sizeof(T);
+    }
+
+    template <typename Writer>
+    static void EncodeFrameOfReference(
+        const std::vector<T>& page, Writer& writer, std::true_type) {
+        if (page.empty()) return;
+        std::pair<T, uint64_t> range = FrameOfReferenceRange(page);
+        size_t width = ByteWidth(range.second);
+
+        writer.Append(&range.first, sizeof(T));
+        writer.PutByte(static_cast<Byte>(width));
+
+        for (const T& item : page) {
+            PutWidth(writer,
+                     static_cast<Unsigned>(static_cast<Unsigned>(item) -
+                                           static_cast<Unsigned>(range.first)),
+                     width);
+        }
+    }
+
+    template <typename Writer>
+    static void EncodeFrameOfReference(
+        const std::vector<T>&, Writer&, std::false_type) {
+        die("ColumnFile: frame-of-reference encoding of a non-integral type");
+    }
+
+    template <typename Reader>
+    static void DecodeFrameOfReference(
+        Reader& reader, std::vector<T>& page, std::true_type) {
+        if (page.empty()) return;
+        T base;
+        reader.Read(&base, sizeof(T));
+        size_t width = reader.GetByte();
+
+        for (T& item : page) {
+            item = static_cast<T>(
+                static_cast<Unsigned>(base) +
+                static_cast<Unsigned>(GetWidth(reader, width)));
+        }
+    }
+
+    template <typename Reader>
+    static void DecodeFrameOfReference(Reader&, std::vector<T>&,
+                                       std::false_type) {
+        die("ColumnFile: frame-of-reference encoding of a non-integral type");
+    }
+};
+
+} // namespace detail
+
+/*!
+ * A ColumnFile stores items of type std::tuple<Columns...> column-wise: each
+ * column is a separate File containing encoded pages of up to page_items
+ * values. Hence, reading only some columns via GetReader<Indexes...>() touches
+ * only the Blocks of those columns, and the per-page encodings (see
+ * ColumnEncoding) shrink columns with few distinct values, long runs, or small
+ * value ranges, which also reduces the volume of spilled Blocks.
+ *
+ * All column types must be serialized as raw bytes (see is_raw_serialized).
+ */
+template <typename... Columns>
+class ColumnFile
+{
+public:
+    using Tuple = std::tuple<Columns...>;
+
+    static constexpr size_t num_columns = sizeof ... (Columns);
+
+    //! type of column Index
+    template <size_t Index>
+    using ColumnType = typename std::tuple_element<Index, Tuple>::type;
+
+    //! default number of items per encoded page
+    static constexpr size_t default_page_items = 4096;
+
+    ColumnFile(BlockPool& block_pool, size_t local_worker_id, size_t dia_id,
+               size_t page_items = default_page_items,
+               ColumnEncoding encoding = ColumnEncoding::Auto)
+        : page_items_(page_items) {
+        die_unless(page_items_ > 0);
+        columns_.reserve(num_columns);
+        for (size_t i = 0; i < num_columns; ++i)
+            columns_.emplace_back(block_pool, local_worker_id, dia_id);
+        encodings_.resize(num_columns, encoding);
+    }
+
+    //! set the encoding of column index for subsequently written pages
+    void set_encoding(size_t index, ColumnEncoding encoding) {
+        assert(index < num_columns);
+        encodings_[index] = encoding;
+    }
+
+    //! number of tuples in the ColumnFile
+    size_t num_items() const { return num_items_; }
+
+    //! whether the ColumnFile contains no tuples
+    bool empty() const { return num_items_ == 0; }
+
+    //! the File containing the encoded pages of column index
+    const File& column(size_t index) const {
+        assert(index < num_columns);
+        return columns_[index];
+    }
+
+    //! total number of bytes of all columns
+    size_t size_bytes() const {
+        size_t size = 0;
+        for (const File& f : columns_) size += f.size_bytes();
+        return size;
+    }
+
+    //! Free all Blocks of all columns
+    void Clear() {
+        for (File& f : columns_) f.Clear();
+        num_items_ = 0;
+    }
+
+    /*!
+     * Writer of tuples, which buffers a page of values per column and encodes
+     * full pages into the column Files. Close() or destruction writes the last
+     * partial pages.
+     */
+    class Writer
+    {
+    public:
+        explicit Writer(ColumnFile& file, size_t block_size)
+            : file_(&file) {
+            writers_.reserve(num_columns);
+            for (size_t i = 0; i < num_columns; ++i)
+                writers_.emplace_back(file.columns_[i].GetWriter(block_size));
+            Reserve(std::index_sequence_for<Columns...>());
+        }
+
+        //! non-copyable: delete copy-constructor
+        Writer(const Writer&) = delete;
+        //! non-copyable: delete assignment operator
+        Writer& operator = (const Writer&) = delete;
+        //! move-constructor
+        Writer(Writer&& w)
+            : file_(w.file_), writers_(std::move(w.writers_)),
+              pages_(std::move(w.pages_)), page_size_(w.page_size_) {
+            w.file_ = nullptr;
+        }
+        //! move-assignment operator: deleted
+        Writer& operator = (Writer&&) = delete;
+
+        ~Writer() { Close(); }
+
+        //! append a tuple
+        Writer& Put(const Tuple& t) {
+            assert(file_);
+            Push(t, std::index_sequence_for<Columns...>());
+            if (++page_size_ == file_->page_items_)
+                FlushPage();
+            return *this;
+        }
+
+        //! write the last partial pages and close the column Files.
+        void Close() {
+            if (!file_) return;
+            FlushPage();
+            for (File::Writer& w : writers_) w.Close();
+            file_ = nullptr;
+        }
+
+    private:
+        //! the ColumnFile written to
+        ColumnFile* file_;
+
+        //! BlockWriters of the column Files
+        std::vector<File::Writer> writers_;
+
+        //! buffered values of the current page per column
+        std::tuple<std::vector<Columns>...> pages_;
+
+        //! number of values in the current page
+        size_t page_size_ = 0;
+
+        template <size_t... Is>
+        void Reserve(std::index_sequence<Is...>) {
+            using Expander = int[];
+            (void)Expander { 0, (std::get<Is>(pages_).reserve(
+                                     file_->page_items_), 0)... };
+        }
+
+        template <size_t... Is>
+        void Push(const Tuple& t, std::index_sequence<Is...>) {
+            using Expander = int[];
+            (void)Expander { 0, (std::get<Is>(pages_).push_back(
+                                     std::get<Is>(t)), 0)... };
+        }
+
+        template <size_t... Is>
+        void Encode(std::index_sequence<Is...>) {
+            using Expander = int[];
+            (void)Expander { 0, (detail::ColumnPageCodec<Columns>::Encode(
+                                     std::get<Is>(pages_),
+                                     file_->encodings_[Is], writers_[Is]),
+                                 std::get<Is>(pages_).clear(), 0)... };
+        }
+
+        void FlushPage() {
+            if (page_size_ == 0) return;
+            Encode(std::index_sequence_for<Columns...>());
+            file_->num_items_ += page_size_;
+            page_size_ = 0;
+        }
+    };
+
+    /*!
+     * Reader of a projection of the columns Indexes..., which delivers
+     * std::tuple<ColumnType<Indexes>...> and reads only the Blocks of the
+     * selected columns.
+     */
+    template <size_t... Indexes>
+    class Reader
+    {
+    public:
+        using Projection = std::tuple<ColumnType<Indexes>...>;
+
+        Reader(ColumnFile& file, bool consume)
+            : remaining_(file.num_items_) {
+            readers_.reserve(sizeof ... (Indexes));
+            for (size_t index : { Indexes... })
+                readers_.emplace_back(file.columns_[index].GetReader(consume));
+            if (consume) file.num_items_ = 0;
+        }
+
+        //! whether at least one more tuple is available
+        bool HasNext() const { return remaining_ != 0; }
+
+        //! read the next projected tuple
+        Projection Next() {
+            assert(HasNext());
+            if (pos_ == page_size_) NextPage();
+            --remaining_;
+            return Get(std::make_index_sequence<sizeof ... (Indexes)>(),
+                       pos_++);
+        }
+
+    private:
+        //! number of tuples not read yet
+        size_t remaining_;
+
+        //! readers of the selected column Files
+        std::vector<File::Reader> readers_;
+
+        //! decoded current page of each selected column
+        std::tuple<std::vector<ColumnType<Indexes> >...> pages_;
+
+        //! position and size of the current page
+        size_t pos_ = 0, page_size_ = 0;
+
+        template <size_t... Is>
+        Projection Get(std::index_sequence<Is...>, size_t pos) const {
+            return Projection(std::get<Is>(pages_)[pos]...);
+        }
+
+        template <size_t... Is>
+        void Decode(std::index_sequence<Is...>) {
+            using Expander = int[];
+            (void)Expander { 0, (
+                                 detail::ColumnPageCodec<ColumnType<Indexes> >
+                                 ::Decode(readers_[Is], std::get<Is>(pages_)),
+                                 0)... };
+        }
+
+        void NextPage() {
+            Decode(std::make_index_sequence<sizeof ... (Indexes)>());
+            page_size_ = std::get<0>(pages_).size();
+            pos_ = 0;
+            die_unless(page_size_ != 0);
+        }
+    };
+
+private:
+    //! Reader type of all columns
+    template <typename Sequence>
+    struct FullReaderType;
+
+    template <size_t... Is>
+    struct FullReaderType<std::index_sequence<Is...> > {
+        using type = Reader<Is...>;
+    };
+
+public:
+    //! Reader of all columns
+    using FullReader = typename FullReaderType<
+              std::index_sequence_for<Columns...> >::type;
+
+    //! Get Writer of tuples.
+    Writer GetWriter(size_t block_size = default_block_size) {
+        return Writer(*this, block_size);
+    }
+
+    //! Get Reader of the projection of columns Indexes...
+    template <size_t... Indexes>
+    Reader<Indexes...> GetReader(bool consume) {
+        static_assert(sizeof ... (Indexes) > 0,
+                      "ColumnFile::GetReader() needs at least one column.");
+        return Reader<Indexes...>(*this, consume);
+    }
+
+    //! Get Reader of all columns
+    FullReader GetFullReader(bool consume) {
+        return FullReader(*this, consume);
+    }
+
+private:
+    //! maximum number of values per page
+    size_t page_items_;
+
+    //! encoding per column
+    std::vector<ColumnEncoding> encodings_;
+
+    //! one File per column
+    std::vector<File> columns_;
+
+    //! number of tuples
+    size_t num_items_ = 0;
+};
+
+template <typename... Columns>
+constexpr size_t ColumnFile<Columns...>::num_columns;
+
+template <typename... Columns>
+constexpr size_t ColumnFile<Columns...>::default_page_items;
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_COLUMN_FILE_HEADER
+
+/******************************************************************************/
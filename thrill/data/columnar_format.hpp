@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * thrill/data/columnar_format.hpp
+ *
+ * Self-describing columnar file format of WriteColumnar() and ReadColumnar()
+ * with per-row-group min/max statistics.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_COLUMNAR_FORMAT_HEADER
+#define THRILL_DATA_COLUMNAR_FORMAT_HEADER
+
+#include <thrill/data/column_file.hpp>
+#include <thrill/net/buffer_builder.hpp>
+#include <thrill/net/buffer_reader.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * \name Columnar File Format
+ *
+ * A columnar file stores items of type std::tuple<Columns...> as
+ *
+ *   magic | row group 0 | row group 1 | ... | footer | footer size | magic
+ *
+ * Each row group contains one chunk per column, which is a sequence of pages
+ * encoded by ColumnPageCodec. The footer describes the column types and, for
+ * each row group, the number of rows, the byte range of each column chunk, and
+ * the minimum and maximum value of each arithmetic column. The footer size is
+ * a little-endian uint64_t.
+ *
+ * \{
+ */
+
+//! magic bytes at the beginning and the end of a columnar file
+static constexpr char columnar_magic[8] = {
+    'T', 'h', 'r', 'C', 'o', 'l', '0', '1'
+};
+
+//! size of footer size and magic at the end of a columnar file
+static constexpr size_t columnar_trailer_size =
+    sizeof(uint64_t) + sizeof(columnar_magic);
+
+//! Type classes of columns, recorded in the footer.
+enum class ColumnKind : uint8_t {
+    Signed = 0, Unsigned = 1, Float = 2, Raw = 3
+};
+
+//! type class of a column of type T
+template <typename T>
+constexpr ColumnKind GetColumnKind() {
+    return std::is_floating_point<T>::value ? ColumnKind::Float
+           : std::is_integral<T>::value && std::is_signed<T>::value
+           ? ColumnKind::Signed
+           : std::is_integral<T>::value ? ColumnKind::Unsigned
+           : ColumnKind::Raw;
+}
+
+//! whether the footer contains min/max statistics for columns of type T
+template <typename T>
+struct has_column_stats : public std::is_arithmetic<T>{ };
+
+//! Location and statistics of a column chunk of a row group.
+struct ColumnChunkInfo {
+    //! byte range of the chunk in the file
+    uint64_t    offset = 0, size = 0;
+    //! raw bytes of minimum and maximum value, empty if the column has none.
+    std::string min, max;
+};
+
+//! Description of a row group in a columnar file.
+struct ColumnarRowGroup {
+    //! number of rows
+    uint64_t                     num_rows = 0;
+    //! one chunk per column
+    std::vector<ColumnChunkInfo> chunks;
+
+    //! byte offset of the row group in the file
+    uint64_t offset() const { return chunks.empty() ? 0 : chunks[0].offset; }
+};
+
+//! Footer of a columnar file.
+class ColumnarFooter
+{
+public:
+    //! type class and size of each column
+    struct Column {
+        ColumnKind kind;
+        uint64_t   size;
+    };
+
+    std::vector<Column>           columns;
+    std::vector<ColumnarRowGroup> row_groups;
+
+    //! set columns from the tuple type Schema
+    template <typename Schema>
+    void SetSchema() {
+        SetSchema<Schema>(
+            std::make_index_sequence<std::tuple_size<Schema>::value>());
+    }
+
+    //! whether the columns match the tuple type Schema
+    template <typename Schema>
+    bool MatchesSchema() const {
+        ColumnarFooter other;
+        other.SetSchema<Schema>();
+        if (other.columns.size() != columns.size()) return false;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (other.columns[i].kind != columns[i].kind ||
+                other.columns[i].size != columns[i].size) return false;
+        }
+        return true;
+    }
+
+    void Serialize(net::BufferBuilder& bb) const {
+        bb.PutVarint(columns.size());
+        for (const Column& c : columns) {
+            bb.PutByte(static_cast<uint8_t>(c.kind));
+            bb.PutVarint(c.size);
+        }
+        bb.PutVarint(row_groups.size());
+        for (const ColumnarRowGroup& rg : row_groups) {
+            assert(rg.chunks.size() == columns.size());
+            bb.PutVarint(rg.num_rows);
+            for (const ColumnChunkInfo& c : rg.chunks) {
+                bb.PutVarint(c.offset).PutVarint(c.size);
+                bb.PutString(c.min).PutString(c.max);
+            }
+        }
+    }
+
+    static ColumnarFooter Deserialize(net::BufferReader& br) {
+        ColumnarFooter f;
+        f.columns.resize(br.GetVarint());
+        for (Column& c : f.columns) {
+            c.kind = static_cast<ColumnKind>(br.GetByte());
+            c.size = br.GetVarint();
+        }
+        f.row_groups.resize(br.GetVarint());
+        for (ColumnarRowGroup& rg : f.row_groups) {
+            rg.num_rows = br.GetVarint();
+            rg.chunks.resize(f.columns.size());
+            for (ColumnChunkInfo& c : rg.chunks) {
+                c.offset = br.GetVarint();
+                c.size = br.GetVarint();
+                c.min = br.GetString();
+                c.max = br.GetString();
+            }
+        }
+        return f;
+    }
+
+private:
+    template <typename Schema, size_t... Is>
+    void SetSchema(std::index_sequence<Is...>) {
+        columns = {
+            Column {
+                GetColumnKind<typename std::tuple_element<Is, Schema>::type>(),
+                sizeof(typename std::tuple_element<Is, Schema>::type)
+            } ...
+        };
+    }
+};
+
+/*!
+ * Statistics of a row group as passed to the row group predicate of
+ * ReadColumnar(). The predicate returns false if no row of the group can match,
+ * then the row group is not read.
+ */
+template <typename Schema>
+class ColumnarStats
+{
+public:
+    template <size_t Index>
+    using ColumnType = typename std::tuple_element<Index, Schema>::type;
+
+    explicit ColumnarStats(const ColumnarRowGroup& row_group)
+        : row_group_(row_group) { }
+
+    //! number of rows in the row group
+    uint64_t num_rows() const { return row_group_.num_rows; }
+
+    //! minimum value of column Index in the row group
+    template <size_t Index>
+    ColumnType<Index> min() const {
+        return Get<Index>(row_group_.chunks[Index].min);
+    }
+
+    //! maximum value of column Index in the row group
+    template <size_t Index>
+    ColumnType<Index> max() const {
+        return Get<Index>(row_group_.chunks[Index].max);
+    }
+
+private:
+    const ColumnarRowGroup& row_group_;
+
+    template <size_t Index>
+    static ColumnType<Index> Get(const std::string& bytes) {
+        static_assert(has_column_stats<ColumnType<Index> >::value,
+                      "only arithmetic columns have min/max statistics");
+        ColumnType<Index> value;
+        die_unequal(bytes.size(), sizeof(value));
+        std::memcpy(&value, bytes.data(), sizeof(value));
+        return value;
+    }
+};
+
+/*!
+ * BufferBuilder with the item marker method called by ColumnPageCodec, which
+ * collects the encoded pages of a column chunk.
+ */
+class ColumnChunkBuilder : public net::BufferBuilder
+{
+public:
+    //! pages need no item markers in a columnar file
+    void MarkItem() { }
+};
+
+//! whether a column value is NaN
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+IsNaNValue(const T& v) { return std::isnan(v); }
+
+template <typename T>
+typename std::enable_if<!std::is_floating_point<T>::value, bool>::type
+IsNaNValue(const T&) { return false; }
+
+//! fill in the min/max statistics of a column chunk. NaNs compare false with
+//! all values, hence they are excluded, like rows with NaN never satisfy a
+//! comparison in a predicate. A chunk of only NaNs has NaN as min and max.
+template <typename T>
+void SetColumnStats(const std::vector<T>& values, ColumnChunkInfo& info,
+                    std::true_type) {
+    if (values.empty()) return;
+    const T* min = nullptr, * max = nullptr;
+    for (const T& v : values) {
+        if (IsNaNValue(v)) continue;
+        if (!min || v < *min) min = &v;
+        if (!max || *max < v) max = &v;
+    }
+    if (!min) min = max = &values.front();
+    info.min.assign(reinterpret_cast<const char*>(min), sizeof(T));
+    info.max.assign(reinterpret_cast<const char*>(max), sizeof(T));
+}
+
+template <typename T>
+void SetColumnStats(const std::vector<T>&, ColumnChunkInfo&, std::false_type)
+{ }
+
+//! Encode the values of a column chunk into pages of page_items values each,
+//! and fill in the statistics of info.
+template <typename T>
+void EncodeColumnChunk(const std::vector<T>& values, size_t page_items,
+                       ColumnChunkBuilder& bb, ColumnChunkInfo& info) {
+    std::vector<T> page;
+    for (size_t i = 0; i < values.size(); i += page_items) {
+        page.assign(values.begin() + i,
+                    values.begin() + std::min(i + page_items, values.size()));
+        detail::ColumnPageCodec<T>::Encode(page, ColumnEncoding::Auto, bb);
+    }
+    SetColumnStats(values, info, has_column_stats<T>());
+}
+
+//! Decode the pages of a column chunk of num_rows values.
+template <typename T>
+void DecodeColumnChunk(net::BufferReader& br, uint64_t num_rows,
+                       std::vector<T>& values) {
+    values.clear();
+    values.reserve(num_rows);
+    std::vector<T> page;
+    while (values.size() < num_rows) {
+        detail::ColumnPageCodec<T>::Decode(br, page);
+        die_unless(!page.empty());
+        values.insert(values.end(), page.begin(), page.end());
+    }
+    die_unequal(values.size(), num_rows);
+}
+
+//! \}
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_COLUMNAR_FORMAT_HEADER
+
+/******************************************************************************/
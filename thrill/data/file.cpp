@@ -8,8 +8,10 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/data/block_pool.hpp>
 #include <thrill/data/file.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 
@@ -101,6 +103,106 @@ std::ostream& operator << (std::ostream& os, const File& f) {
     return os << "]]";
 }
 
+/******************************************************************************/
+// AdaptivePrefetch
+
+constexpr size_t AdaptivePrefetch::min_blocks;
+constexpr size_t AdaptivePrefetch::max_blocks;
+
+AdaptivePrefetch::AdaptivePrefetch(
+    BlockPool* block_pool, size_t local_worker_id, size_t prefetch_size)
+    : block_pool_(block_pool), local_worker_id_(local_worker_id) {
+    set_size(prefetch_size);
+}
+
+AdaptivePrefetch::AdaptivePrefetch(AdaptivePrefetch&& o)
+    : block_pool_(o.block_pool_), local_worker_id_(o.local_worker_id_),
+      size_(o.size_), issued_(std::move(o.issued_)),
+      last_deliver_(o.last_deliver_), last_bytes_(o.last_bytes_),
+      rate_(o.rate_), latency_(o.latency_) {
+    o.size_ = 0;
+}
+
+AdaptivePrefetch::~AdaptivePrefetch() {
+    if (size_ != 0)
+        block_pool_->ReleasePrefetch(local_worker_id_, size_);
+}
+
+void AdaptivePrefetch::set_size(size_t size) {
+    if (size > size_)
+        block_pool_->ReservePrefetch(
+            local_worker_id_, size - size_, /* force */ true);
+    else if (size < size_)
+        block_pool_->ReleasePrefetch(local_worker_id_, size_ - size);
+    size_ = size;
+}
+
+void AdaptivePrefetch::Resize(size_t target) {
+    target = std::max(target, min_blocks * default_block_size);
+    target = std::min(target, max_blocks * default_block_size);
+
+    if (target > size_) {
+        // grow as far as the worker's budget allows
+        size_ += block_pool_->ReservePrefetch(
+            local_worker_id_, target - size_);
+    }
+    else if (target < size_ / 2) {
+        // shrink only on large deviations to avoid oscillation
+        block_pool_->ReleasePrefetch(local_worker_id_, size_ - target);
+        size_ = target;
+    }
+}
+
+PinnedBlock AdaptivePrefetch::Wait(const PinRequestPtr& req) {
+    steady_clock::time_point now = steady_clock::now();
+    bool stalled = !req->ready();
+
+    PinnedBlock b = req->Wait();
+    steady_clock::time_point done = stalled ? steady_clock::now() : now;
+
+    assert(!issued_.empty());
+    steady_clock::time_point issued = issued_.front();
+    issued_.pop_front();
+
+    // weight of new samples in the exponentially weighted averages
+    static constexpr double alpha = 0.25;
+
+    if (stalled) {
+        // the Block was read from disk while we waited: sample its latency
+        double latency =
+            std::chrono::duration<double>(done - issued).count();
+        latency_ = latency_ == 0 ? latency
+                   : (1 - alpha) * latency_ + alpha * latency;
+    }
+
+    if (last_bytes_ != 0) {
+        // time the reader spent consuming the previous Block, excluding the
+        // stall for this one.
+        double elapsed =
+            std::chrono::duration<double>(now - last_deliver_).count();
+        if (elapsed > 0) {
+            double rate = static_cast<double>(last_bytes_) / elapsed;
+            rate_ = rate_ == 0 ? rate : (1 - alpha) * rate_ + alpha * rate;
+        }
+    }
+    last_deliver_ = steady_clock::now();
+    last_bytes_ = b.size();
+
+    if (latency_ != 0 && rate_ != 0) {
+        // keep rate * latency bytes in flight, doubled to absorb variance,
+        // plus the Block currently being consumed.
+        size_t target = static_cast<size_t>(2 * rate_ * latency_)
+                        + default_block_size;
+        size_t old_size = size_;
+        Resize(target);
+        sLOGC(debug && size_ != old_size)
+            << "AdaptivePrefetch: rate" << rate_ << "latency" << latency_
+            << "resized" << old_size << "->" << size_;
+    }
+
+    return b;
+}
+
 /******************************************************************************/
 // KeepFileBlockSource
 
@@ -109,7 +211,7 @@ KeepFileBlockSource::KeepFileBlockSource(
     size_t prefetch_size,
     size_t first_block, size_t first_item)
     : file_(file), local_worker_id_(local_worker_id),
-      prefetch_size_(prefetch_size),
+      prefetch_(file.block_pool(), local_worker_id, prefetch_size),
       fetching_bytes_(0),
       first_block_(first_block), current_block_(first_block),
       first_item_(first_item)
@@ -129,19 +231,20 @@ Block KeepFileBlockSource::MakeNextBlock() {
 }
 
 void KeepFileBlockSource::Prefetch(size_t prefetch_size) {
-    if (prefetch_size >= prefetch_size_) {
-        prefetch_size_ = prefetch_size;
+    if (prefetch_size >= prefetch_.size()) {
+        prefetch_.set_size(prefetch_size);
         // prefetch #desired bytes
-        while (fetching_bytes_ < prefetch_size_ &&
+        while (fetching_bytes_ < prefetch_.size() &&
                current_block_ < file_.num_blocks())
         {
             Block b = MakeNextBlock();
             fetching_bytes_ += b.size();
             fetching_blocks_.emplace_back(b.Pin(local_worker_id_));
+            prefetch_.OnIssue();
         }
     }
-    else if (prefetch_size < prefetch_size_) {
-        prefetch_size_ = prefetch_size;
+    else if (prefetch_size < prefetch_.size()) {
+        prefetch_.set_size(prefetch_size);
         // cannot discard prefetched Blocks
     }
 }
@@ -150,7 +253,7 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     if (current_block_ >= file_.num_blocks() && fetching_blocks_.empty())
         return PinnedBlock();
 
-    if (prefetch_size_ == 0)
+    if (prefetch_.size() == 0)
     {
         // operate without prefetching
         return MakeNextBlock().PinWait(local_worker_id_);
@@ -158,16 +261,17 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     else
     {
         // prefetch #desired bytes
-        while (fetching_bytes_ < prefetch_size_ &&
+        while (fetching_bytes_ < prefetch_.size() &&
                current_block_ < file_.num_blocks())
         {
             Block b = MakeNextBlock();
             fetching_bytes_ += b.size();
             fetching_blocks_.emplace_back(b.Pin(local_worker_id_));
+            prefetch_.OnIssue();
         }
 
         // this might block if the prefetching is not finished
-        PinnedBlock b = fetching_blocks_.front()->Wait();
+        PinnedBlock b = prefetch_.Wait(fetching_blocks_.front());
         fetching_bytes_ -= b.size();
         fetching_blocks_.pop_front();
         return b;
@@ -175,9 +279,9 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
 }
 
 Block KeepFileBlockSource::NextBlockUnpinned() {
-    if (TLX_UNLIKELY(prefetch_size_ != 0 && !fetching_blocks_.empty())) {
+    if (TLX_UNLIKELY(prefetch_.size() != 0 && !fetching_blocks_.empty())) {
         // next block already prefetched, return it, but don't prefetch more
-        PinnedBlock b = fetching_blocks_.front()->Wait();
+        PinnedBlock b = prefetch_.Wait(fetching_blocks_.front());
         fetching_bytes_ -= b.size();
         fetching_blocks_.pop_front();
         return std::move(b).MoveToBlock();
@@ -199,32 +303,33 @@ PinnedBlock KeepFileBlockSource::AcquirePin(const Block& block) {
 ConsumeFileBlockSource::ConsumeFileBlockSource(
     File* file, size_t local_worker_id, size_t prefetch_size)
     : file_(file), local_worker_id_(local_worker_id),
-      prefetch_size_(prefetch_size),
+      prefetch_(file->block_pool(), local_worker_id, 0),
       fetching_bytes_(0) {
-    Prefetch(prefetch_size_);
+    Prefetch(prefetch_size);
 }
 
 ConsumeFileBlockSource::ConsumeFileBlockSource(ConsumeFileBlockSource&& s)
     : file_(s.file_), local_worker_id_(s.local_worker_id_),
-      prefetch_size_(s.prefetch_size_),
+      prefetch_(std::move(s.prefetch_)),
       fetching_blocks_(std::move(s.fetching_blocks_)),
       fetching_bytes_(s.fetching_bytes_) {
     s.file_ = nullptr;
 }
 
 void ConsumeFileBlockSource::Prefetch(size_t prefetch_size) {
-    if (prefetch_size >= prefetch_size_) {
-        prefetch_size_ = prefetch_size;
+    if (prefetch_size >= prefetch_.size()) {
+        prefetch_.set_size(prefetch_size);
         // prefetch #desired bytes
-        while (fetching_bytes_ < prefetch_size_ && !file_->blocks_.empty()) {
+        while (fetching_bytes_ < prefetch_.size() && !file_->blocks_.empty()) {
             Block& b = file_->blocks_.front();
             fetching_bytes_ += b.size();
             fetching_blocks_.emplace_back(b.Pin(local_worker_id_));
+            prefetch_.OnIssue();
             file_->blocks_.pop_front();
         }
     }
-    else if (prefetch_size < prefetch_size_) {
-        prefetch_size_ = prefetch_size;
+    else if (prefetch_size < prefetch_.size()) {
+        prefetch_.set_size(prefetch_size);
         // cannot discard prefetched Blocks
     }
 }
@@ -235,22 +340,23 @@ PinnedBlock ConsumeFileBlockSource::NextBlock() {
         return PinnedBlock();
 
     // operate without prefetching
-    if (prefetch_size_ == 0) {
+    if (prefetch_.size() == 0) {
         PinRequestPtr f = file_->blocks_.front().Pin(local_worker_id_);
         file_->blocks_.pop_front();
         return f->Wait();
     }
 
     // prefetch #desired bytes
-    while (fetching_bytes_ < prefetch_size_ && !file_->blocks_.empty()) {
+    while (fetching_bytes_ < prefetch_.size() && !file_->blocks_.empty()) {
         Block& b = file_->blocks_.front();
         fetching_bytes_ += b.size();
         fetching_blocks_.emplace_back(b.Pin(local_worker_id_));
+        prefetch_.OnIssue();
         file_->blocks_.pop_front();
     }
 
     // this might block if the prefetching is not finished
-    PinnedBlock b = fetching_blocks_.front()->Wait();
+    PinnedBlock b = prefetch_.Wait(fetching_blocks_.front());
     fetching_bytes_ -= b.size();
     fetching_blocks_.pop_front();
     return b;
@@ -259,9 +365,9 @@ PinnedBlock ConsumeFileBlockSource::NextBlock() {
 Block ConsumeFileBlockSource::NextBlockUnpinned() {
     assert(file_);
 
-    if (TLX_UNLIKELY(prefetch_size_ != 0 && !fetching_blocks_.empty())) {
+    if (TLX_UNLIKELY(prefetch_.size() != 0 && !fetching_blocks_.empty())) {
         // next block already prefetched, return it, but don't prefetch more
-        PinnedBlock b = fetching_blocks_.front()->Wait();
+        PinnedBlock b = prefetch_.Wait(fetching_blocks_.front());
         fetching_bytes_ -= b.size();
         fetching_blocks_.pop_front();
         return std::move(b).MoveToBlock();
@@ -23,6 +23,7 @@
 #include <tlx/die.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <limits>
@@ -87,6 +88,7 @@ public:
     //! items after the offset first.
     void AppendBlock(const Block& b) {
         if (b.size() == 0) return;
+        if (dia_id_ != 0) b.byte_block()->set_dia_id(dia_id_);
         num_items_sum_.push_back(num_items() + b.num_items());
         size_bytes_ += b.size();
         stats_bytes_ += b.size();
@@ -98,6 +100,7 @@ public:
     //! items after the offset first.
     void AppendBlock(Block&& b) {
         if (b.size() == 0) return;
+        if (dia_id_ != 0) b.byte_block()->set_dia_id(dia_id_);
         num_items_sum_.push_back(num_items() + b.num_items());
         size_bytes_ += b.size();
         stats_bytes_ += b.size();
@@ -341,6 +344,86 @@ private:
     tlx::CountingPtrNoDelete<File> file_;
 };
 
+/*!
+ * Adaptive readahead for the BlockSources of Files. It tracks the consumption
+ * rate of the reader and the latency of Blocks which had to be read from disk,
+ * and scales the number of prefetched bytes towards rate * latency (Little's
+ * law), such that reads are issued early enough to hide the disk latency
+ * without pinning Blocks long before they are needed.
+ *
+ * All prefetched bytes are reserved from the worker's prefetch budget in the
+ * BlockPool, hence all readers of a worker together never exceed it. The
+ * initial prefetch size, e.g. from MaxMergeDegreePrefetch(), is always
+ * granted. A prefetch size of zero disables prefetching and adaptation.
+ */
+class AdaptivePrefetch
+{
+    static constexpr bool debug = false;
+
+public:
+    using steady_clock = std::chrono::steady_clock;
+
+    //! smallest prefetch size in Blocks to which the window shrinks
+    static constexpr size_t min_blocks = 1;
+
+    //! largest prefetch size of one reader in Blocks
+    static constexpr size_t max_blocks = 64;
+
+    AdaptivePrefetch(BlockPool* block_pool, size_t local_worker_id,
+                     size_t prefetch_size);
+
+    //! non-copyable: delete copy-constructor
+    AdaptivePrefetch(const AdaptivePrefetch&) = delete;
+    //! non-copyable: delete assignment operator
+    AdaptivePrefetch& operator = (const AdaptivePrefetch&) = delete;
+    //! move-constructor: take over the reservation
+    AdaptivePrefetch(AdaptivePrefetch&& o);
+
+    //! release the reserved budget
+    ~AdaptivePrefetch();
+
+    //! current number of bytes to prefetch
+    size_t size() const { return size_; }
+
+    //! explicitly set the number of bytes to prefetch, which is always granted
+    void set_size(size_t size);
+
+    //! record the issue time of a pin request for a prefetched Block
+    void OnIssue() { issued_.push_back(steady_clock::now()); }
+
+    //! wait for the oldest prefetched Block and adapt the prefetch size to the
+    //! measured consumption rate and latency.
+    PinnedBlock Wait(const PinRequestPtr& req);
+
+private:
+    //! BlockPool to reserve budget from
+    BlockPool* block_pool_;
+
+    //! local worker id reading the File
+    size_t local_worker_id_;
+
+    //! current number of bytes to prefetch, all reserved from the budget
+    size_t size_ = 0;
+
+    //! issue times of outstanding pin requests
+    std::deque<steady_clock::time_point> issued_;
+
+    //! time the previous Block was delivered to the reader
+    steady_clock::time_point last_deliver_;
+
+    //! size of the previous Block delivered
+    size_t last_bytes_ = 0;
+
+    //! exponentially weighted average of the consumption rate (bytes/s)
+    double rate_ = 0;
+
+    //! exponentially weighted average of the read latency (s)
+    double latency_ = 0;
+
+    //! grow or shrink the reserved prefetch size
+    void Resize(size_t target);
+};
+
 /*!
  * A BlockSource to read Blocks from a File. The KeepFileBlockSource mainly
  * contains an index to the current block, which is incremented when the
@@ -384,8 +467,8 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of bytes of prefetch for reader
-    size_t prefetch_size_;
+    //! adaptive number of bytes of prefetch for reader
+    AdaptivePrefetch prefetch_;
 
     //! current prefetch operations
     std::deque<PinRequestPtr> fetching_blocks_;
@@ -451,8 +534,8 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of bytes of prefetch for reader
-    size_t prefetch_size_;
+    //! adaptive number of bytes of prefetch for reader
+    AdaptivePrefetch prefetch_;
 
     //! current prefetch operations
     std::deque<PinRequestPtr> fetching_blocks_;
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * thrill/data/mapped_file.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/mapped_file.hpp>
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/system_exception.hpp>
+
+#include <tlx/die.hpp>
+
+#include <cassert>
+#include <cerrno>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace thrill {
+namespace data {
+
+#if !defined(_MSC_VER)
+
+static constexpr bool debug = false;
+
+//! system page size, which mappings and madvise() ranges are aligned to
+static uint64_t PageSize() {
+    static const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+MappedFile::MappedFile(const std::string& path, const common::Range& range)
+    : range_(range) {
+    die_unless(range.IsValid());
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw common::ErrnoException("Could not open " + path, errno);
+
+    // mmap() requires a page aligned file offset
+    map_offset_ = range.begin - range.begin % PageSize();
+    map_size_ = range.end - map_offset_;
+
+    void* p = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd,
+                   static_cast<off_t>(map_offset_));
+    int mmap_errno = errno;
+    // the mapping keeps a reference to the file
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+        throw common::ErrnoException("Could not mmap() " + path, mmap_errno);
+
+    map_ = static_cast<uint8_t*>(p);
+
+    // blocks are read in file order, hence let the kernel read ahead.
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    sLOG << "MappedFile:" << path << "range" << range_
+         << "mapped at" << static_cast<void*>(map_);
+}
+
+MappedFile::~MappedFile() {
+    munmap(map_, map_size_);
+}
+
+uint8_t* MappedFile::data(uint64_t offset) const {
+    assert(offset >= range_.begin && offset <= range_.end);
+    return map_ + (offset - map_offset_);
+}
+
+void MappedFile::WillNeed(uint64_t offset, size_t size) const {
+    // extend to whole pages
+    uint64_t begin = offset - offset % PageSize();
+    madvise(map_ + (begin - map_offset_), offset + size - begin,
+            MADV_WILLNEED);
+}
+
+void MappedFile::DontNeed(uint64_t offset, size_t size) const {
+    // shrink to whole pages, the neighbouring ByteBlocks may still be in use.
+    uint64_t begin = (offset + PageSize() - 1) / PageSize() * PageSize();
+    uint64_t end = (offset + size) / PageSize() * PageSize();
+    // except at the ends of the mapping
+    if (offset == range_.begin) begin = map_offset_;
+    if (offset + size == range_.end) end = offset + size;
+    if (begin >= end) return;
+    madvise(map_ + (begin - map_offset_), end - begin, MADV_DONTNEED);
+}
+
+bool MappedFile::supported() {
+    return true;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path, const common::Range& range)
+    : range_(range) {
+    die("MappedFile: memory mapping " << path << " is not supported.");
+}
+
+MappedFile::~MappedFile() { }
+
+uint8_t* MappedFile::data(uint64_t /* offset */) const {
+    return nullptr;
+}
+
+void MappedFile::WillNeed(uint64_t /* offset */, size_t /* size */) const { }
+
+void MappedFile::DontNeed(uint64_t /* offset */, size_t /* size */) const { }
+
+bool MappedFile::supported() {
+    return false;
+}
+
+#endif
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * thrill/data/mapped_file.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_MAPPED_FILE_HEADER
+#define THRILL_DATA_MAPPED_FILE_HEADER
+
+#include <thrill/common/math.hpp>
+
+#include <tlx/counting_ptr.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * A read-only memory mapping of a byte range of a local system file. ByteBlocks
+ * created by BlockPool::MapMappedBlock() point directly into the mapping, hence
+ * the kernel's page cache is the block memory: pinning such a ByteBlock only
+ * advises the kernel to read its pages ahead, and evicting it drops the pages
+ * from the mapping instead of writing them to external memory.
+ */
+class MappedFile : public tlx::ReferenceCounter
+{
+public:
+    //! Map the byte range of the file at path. Throws common::ErrnoException if
+    //! the file cannot be opened or mapped.
+    MappedFile(const std::string& path, const common::Range& range);
+
+    //! non-copyable: delete copy-constructor
+    MappedFile(const MappedFile&) = delete;
+    //! non-copyable: delete assignment operator
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    //! Unmap the file
+    ~MappedFile();
+
+    //! the mapped byte range of the file
+    const common::Range& range() const { return range_; }
+
+    //! pointer to the mapped byte at offset in the file
+    uint8_t * data(uint64_t offset) const;
+
+    //! advise the kernel to read the pages of a byte range of the file ahead.
+    void WillNeed(uint64_t offset, size_t size) const;
+
+    //! drop the pages of a byte range of the file from the mapping, partially
+    //! covered pages at the ends remain mapped.
+    void DontNeed(uint64_t offset, size_t size) const;
+
+    //! whether memory mapping of files is supported on this system
+    static bool supported();
+
+private:
+    //! the mapped byte range of the file
+    common::Range range_;
+
+    //! begin of the mapping, which starts at the page containing range_.begin
+    uint8_t* map_ = nullptr;
+
+    //! size of the mapping
+    size_t map_size_ = 0;
+
+    //! file offset of map_
+    uint64_t map_offset_ = 0;
+};
+
+using MappedFilePtr = tlx::CountingPtr<MappedFile>;
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_MAPPED_FILE_HEADER
+
+/******************************************************************************/
@@ -15,6 +15,7 @@
 #include <thrill/common/atomic_movable.hpp>
 #include <thrill/common/concurrent_bounded_queue.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/span.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_queue.hpp>
 #include <thrill/data/block_reader.hpp>
@@ -22,6 +23,8 @@
 #include <thrill/data/dyn_block_reader.hpp>
 #include <thrill/data/file.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 namespace thrill {
@@ -215,6 +218,28 @@ public:
         }
     }
 
+    //! NextSpan() returns up to max_items whole items of a raw serialized type
+    //! T in place, see BlockReader::NextSpan(). Items of one span all stem from
+    //! the same worker.
+    template <typename T>
+    common::Span<const T> NextSpan(
+        size_t max_items = std::numeric_limits<size_t>::max()) {
+        if (reread_)
+            return cat_reader_.template NextSpan<T>(max_items);
+
+        if (!HasNext())
+            return common::Span<const T>();
+
+        assert(available_ > 0);
+        assert(selected_ < readers_.size());
+
+        common::Span<const T> span =
+            readers_[selected_].template NextSpan<T>(
+                std::min(max_items, available_));
+        available_ -= span.size();
+        return span;
+    }
+
 private:
     //! reference to mix queue
     MixBlockQueue& mix_queue_;
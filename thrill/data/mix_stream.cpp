@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace thrill {
@@ -163,12 +164,18 @@ struct MixStreamData::SeqReordering {
 
     //! queue of waiting Blocks, ordered by sequence number
     std::map<uint32_t, Block> waiting_;
+
+    //! Blocks from one sender may be delivered concurrently by several
+    //! DispatcherThreads if the connection is striped.
+    std::mutex                mutex_;
 };
 
 void MixStreamData::OnStreamBlock(size_t from, uint32_t seq, Block&& b) {
     assert(from < num_workers());
     rx_timespan_.StartEventually();
 
+    std::unique_lock<std::mutex> lock(seq_[from].mutex_);
+
     sLOG << "MixStreamData::OnStreamBlock" << b
          << "stream" << id_
          << "from" << from
@@ -20,6 +20,7 @@
 #include <tlx/math/round_to_power_of_two.hpp>
 
 #include <algorithm>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -117,23 +118,64 @@ struct Multiplexer::Data {
     //! Streams have an ID in block headers. (worker id, stream id)
     Repository<StreamSetBase>         stream_sets_;
 
-    //! array of number of open requests
+    //! array of number of open requests, one per (stripe, peer) link
     std::vector<std::atomic<size_t> > ongoing_requests_;
 
-    explicit Data(size_t num_hosts, size_t workers_per_host)
+    //! credit for received Blocks which is to be returned to a sender,
+    //! aggregated per stream and pair of workers.
+    struct PendingCredit {
+        StreamId id;
+        uint32_t sender_worker;
+        uint32_t receiver_local_worker;
+        size_t size;
+    };
+
+    //! credit waiting to be sent, one list per peer host
+    std::vector<std::vector<PendingCredit> > pending_credits_;
+
+    //! protects the pending and withheld credit state. Locked by the
+    //! BlockPool's release callback while the BlockPool is locked, hence the
+    //! BlockPool must not be called while holding it.
+    std::mutex credit_mutex_;
+
+    //! total size of the credit in pending_credits_
+    size_t withheld_bytes_ = 0;
+
+    //! memory released by the BlockPool which was not yet returned as credit
+    size_t released_bytes_ = 0;
+
+    //! peer host whose pending credit is sent first, rotated for fairness
+    size_t next_credit_peer_ = 0;
+
+    //! whether the credit timer is active
+    bool credit_timer_ = false;
+
+    //! time when credit was last returned, or started to be withheld
+    std::chrono::steady_clock::time_point credit_progress_;
+
+    explicit Data(size_t num_links, size_t num_hosts, size_t workers_per_host)
         : stream_sets_(workers_per_host),
-          ongoing_requests_(num_hosts) { }
+          ongoing_requests_(num_links),
+          pending_credits_(num_hosts) { }
 };
 
+constexpr size_t Multiplexer::auto_credit_window;
+constexpr std::chrono::milliseconds Multiplexer::default_credit_max_delay;
+constexpr std::chrono::milliseconds Multiplexer::credit_retry;
+
 Multiplexer::Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
                          net::DispatcherThread& dispatcher, net::Group& group,
-                         size_t workers_per_host)
+                         size_t workers_per_host, size_t num_dispatchers,
+                         size_t credit_window,
+                         std::chrono::milliseconds credit_max_delay)
     : mem_manager_(mem_manager),
       block_pool_(block_pool),
       dispatcher_(dispatcher),
       group_(group),
       workers_per_host_(workers_per_host),
-      d_(std::make_unique<Data>(group_.num_hosts(), workers_per_host)) {
+      d_(std::make_unique<Data>(
+             group_.num_hosts() * group_.num_stripes(), group_.num_hosts(),
+             workers_per_host)) {
 
     num_parallel_async_ = group_.num_parallel_async();
     if (num_parallel_async_ == 0) {
@@ -152,10 +194,44 @@ Multiplexer::Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
     if (send_size_limit_ < 2 * default_block_size)
         send_size_limit_ = 2 * default_block_size;
 
-    // launch initial async reads
-    for (size_t id = 0; id < group_.num_hosts(); id++) {
-        if (id == group_.my_host_rank()) continue;
-        AsyncReadMultiplexerHeader(id, group_.connection(id));
+    // calculate credit window: divide the BlockPool's soft limit among all
+    // pairs of remote sending and local receiving workers, but allow at least
+    // two Blocks in flight. Without soft limit there is no need for flow
+    // control, and on a single host no data is transmitted.
+    if (credit_window == auto_credit_window) {
+        size_t soft_ram_limit = block_pool.soft_ram_limit();
+        credit_window = soft_ram_limit / workers_per_host / num_workers();
+        if (soft_ram_limit == 0)
+            credit_window = 0;
+        else if (credit_window < 2 * default_block_size)
+            credit_window = 2 * default_block_size;
+    }
+    credit_window_ = num_hosts() > 1 ? credit_window : 0;
+    credit_max_delay_ = credit_max_delay;
+
+    // return withheld credit as the BlockPool releases memory
+    if (credit_window_ != 0) {
+        block_pool_.SetReleaseCallback(
+            [this](size_t size, bool above_soft_limit) {
+                OnMemoryReleased(size, above_soft_limit);
+            });
+    }
+
+    // launch additional dispatcher threads, there is no use for more threads
+    // than links.
+    dispatchers_.push_back(&dispatcher_);
+    num_dispatchers = std::min(num_dispatchers, num_links());
+    for (size_t i = 1; i < num_dispatchers; ++i) {
+        extra_dispatchers_.emplace_back(
+            std::make_unique<net::DispatcherThread>(
+                group_.ConstructDispatcher(), my_host_rank(), i));
+        dispatchers_.push_back(extra_dispatchers_.back().get());
+    }
+
+    // launch initial async reads on all links to other hosts
+    for (size_t link = 0; link < num_links(); ++link) {
+        if (link % num_hosts() == my_host_rank()) continue;
+        AsyncReadMultiplexerHeader(link, link_connection(link));
     }
 }
 
@@ -175,12 +251,22 @@ void Multiplexer::Close() {
 }
 
 Multiplexer::~Multiplexer() {
+    if (credit_window_ != 0)
+        block_pool_.SetReleaseCallback(nullptr);
+
     if (!closed_)
         Close();
 
+    TerminateDispatchers();
+
     group_.Close();
 }
 
+void Multiplexer::TerminateDispatchers() {
+    for (std::unique_ptr<net::DispatcherThread>& d : extra_dispatchers_)
+        d->Terminate();
+}
+
 size_t Multiplexer::AllocateCatStreamId(size_t local_worker_id) {
     std::unique_lock<std::mutex> lock(mutex_);
     return d_->stream_sets_.AllocateId(local_worker_id);
@@ -277,27 +363,35 @@ common::JsonLogger& Multiplexer::logger() {
     return block_pool_.logger();
 }
 
+size_t Multiplexer::SelectLink(
+    size_t peer, size_t seq, size_t sender, size_t receiver) {
+    // rotate the starting stripe by the worker pair, such that streams do not
+    // all begin on the first connection.
+    size_t stripe = (seq + sender + receiver) % num_stripes();
+    return stripe * num_hosts() + peer;
+}
+
 /******************************************************************************/
 
-void Multiplexer::AsyncReadMultiplexerHeader(size_t peer, Connection& s) {
+void Multiplexer::AsyncReadMultiplexerHeader(size_t link, Connection& s) {
 
-    while (d_->ongoing_requests_[peer] < num_parallel_async_) {
+    while (d_->ongoing_requests_[link] < num_parallel_async_) {
         uint32_t seq = 42 + (s.rx_seq_.fetch_add(2) & 0xFFFF);
-        dispatcher_.AsyncRead(
+        link_dispatcher(link).AsyncRead(
             s, seq, MultiplexerHeader::total_size,
-            [this, peer, seq](Connection& s, net::Buffer&& buffer) {
-                return OnMultiplexerHeader(peer, seq, s, std::move(buffer));
+            [this, link, seq](Connection& s, net::Buffer&& buffer) {
+                return OnMultiplexerHeader(link, seq, s, std::move(buffer));
             });
 
-        d_->ongoing_requests_[peer]++;
+        d_->ongoing_requests_[link]++;
     }
 }
 
 void Multiplexer::OnMultiplexerHeader(
-    size_t peer, uint32_t seq, Connection& s, net::Buffer&& buffer) {
+    size_t link, uint32_t seq, Connection& s, net::Buffer&& buffer) {
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    die_unless(d_->ongoing_requests_[link] > 0);
+    d_->ongoing_requests_[link]--;
 
     // received invalid Buffer: the connection has closed?
     if (!buffer.IsValid()) return;
@@ -373,13 +467,13 @@ void Multiplexer::OnMultiplexerHeader(
                 alloc_size, local_worker);
             sLOG << "new PinnedByteBlockPtr bytes=" << *bytes;
 
-            d_->ongoing_requests_[peer]++;
+            d_->ongoing_requests_[link]++;
 
-            dispatcher_.AsyncRead(
+            link_dispatcher(link).AsyncRead(
                 s, seq + 1, header.size, std::move(bytes),
-                [this, peer, header, stream](
+                [this, link, header, stream](
                     Connection& s, PinnedByteBlockPtr&& bytes) {
-                    OnCatStreamBlock(peer, s, header, stream, std::move(bytes));
+                    OnCatStreamBlock(link, s, header, stream, std::move(bytes));
                 });
         }
     }
@@ -431,29 +525,33 @@ void Multiplexer::OnMultiplexerHeader(
             PinnedByteBlockPtr bytes = block_pool_.AllocateByteBlock(
                 alloc_size, local_worker);
 
-            d_->ongoing_requests_[peer]++;
+            d_->ongoing_requests_[link]++;
 
-            dispatcher_.AsyncRead(
+            link_dispatcher(link).AsyncRead(
                 s, seq + 1, header.size, std::move(bytes),
-                [this, peer, header, stream](
+                [this, link, header, stream](
                     Connection& s, PinnedByteBlockPtr&& bytes) mutable {
-                    OnMixStreamBlock(peer, s, header, stream, std::move(bytes));
+                    OnMixStreamBlock(link, s, header, stream, std::move(bytes));
                 });
         }
     }
+    else if (header.magic == MagicByte::StreamCredit)
+    {
+        OnStreamCredit(link % num_hosts(), header);
+    }
     else {
         die("Invalid magic byte in MultiplexerHeader");
     }
 
-    AsyncReadMultiplexerHeader(peer, s);
+    AsyncReadMultiplexerHeader(link, s);
 }
 
 void Multiplexer::OnCatStreamBlock(
-    size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+    size_t link, Connection& s, const StreamMultiplexerHeader& header,
     const CatStreamDataPtr& stream, PinnedByteBlockPtr&& bytes) {
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    die_unless(d_->ongoing_requests_[link] > 0);
+    d_->ongoing_requests_[link]--;
 
     sLOG << "Multiplexer::OnCatStreamBlock()"
          << "got block" << *bytes << "seq" << header.seq << "on" << s
@@ -469,15 +567,17 @@ void Multiplexer::OnCatStreamBlock(
     if (header.is_last_block)
         stream->OnStreamBlock(header.sender_worker, header.seq + 1, Block());
 
-    AsyncReadMultiplexerHeader(peer, s);
+    GrantCredit(header);
+
+    AsyncReadMultiplexerHeader(link, s);
 }
 
 void Multiplexer::OnMixStreamBlock(
-    size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+    size_t link, Connection& s, const StreamMultiplexerHeader& header,
     const MixStreamDataPtr& stream, PinnedByteBlockPtr&& bytes) {
 
-    die_unless(d_->ongoing_requests_[peer] > 0);
-    d_->ongoing_requests_[peer]--;
+    die_unless(d_->ongoing_requests_[link] > 0);
+    d_->ongoing_requests_[link]--;
 
     sLOG << "Multiplexer::OnMixStreamBlock()"
          << "got block" << *bytes << "seq" << header.seq << "on" << s
@@ -493,7 +593,164 @@ void Multiplexer::OnMixStreamBlock(
     if (header.is_last_block)
         stream->OnStreamBlock(header.sender_worker, header.seq + 1, Block());
 
-    AsyncReadMultiplexerHeader(peer, s);
+    GrantCredit(header);
+
+    AsyncReadMultiplexerHeader(link, s);
+}
+
+void Multiplexer::GrantCredit(const StreamMultiplexerHeader& header) {
+    if (credit_window_ == 0 || header.size == 0) return;
+
+    // query the BlockPool before locking, see credit_mutex_.
+    size_t soft_ram_limit = block_pool_.soft_ram_limit();
+    bool above_soft_limit =
+        soft_ram_limit != 0 && block_pool_.total_ram_bytes() > soft_ram_limit;
+
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+
+    std::vector<Data::PendingCredit>& pending =
+        d_->pending_credits_[header.CalcHostRank(workers_per_host())];
+
+    // aggregate credit with pending credit for the same pair of workers
+    auto it = std::find_if(
+        pending.begin(), pending.end(),
+        [&header](const Data::PendingCredit& pc) {
+            return pc.id == header.stream_id &&
+            pc.sender_worker == header.sender_worker &&
+            pc.receiver_local_worker == header.receiver_local_worker;
+        });
+    if (it != pending.end())
+        it->size += header.size;
+    else
+        pending.push_back(Data::PendingCredit {
+                              header.stream_id, header.sender_worker,
+                              header.receiver_local_worker, header.size
+                          });
+
+    if (d_->withheld_bytes_ == 0)
+        d_->credit_progress_ = std::chrono::steady_clock::now();
+    d_->withheld_bytes_ += header.size;
+
+    if (!above_soft_limit) {
+        d_->released_bytes_ = 0;
+        IntSendCredits(d_->withheld_bytes_);
+        return;
+    }
+
+    // BlockPool is swapping: withhold credit such that senders wait instead of
+    // us writing their Blocks to disk. OnMemoryReleased() returns it as the
+    // BlockPool releases memory.
+    LOG << "Multiplexer::GrantCredit() withholding credit";
+
+    if (d_->credit_timer_) return;
+    d_->credit_timer_ = true;
+    dispatcher_.AddTimer(credit_retry, [this]() { return OnCreditTimer(); });
+}
+
+void Multiplexer::OnMemoryReleased(size_t size, bool above_soft_limit) {
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+
+    if (d_->withheld_bytes_ == 0) return;
+
+    if (!above_soft_limit) {
+        d_->released_bytes_ = 0;
+        IntSendCredits(d_->withheld_bytes_);
+        return;
+    }
+
+    // let senders transmit as much as was released, such that they are
+    // throttled to the rate at which we evict or consume their Blocks.
+    d_->released_bytes_ += size;
+    d_->released_bytes_ -= IntSendCredits(d_->released_bytes_);
+    if (d_->withheld_bytes_ == 0)
+        d_->released_bytes_ = 0;
+}
+
+bool Multiplexer::OnCreditTimer() {
+    std::unique_lock<std::mutex> lock(d_->credit_mutex_);
+
+    if (d_->withheld_bytes_ != 0 &&
+        std::chrono::steady_clock::now() - d_->credit_progress_
+        < credit_max_delay_)
+        return true;
+
+    if (d_->withheld_bytes_ != 0) {
+        LOG << "Multiplexer::OnCreditTimer() granting withheld credit";
+        IntSendCredits(d_->withheld_bytes_);
+    }
+    d_->credit_timer_ = false;
+    return false;
+}
+
+size_t Multiplexer::IntSendCredits(size_t limit) {
+    size_t sent = 0;
+    for (size_t i = 0; i < num_hosts() && sent < limit; ++i) {
+        size_t peer = (d_->next_credit_peer_ + i) % num_hosts();
+        std::vector<Data::PendingCredit>& pending = d_->pending_credits_[peer];
+
+        size_t done = 0;
+        for ( ; done < pending.size() && sent < limit; ++done) {
+            Data::PendingCredit& pc = pending[done];
+            size_t part = std::min(pc.size, limit - sent);
+            pc.size -= part;
+            sent += part;
+
+            // aggregated credit may exceed the header's size field
+            while (part != 0) {
+                StreamMultiplexerHeader header;
+                header.magic = MagicByte::StreamCredit;
+                header.size = static_cast<uint32_t>(
+                    std::min<size_t>(part, uint32_t(-1)));
+                header.stream_id = pc.id;
+                header.sender_worker = pc.sender_worker;
+                header.receiver_local_worker = pc.receiver_local_worker;
+                part -= header.size;
+
+                net::BufferBuilder bb;
+                header.Serialize(bb);
+
+                // credit is always sent on the first stripe
+                net::Connection& conn = link_connection(peer);
+                link_dispatcher(peer).AsyncWrite(
+                    conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
+                    bb.ToBuffer());
+            }
+
+            // partially returned credit remains first in line
+            if (pc.size != 0) break;
+        }
+        pending.erase(pending.begin(), pending.begin() + done);
+    }
+    d_->next_credit_peer_ = (d_->next_credit_peer_ + 1) % num_hosts();
+
+    if (sent != 0) {
+        d_->withheld_bytes_ -= sent;
+        d_->credit_progress_ = std::chrono::steady_clock::now();
+    }
+    return sent;
+}
+
+void Multiplexer::OnStreamCredit(
+    size_t peer, const StreamMultiplexerHeader& header) {
+
+    sLOG << "Multiplexer::OnStreamCredit()"
+         << "stream" << header.stream_id
+         << "from worker" << peer * workers_per_host() + header.receiver_local_worker
+         << "to worker" << header.sender_worker
+         << "size" << header.size;
+
+    tlx::CountingPtr<StreamSetBase> set;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = d_->stream_sets_.map().find(header.stream_id);
+        // the stream may have been released already
+        if (it == d_->stream_sets_.map().end()) return;
+        set = it->second;
+    }
+
+    set->OnCredit(header.sender_worker % workers_per_host(),
+                  peer * workers_per_host() + header.receiver_local_worker,
+                  header.size);
 }
 
 CatStreamDataPtr Multiplexer::CatLoopback(
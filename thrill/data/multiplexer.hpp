@@ -19,7 +19,9 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace thrill {
 namespace data {
@@ -69,9 +71,27 @@ class Multiplexer
     static constexpr bool debug = false;
 
 public:
+    //! Construct Multiplexer on the given DispatcherThread. If num_dispatchers
+    //! is larger than one, additional DispatcherThreads are launched and the
+    //! connections to other hosts are sharded among them. The credit_window is
+    //! the number of bytes each receiving worker grants each sending worker per
+    //! Stream, auto_credit_window derives it from the BlockPool's soft limit
+    //! and zero disables credit-based flow control. Credit is withheld under
+    //! memory pressure for at most credit_max_delay.
     Multiplexer(mem::Manager& mem_manager, BlockPool& block_pool,
                 net::DispatcherThread& dispatcher, net::Group& group,
-                size_t workers_per_host);
+                size_t workers_per_host, size_t num_dispatchers = 1,
+                size_t credit_window = auto_credit_window,
+                std::chrono::milliseconds credit_max_delay =
+                    default_credit_max_delay);
+
+    //! select credit window from BlockPool's soft limit
+    static constexpr size_t auto_credit_window = size_t(-1);
+
+    //! default maximum time credit is withheld
+    static constexpr std::chrono::milliseconds default_credit_max_delay {
+        1000
+    };
 
     //! non-copyable: delete copy-constructor
     Multiplexer(const Multiplexer&) = delete;
@@ -110,12 +130,70 @@ public:
     //! Get the JsonLogger from the BlockPool
     common::JsonLogger& logger();
 
-    //! get network dispatcher
+    //! get main network dispatcher
     net::DispatcherThread& dispatcher() { return dispatcher_; }
 
     //! get network group connection
     net::Group& group() { return group_; }
 
+    //! number of parallel connections to each peer host
+    size_t num_stripes() const { return group_.num_stripes(); }
+
+    //! number of DispatcherThreads serving the connections
+    size_t num_dispatchers() const { return dispatchers_.size(); }
+
+    //! Terminate the additional DispatcherThreads (if any). Must be called
+    //! before the main dispatcher is stopped.
+    void TerminateDispatchers();
+
+    //! \name Links: Connections to Peer Hosts
+    //! \{
+
+    //! Links enumerate all connections to other hosts: link = stripe *
+    //! num_hosts() + peer. The link of stripe 0 is the peer's rank.
+    size_t num_links() const { return num_hosts() * num_stripes(); }
+
+    //! Select the link to peer host over which the Block with sequence number
+    //! seq from global worker sender to local worker receiver is sent. Blocks
+    //! are striped round-robin, the receiving StreamData restores their order
+    //! using the sequence numbers.
+    size_t SelectLink(size_t peer, size_t seq, size_t sender, size_t receiver);
+
+    //! Connection of a link
+    net::Connection& link_connection(size_t link) {
+        return group_.stripe_connection(
+            link % num_hosts(), link / num_hosts());
+    }
+
+    //! DispatcherThread responsible for all operations on a link
+    net::DispatcherThread& link_dispatcher(size_t link) {
+        return *dispatchers_[link % dispatchers_.size()];
+    }
+
+    //! \}
+
+    //! \name Credit-Based Flow Control
+    //! \{
+
+    //! Number of bytes each receiving worker initially grants each sending
+    //! worker per Stream. Receivers return credit for Blocks as they arrive,
+    //! but while the BlockPool is above its soft limit, they withhold it and
+    //! return only as many bytes as the BlockPool releases, by evicting Blocks
+    //! or by readers consuming them. Zero if flow control is disabled.
+    size_t credit_window() const { return credit_window_; }
+
+    //! Maximum time without any credit returned, after which all withheld
+    //! credit is granted. Guarantees progress even if the BlockPool cannot
+    //! release memory.
+    std::chrono::milliseconds credit_max_delay() const {
+        return credit_max_delay_;
+    }
+
+    //! interval in which credit_max_delay is checked
+    static constexpr std::chrono::milliseconds credit_retry { 10 };
+
+    //! \}
+
     //! \name CatStreamData
     //! \{
 
@@ -157,6 +235,13 @@ private:
     //! never leaves the data components!
     net::DispatcherThread& dispatcher_;
 
+    //! additional DispatcherThreads owned by the Multiplexer
+    std::vector<std::unique_ptr<net::DispatcherThread> > extra_dispatchers_;
+
+    //! all DispatcherThreads, first is dispatcher_, links are assigned
+    //! round-robin to them.
+    std::vector<net::DispatcherThread*> dispatchers_;
+
     //! Holds NetConnections for outgoing Streams
     net::Group& group_;
 
@@ -175,6 +260,12 @@ private:
     //! Calculated send queue size limit for StreamData semaphores
     size_t send_size_limit_;
 
+    //! credit each receiving worker grants each sending worker per Stream
+    size_t credit_window_;
+
+    //! maximum time without any credit returned while credit is withheld
+    std::chrono::milliseconds credit_max_delay_;
+
     //! number of active Cat/MixStreams
     std::atomic<size_t> active_streams_ { 0 };
 
@@ -213,24 +304,43 @@ private:
 
     using Connection = net::Connection;
 
-    //! expects the next MultiplexerHeader from a socket and passes to
-    //! OnMultiplexerHeader
-    void AsyncReadMultiplexerHeader(size_t peer, Connection& s);
+    //! expects the next MultiplexerHeader from a socket (identified by link =
+    //! stripe * num_hosts + peer) and passes to OnMultiplexerHeader
+    void AsyncReadMultiplexerHeader(size_t link, Connection& s);
 
     //! parses MultiplexerHeader and decides whether to receive Block or close
     //! Stream
     void OnMultiplexerHeader(
-        size_t peer, uint32_t seq, Connection& s, net::Buffer&& buffer);
+        size_t link, uint32_t seq, Connection& s, net::Buffer&& buffer);
 
     //! Receives and dispatches a Block to a CatStreamData
     void OnCatStreamBlock(
-        size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+        size_t link, Connection& s, const StreamMultiplexerHeader& header,
         const CatStreamDataPtr& stream, PinnedByteBlockPtr&& bytes);
 
     //! Receives and dispatches a Block to a MixStream
     void OnMixStreamBlock(
-        size_t peer, Connection& s, const StreamMultiplexerHeader& header,
+        size_t link, Connection& s, const StreamMultiplexerHeader& header,
         const MixStreamDataPtr& stream, PinnedByteBlockPtr&& bytes);
+
+    //! Return the credit for a received Block to its sender, or withhold it
+    //! while the BlockPool is above its soft limit.
+    void GrantCredit(const StreamMultiplexerHeader& header);
+
+    //! BlockPool callback returning as much withheld credit as memory was
+    //! released, or all of it once the BlockPool dropped below its soft limit.
+    void OnMemoryReleased(size_t size, bool above_soft_limit);
+
+    //! Timer callback granting all withheld credit if none was returned for
+    //! credit_max_delay. Returns true to retry.
+    bool OnCreditTimer();
+
+    //! Send up to limit bytes of pending credit, requires the credit mutex.
+    //! Returns the number of bytes sent.
+    size_t IntSendCredits(size_t limit);
+
+    //! Receives credit from peer host for a Stream of one of our workers
+    void OnStreamCredit(size_t peer, const StreamMultiplexerHeader& header);
 };
 
 //! \}
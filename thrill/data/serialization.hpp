@@ -48,6 +48,14 @@ struct Serialization<Archive, T,
     static constexpr size_t fixed_size = sizeof(T);
 };
 
+//! Whether items of type T are serialized as their raw object bytes, such that
+//! arrays of T can be read and written in place, e.g. by
+//! BlockReader::NextSpan() and BlockWriter::PutBatch().
+template <typename T>
+struct is_raw_serialized
+    : public std::integral_constant<
+          bool, std::is_pod<T>::value && !std::is_pointer<T>::value> { };
+
 /********************** Serialization of strings ******************************/
 
 template <typename Archive>
@@ -30,8 +30,13 @@ StreamData::StreamData(StreamSetBase* stream_set_base,
       stream_set_base_(stream_set_base),
       local_worker_id_(local_worker_id),
       dia_id_(dia_id),
-      multiplexer_(multiplexer)
-{ }
+      multiplexer_(multiplexer) {
+    if (multiplexer_.credit_window() != 0) {
+        credits_.resize(
+            num_workers(),
+            static_cast<std::ptrdiff_t>(multiplexer_.credit_window()));
+    }
+}
 
 StreamData::~StreamData() = default;
 
@@ -79,7 +84,38 @@ void StreamData::OnAllWritersClosed() {
         << "rx_int_blocks" << rx_int_blocks_
         << "tx_int_items" << tx_int_items_
         << "tx_int_bytes" << tx_int_bytes_
-        << "tx_int_blocks" << tx_int_blocks_;
+        << "tx_int_blocks" << tx_int_blocks_
+        << "tx_net_credit_stalls" << tx_net_credit_stalls_;
+}
+
+void StreamData::AcquireCredit(size_t peer_worker_rank, size_t size) {
+    if (credits_.empty()) return;
+
+    std::unique_lock<std::mutex> lock(credit_mutex_);
+    assert(peer_worker_rank < credits_.size());
+
+    if (credits_[peer_worker_rank] <= 0) {
+        LOG << "StreamData::AcquireCredit()"
+            << " stream=" << id_
+            << " my_worker_rank=" << my_worker_rank()
+            << " peer_worker_rank=" << peer_worker_rank
+            << " waiting for credit";
+
+        ++tx_net_credit_stalls_;
+        cv_credit_.wait(lock, [&]() { return credits_[peer_worker_rank] > 0; });
+    }
+
+    credits_[peer_worker_rank] -= static_cast<std::ptrdiff_t>(size);
+}
+
+void StreamData::OnCredit(size_t peer_worker_rank, size_t size) {
+    if (credits_.empty()) return;
+
+    std::unique_lock<std::mutex> lock(credit_mutex_);
+    assert(peer_worker_rank < credits_.size());
+
+    credits_[peer_worker_rank] += static_cast<std::ptrdiff_t>(size);
+    cv_credit_.notify_all();
 }
 
 /******************************************************************************/
@@ -142,6 +178,16 @@ void StreamSet<StreamData>::Close() {
         c->Close();
 }
 
+template <typename StreamData>
+void StreamSet<StreamData>::OnCredit(
+    size_t local_worker_id, size_t peer_worker_rank, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(local_worker_id < streams_.size());
+    // the local stream may have been released already
+    if (streams_[local_worker_id])
+        streams_[local_worker_id]->OnCredit(peer_worker_rank, size);
+}
+
 template <typename StreamData>
 void StreamSet<StreamData>::OnWriterClosed(size_t peer_worker_rank, bool sent) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -199,9 +245,10 @@ void StreamSet<StreamData>::OnWriterClosed(size_t peer_worker_rank, bool sent) {
         net::Buffer buffer = bb.ToBuffer();
         assert(buffer.size() == MultiplexerHeader::total_size);
 
-        net::Connection& conn = multiplexer_.group().connection(peer_host_rank);
+        // the link of stripe 0 to the peer host is its rank
+        net::Connection& conn = multiplexer_.link_connection(peer_host_rank);
 
-        multiplexer_.dispatcher().AsyncWrite(
+        multiplexer_.link_dispatcher(peer_host_rank).AsyncWrite(
             conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
             std::move(buffer));
     }
@@ -20,6 +20,8 @@
 #include <thrill/data/multiplexer.hpp>
 #include <tlx/semaphore.hpp>
 
+#include <condition_variable>
+#include <cstddef>
 #include <mutex>
 #include <vector>
 
@@ -32,7 +34,7 @@ namespace data {
 using StreamId = size_t;
 
 enum class MagicByte : uint8_t {
-    Invalid, CatStreamBlock, MixStreamBlock, PartitionBlock
+    Invalid, CatStreamBlock, MixStreamBlock, PartitionBlock, StreamCredit
 };
 
 class StreamSink;
@@ -125,6 +127,21 @@ public:
     //! method called when all StreamSink writers have finished
     void OnAllWritersClosed();
 
+    //! \name Credit-Based Flow Control
+    //! \{
+
+    //! Wait until the worker peer_worker_rank has granted credit to send
+    //! another size bytes and consume it. Called by StreamSink before passing a
+    //! Block to the network layer. Any remaining credit may be overdrawn by one
+    //! Block, hence Blocks larger than the credit window are still sent.
+    void AcquireCredit(size_t peer_worker_rank, size_t size);
+
+    //! Called by the Multiplexer when the worker peer_worker_rank has received
+    //! size bytes and returns the credit for them.
+    void OnCredit(size_t peer_worker_rank, size_t size);
+
+    //! \}
+
     /*------------------------------------------------------------------------*/
     ///////// expose these members - getters would be too java-ish /////////////
 
@@ -158,6 +175,10 @@ public:
     //! to the network layer for transmission.
     tlx::Semaphore sem_queue_;
 
+    //! StatsCounter for the number of times a StreamSink had to wait for
+    //! credit from the receiver.
+    std::atomic<size_t> tx_net_credit_stalls_ { 0 };
+
     ///////////////////////////////////////////////////////////////////////////
 
 protected:
@@ -189,6 +210,16 @@ protected:
     //! bool if all writers were closed
     bool all_writers_closed_ = false;
 
+    //! remaining byte credit granted by each receiving worker, empty if
+    //! credit-based flow control is disabled.
+    std::vector<std::ptrdiff_t> credits_;
+
+    //! mutex protecting credits_
+    std::mutex credit_mutex_;
+
+    //! condition variable to wait on for returned credit
+    std::condition_variable cv_credit_;
+
     //! friends for access to multiplexer_
     friend class StreamSink;
 };
@@ -211,6 +242,11 @@ public:
     //! method called from StreamSink when it is closed, used to aggregate Close
     //! messages to remote hosts
     virtual void OnWriterClosed(size_t peer_worker_rank, bool sent) = 0;
+
+    //! method called from the Multiplexer when the worker peer_worker_rank
+    //! returned credit to the local worker local_worker_id.
+    virtual void OnCredit(size_t local_worker_id, size_t peer_worker_rank,
+                          size_t size) = 0;
 };
 
 /*!
@@ -243,6 +279,11 @@ public:
     //! messages to remote hosts
     void OnWriterClosed(size_t peer_worker_rank, bool sent);
 
+    //! method called from the Multiplexer when the worker peer_worker_rank
+    //! returned credit to the local worker local_worker_id.
+    void OnCredit(size_t local_worker_id, size_t peer_worker_rank,
+                  size_t size) final;
+
     //! Returns my_host_rank
     size_t my_host_rank() const { return multiplexer_.my_host_rank(); }
     //! Number of hosts in system
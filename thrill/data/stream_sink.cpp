@@ -185,6 +185,9 @@ void StreamSink::AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) {
         stream_->tx_int_bytes_ += block.size();
         stream_->tx_int_blocks_++;
 
+        // move the Block's pages to the NUMA node of the consumer
+        block_pool()->MigrateToWorker(block, peer_local_worker_);
+
         return block_queue_->AppendPinnedBlock(std::move(block), is_last_block);
     }
     if (target_mix_stream_) {
@@ -193,6 +196,9 @@ void StreamSink::AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) {
         stream_->tx_int_bytes_ += block.size();
         stream_->tx_int_blocks_++;
 
+        // move the Block's pages to the NUMA node of the consumer
+        block_pool()->MigrateToWorker(block, peer_local_worker_);
+
         return target_mix_stream_->OnStreamBlock(
             my_worker_rank(), block_counter_ - 1,
             std::move(block).MoveToBlock());
@@ -217,14 +223,23 @@ void StreamSink::AppendPinnedBlock(PinnedBlock&& block, bool is_last_block) {
     size_t send_size = buffer.size() + block.size();
     // stream_->sem_queue_.wait(send_size);
 
+    // wait for the receiver to grant credit for the Block
+    stream_->AcquireCredit(peer_worker_rank(), block.size());
+
     // StreamData statistics for network transfer
     stream_->tx_net_items_ += block.num_items();
     stream_->tx_net_bytes_ += send_size;
     stream_->tx_net_blocks_++;
     byte_counter_ += buffer.size();
 
-    stream_->multiplexer_.dispatcher_.AsyncWrite(
-        *connection_, 42 + (connection_->tx_seq_.fetch_add(2) & 0xFFFF),
+    // select one of the parallel connections to the peer
+    Multiplexer& multiplexer = stream_->multiplexer_;
+    size_t link = multiplexer.SelectLink(
+        peer_rank_, header.seq, my_worker_rank(), peer_local_worker_);
+    net::Connection& conn = multiplexer.link_connection(link);
+
+    multiplexer.link_dispatcher(link).AsyncWrite(
+        conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
         // send out Buffer and Block, guaranteed to be successive
         std::move(buffer), std::move(block),
         [s = stream_, send_size](net::Connection&) {
@@ -274,6 +289,41 @@ void StreamSink::Close() {
             my_worker_rank(), block_counter_ - 1, Block());
     }
 
+    if (stream_->multiplexer_.num_stripes() > 1) {
+        // with parallel connections, the aggregated all-workers close message
+        // may overtake Blocks on other stripes, hence we send an explicit close
+        // Block carrying the next sequence number.
+        StreamMultiplexerHeader header;
+        header.magic = magic_;
+        header.stream_id = id_;
+        header.sender_worker = my_worker_rank();
+        header.receiver_local_worker = peer_local_worker_;
+        header.seq = block_counter_ - 1;
+
+        net::BufferBuilder bb;
+        header.Serialize(bb);
+
+        net::Buffer buffer = bb.ToBuffer();
+        assert(buffer.size() == MultiplexerHeader::total_size);
+
+        stream_->tx_net_bytes_ += buffer.size();
+        stream_->tx_net_blocks_++;
+        byte_counter_ += buffer.size();
+
+        Multiplexer& multiplexer = stream_->multiplexer_;
+        size_t link = multiplexer.SelectLink(
+            peer_rank_, header.seq, my_worker_rank(), peer_local_worker_);
+        net::Connection& conn = multiplexer.link_connection(link);
+
+        multiplexer.link_dispatcher(link).AsyncWrite(
+            conn, 42 + (conn.tx_seq_.fetch_add(2) & 0xFFFF),
+            std::move(buffer));
+
+        stream_->OnWriterClosed(peer_worker_rank(), /* sent */ true);
+
+        return Finalize();
+    }
+
     stream_->OnWriterClosed(peer_worker_rank(), /* sent */ false);
 
     Finalize();
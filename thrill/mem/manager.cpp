@@ -11,20 +11,37 @@
 #include <thrill/common/logger.hpp>
 #include <thrill/mem/manager.hpp>
 
+#include <atomic>
 #include <cstdio>
 
 namespace thrill {
 namespace mem {
 
+constexpr size_t Manager::num_shards;
+constexpr int64_t Manager::flush_threshold;
+
 Manager::~Manager() {
+    // hand pending deltas to the superiors, which may outlive this Manager.
+    flush();
+
     // You can not use the logger here, because there is maybe no
     // LoggerAllocator any more
     if (debug) {
+        size_t alloc_count = 0;
+        for (const Shard& s : shards_)
+            alloc_count += s.allocs.load();
         printf("mem::Manager() name=%s alloc_count_=%zu peak_=%zu total_=%zu\n",
-               name_, alloc_count_.load(), peak_.load(), total_.load());
+               name_, alloc_count, peak_.load(), total_.load());
     }
 }
 
+size_t Manager::shard_index() {
+    // assign shards to threads round-robin on their first allocation
+    static std::atomic<size_t> s_next_shard { 0 };
+    static thread_local size_t tl_shard = s_next_shard++ % num_shards;
+    return tl_shard;
+}
+
 Manager g_bypass_manager(nullptr, "Bypass");
 
 } // namespace mem
@@ -12,9 +12,12 @@
 #ifndef THRILL_MEM_MANAGER_HEADER
 #define THRILL_MEM_MANAGER_HEADER
 
+#include <thrill/common/config.hpp>
+
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 
 namespace thrill {
 namespace mem {
@@ -24,12 +27,25 @@ namespace mem {
  * allocations. These is one global mem::Manager per compute host. To track
  * memory consumption of subcomponents of Thrill, one can create local child
  * mem::Managers which report allocation automatically to their superiors.
+ *
+ * To avoid all threads bouncing the same cache lines, allocations are first
+ * counted in one of num_shards cache line aligned shards, selected by the
+ * calling thread. A shard's delta is flushed into the total and up the chain of
+ * superiors once it exceeds flush_threshold bytes. total() sums the pending
+ * deltas and is exact for this Manager, while the totals of superiors lag by
+ * at most num_shards * flush_threshold bytes per child Manager.
  */
 class Manager
 {
     static constexpr bool debug = false;
 
 public:
+    //! number of shards for batching add() and subtract()
+    static constexpr size_t num_shards = 16;
+
+    //! pending delta of a shard which is flushed to the total and superiors
+    static constexpr int64_t flush_threshold = 256 * 1024;
+
     explicit Manager(Manager* super, const char* name)
         : super_(super), name_(name)
     { }
@@ -40,40 +56,89 @@ public:
     Manager * super() { return super_; }
 
     //! return total allocation (local value)
-    size_t total() const { return total_; }
+    size_t total() const {
+        int64_t total = static_cast<int64_t>(total_.load());
+        for (const Shard& s : shards_)
+            total += s.delta.load(std::memory_order_relaxed);
+        return static_cast<size_t>(total);
+    }
 
     //! add memory consumption.
     Manager& add(size_t amount) {
-        size_t current = (total_ += amount);
-        peak_ = std::max(peak_.load(), current);
-        ++alloc_count_;
-        if (super_) super_->add(amount);
+        Shard& s = shards_[shard_index()];
+        s.allocs.fetch_add(1, std::memory_order_relaxed);
+        int64_t d = s.delta.fetch_add(
+            static_cast<int64_t>(amount), std::memory_order_relaxed)
+                    + static_cast<int64_t>(amount);
+        if (d >= flush_threshold)
+            flush(s);
         return *this;
     }
 
     //! subtract memory consumption.
     Manager& subtract(size_t amount) {
-        assert(total_ >= amount);
-        total_ -= amount;
-        if (super_) super_->subtract(amount);
+        assert(total() >= amount);
+        Shard& s = shards_[shard_index()];
+        int64_t d = s.delta.fetch_sub(
+            static_cast<int64_t>(amount), std::memory_order_relaxed)
+                    - static_cast<int64_t>(amount);
+        if (d <= -flush_threshold)
+            flush(s);
         return *this;
     }
 
+    //! flush all pending deltas to the total and up the chain of superiors.
+    void flush() {
+        for (Shard& s : shards_)
+            flush(s);
+    }
+
 private:
+    //! pending delta and allocation count of a group of threads, aligned such
+    //! that no cache line is shared.
+    struct Shard {
+        alignas(common::g_cache_line_size)
+        std::atomic<int64_t> delta { 0 };
+        std::atomic<size_t> allocs { 0 };
+    };
+
+    static_assert(sizeof(Shard) % common::g_cache_line_size == 0,
+                  "struct Shard has incorrect size.");
+
     //! reference to superior memory counter
     Manager* super_;
 
     //! description for output
     const char* name_;
 
-    //! total allocation
+    //! total allocation, excluding pending deltas in the shards
     std::atomic<size_t> total_ { 0 };
 
-    //! peak allocation
+    //! peak allocation, updated when flushing
     std::atomic<size_t> peak_ { 0 };
 
-    //! number of allocation
-    std::atomic<size_t> alloc_count_ { 0 };
+    //! shards for pending deltas
+    Shard shards_[num_shards];
+
+    //! shard of the calling thread
+    static size_t shard_index();
+
+    //! move the pending delta of a shard to total_ and the superiors.
+    void flush(Shard& s) {
+        int64_t d = s.delta.exchange(0, std::memory_order_relaxed);
+        if (d != 0) apply(d);
+    }
+
+    //! apply a delta to total_ and up the chain of superiors.
+    void apply(int64_t delta) {
+        // two's complement wrap around subtracts negative deltas
+        size_t current = (total_ += static_cast<size_t>(delta));
+        // total_ may be transiently negative while increments of other shards
+        // or children are pending.
+        if (delta > 0 && static_cast<int64_t>(current) > 0)
+            peak_ = std::max(peak_.load(), current);
+        if (super_) super_->apply(delta);
+    }
 };
 
 } // namespace mem
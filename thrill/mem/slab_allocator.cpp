@@ -0,0 +1,231 @@
+/*******************************************************************************
+ * thrill/mem/slab_allocator.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/logger.hpp>
+#include <thrill/mem/slab_allocator.hpp>
+
+#include <tlx/die.hpp>
+#include <tlx/math/integer_log2.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+#if !defined(_MSC_VER)
+#include <sys/mman.h>
+#endif
+
+namespace thrill {
+namespace mem {
+
+constexpr size_t SlabAllocator::chunk_size;
+constexpr size_t SlabAllocator::min_size;
+constexpr size_t SlabAllocator::num_classes;
+
+//! index of the size class of a slab size
+static size_t SizeClass(size_t size) {
+    return tlx::integer_log2_floor(size)
+           - tlx::integer_log2_floor(SlabAllocator::min_size);
+}
+
+SlabAllocator::SlabAllocator(Manager* manager)
+    : manager_(manager) { }
+
+SlabAllocator::~SlabAllocator() {
+    // all slabs must be free again
+    die_unequal(cached_bytes_.load(), mapped_bytes_.load());
+
+    for (Chunk* chunk : chunks_) {
+#if !defined(_MSC_VER)
+        munmap(chunk->begin, chunk_size);
+#endif
+        delete chunk;
+    }
+    if (manager_) manager_->subtract(mapped_bytes_);
+}
+
+void* SlabAllocator::allocate(size_t size) {
+    assert(is_slab_size(size));
+    size_t c = SizeClass(size);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    Chunk* chunk = partial_[c];
+    if (!chunk) {
+        if (!empty_.empty()) {
+            // recycle an empty chunk of any size class
+            chunk = empty_.back();
+            empty_.pop_back();
+        }
+        else {
+            char* begin = static_cast<char*>(MapChunk());
+            if (!begin) return nullptr;
+
+            chunk = new Chunk;
+            chunk->begin = begin;
+            chunks_.insert(
+                std::upper_bound(
+                    chunks_.begin(), chunks_.end(), chunk,
+                    [](const Chunk* a, const Chunk* b) {
+                        return a->begin < b->begin;
+                    }),
+                chunk);
+            mapped_bytes_ += chunk_size;
+            cached_bytes_ += chunk_size;
+            if (manager_) manager_->add(chunk_size);
+        }
+
+        // carve the chunk into slabs of this size class
+        chunk->size_class = c;
+        chunk->free = nullptr;
+        for (size_t off = chunk_size; off != 0; off -= size) {
+            FreeSlab* slab = reinterpret_cast<FreeSlab*>(
+                chunk->begin + off - size);
+            slab->next = chunk->free;
+            chunk->free = slab;
+        }
+        LinkPartial(chunk);
+    }
+
+    FreeSlab* slab = chunk->free;
+    chunk->free = slab->next;
+    ++chunk->used;
+    if (!chunk->free) UnlinkPartial(chunk);
+    cached_bytes_ -= size;
+
+    return slab;
+}
+
+void SlabAllocator::deallocate(void* ptr, size_t size) {
+    assert(is_slab_size(size));
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Chunk* chunk = FindChunk(ptr);
+    die_unless(chunk && chunk->size_class == SizeClass(size));
+
+    bool was_full = (chunk->free == nullptr);
+    FreeSlab* slab = static_cast<FreeSlab*>(ptr);
+    slab->next = chunk->free;
+    chunk->free = slab;
+    --chunk->used;
+    cached_bytes_ += size;
+
+    if (chunk->used == 0) {
+        // all slabs free: the chunk may be carved for another size class.
+        if (!was_full) UnlinkPartial(chunk);
+        empty_.push_back(chunk);
+    }
+    else if (was_full) {
+        LinkPartial(chunk);
+    }
+}
+
+bool SlabAllocator::owns(const void* ptr) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return FindChunk(ptr) != nullptr;
+}
+
+size_t SlabAllocator::ReleaseCached(size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    size_t released = 0;
+    while (released < size && !empty_.empty()) {
+        Chunk* chunk = empty_.back();
+        empty_.pop_back();
+
+        chunks_.erase(std::find(chunks_.begin(), chunks_.end(), chunk));
+#if !defined(_MSC_VER)
+        munmap(chunk->begin, chunk_size);
+#endif
+        delete chunk;
+
+        mapped_bytes_ -= chunk_size;
+        cached_bytes_ -= chunk_size;
+        released += chunk_size;
+    }
+    lock.unlock();
+
+    if (manager_ && released) manager_->subtract(released);
+    return released;
+}
+
+SlabAllocator::Chunk* SlabAllocator::FindChunk(const void* ptr) {
+    // chunks are aligned to chunk_size, hence round down to the chunk start.
+    const char* begin = reinterpret_cast<const char*>(
+        reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t(chunk_size) - 1));
+
+    std::vector<Chunk*>::const_iterator it = std::lower_bound(
+        chunks_.begin(), chunks_.end(), begin,
+        [](const Chunk* a, const char* b) { return a->begin < b; });
+    return it != chunks_.end() && (*it)->begin == begin ? *it : nullptr;
+}
+
+void SlabAllocator::LinkPartial(Chunk* chunk) {
+    Chunk*& head = partial_[chunk->size_class];
+    chunk->prev = nullptr;
+    chunk->next = head;
+    if (head) head->prev = chunk;
+    head = chunk;
+}
+
+void SlabAllocator::UnlinkPartial(Chunk* chunk) {
+    if (chunk->prev)
+        chunk->prev->next = chunk->next;
+    else
+        partial_[chunk->size_class] = chunk->next;
+    if (chunk->next) chunk->next->prev = chunk->prev;
+    chunk->prev = chunk->next = nullptr;
+}
+
+void* SlabAllocator::MapChunk() {
+#if !defined(_MSC_VER)
+#if defined(MAP_HUGETLB)
+    if (!explicit_failed_) {
+        // explicit huge pages are reserved by the administrator, e.g. via
+        // /proc/sys/vm/nr_hugepages.
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_HUGE_SHIFT)
+        flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+        void* p = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE,
+                       flags, -1, 0);
+        if (p != MAP_FAILED) {
+            ++huge_chunks_;
+            return p;
+        }
+        LOG << "SlabAllocator: no explicit huge pages available,"
+            << " using transparent huge pages.";
+        explicit_failed_ = true;
+    }
+#endif
+    // map twice the size and cut out a chunk_size aligned chunk
+    void* p = mmap(nullptr, 2 * chunk_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+
+    char* begin = static_cast<char*>(p);
+    char* chunk = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(begin) + chunk_size - 1)
+        & ~(uintptr_t(chunk_size) - 1));
+    if (chunk != begin)
+        munmap(begin, chunk - begin);
+    if (chunk + chunk_size != begin + 2 * chunk_size)
+        munmap(chunk + chunk_size, begin + 2 * chunk_size - chunk - chunk_size);
+
+#if defined(MADV_HUGEPAGE)
+    madvise(chunk, chunk_size, MADV_HUGEPAGE);
+#endif
+    return chunk;
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace mem
+} // namespace thrill
+
+/******************************************************************************/
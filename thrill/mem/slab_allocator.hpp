@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * thrill/mem/slab_allocator.hpp
+ *
+ * Slab allocator for ByteBlock memory, which carves power of two size classes
+ * out of chunks backed by explicit or transparent 2 MiB huge pages.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_MEM_SLAB_ALLOCATOR_HEADER
+#define THRILL_MEM_SLAB_ALLOCATOR_HEADER
+
+#include <thrill/mem/aligned_allocator.hpp>
+#include <thrill/mem/manager.hpp>
+
+#include <tlx/math/is_power_of_two.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace thrill {
+namespace mem {
+
+/*!
+ * Slab allocator for large aligned buffers. Memory is mapped from the OS in
+ * chunks of 2 MiB, preferably backed by explicit huge pages (MAP_HUGETLB), else
+ * by transparent huge pages (madvise(MADV_HUGEPAGE)). Each chunk is carved into
+ * slabs of one power of two size class between THRILL_DEFAULT_ALIGN and the
+ * chunk size. Free slabs are kept in per-chunk free lists for reuse. Once all
+ * slabs of a chunk are free, it returns to a shared list of empty chunks, from
+ * which it is carved again for any size class, or unmapped by ReleaseCached().
+ *
+ * The mapped chunks, including free slabs kept for reuse, are counted in the
+ * mem::Manager, since they occupy RAM.
+ */
+class SlabAllocator
+{
+    static constexpr bool debug = false;
+
+public:
+    //! size of the chunks mapped from the OS, which is the largest size class
+    static constexpr size_t chunk_size = 2 * 1024 * 1024;
+
+    //! smallest size class
+    static constexpr size_t min_size = THRILL_DEFAULT_ALIGN;
+
+    //! number of size classes
+    static constexpr size_t num_classes = 10;
+
+    static_assert(min_size << (num_classes - 1) == chunk_size,
+                  "size classes must range from min_size to chunk_size");
+
+    explicit SlabAllocator(Manager* manager);
+
+    //! non-copyable: delete copy-constructor
+    SlabAllocator(const SlabAllocator&) = delete;
+    //! non-copyable: delete assignment operator
+    SlabAllocator& operator = (const SlabAllocator&) = delete;
+
+    //! unmaps all chunks, all slabs must have been returned.
+    ~SlabAllocator();
+
+    //! whether allocations of size bytes are served from slabs
+    static bool is_slab_size(size_t size) {
+        return size >= min_size && size <= chunk_size &&
+               tlx::is_power_of_two(size);
+    }
+
+    //! allocate a slab of size bytes, returns nullptr if no chunk can be mapped.
+    void * allocate(size_t size);
+
+    //! return a slab of size bytes for reuse.
+    void deallocate(void* ptr, size_t size);
+
+    //! whether ptr points into a chunk of this allocator
+    bool owns(const void* ptr);
+
+    //! unmap empty chunks until at least size bytes are released or none are
+    //! left, returns the number of bytes released.
+    size_t ReleaseCached(size_t size);
+
+    //! number of bytes mapped from the OS
+    size_t mapped_bytes() const { return mapped_bytes_; }
+
+    //! number of bytes in free slabs and empty chunks kept for reuse
+    size_t cached_bytes() const { return cached_bytes_; }
+
+    //! number of chunks backed by explicit huge pages
+    size_t huge_chunks() const { return huge_chunks_; }
+
+private:
+    //! free slabs are linked through their first bytes
+    struct FreeSlab {
+        FreeSlab* next;
+    };
+
+    //! header of a mapped chunk
+    struct Chunk {
+        //! address of the chunk
+        char* begin;
+        //! size class the chunk is currently carved into
+        size_t size_class = 0;
+        //! number of slabs handed out
+        size_t used = 0;
+        //! free slabs of the chunk
+        FreeSlab* free = nullptr;
+        //! doubly linked list of partially used chunks of a size class
+        Chunk* prev = nullptr, * next = nullptr;
+    };
+
+    //! memory manager to count mapped chunks
+    Manager* manager_;
+
+    //! protects the chunk lists
+    std::mutex mutex_;
+
+    //! list of chunks with free slabs per size class
+    std::array<Chunk*, num_classes> partial_ { };
+
+    //! chunks with all slabs free, which can be carved for any size class
+    std::vector<Chunk*> empty_;
+
+    //! all chunks sorted by address
+    std::vector<Chunk*> chunks_;
+
+    //! whether explicit huge pages could not be mapped, then only transparent
+    //! huge pages are used.
+    bool explicit_failed_ = false;
+
+    //! statistics
+    std::atomic<size_t> mapped_bytes_ { 0 }, cached_bytes_ { 0 },
+        huge_chunks_ { 0 };
+
+    //! map a chunk_size aligned chunk from the OS, or nullptr.
+    void * MapChunk();
+
+    //! return the chunk containing ptr, or nullptr.
+    Chunk * FindChunk(const void* ptr);
+
+    //! insert a chunk into the list of partially used chunks of its class
+    void LinkPartial(Chunk* chunk);
+
+    //! remove a chunk from the list of partially used chunks of its class
+    void UnlinkPartial(Chunk* chunk);
+};
+
+} // namespace mem
+} // namespace thrill
+
+#endif // !THRILL_MEM_SLAB_ALLOCATOR_HEADER
+
+/******************************************************************************/
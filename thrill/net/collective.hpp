@@ -25,7 +25,10 @@
 #include <tlx/math/is_power_of_two.hpp>
 #include <tlx/math/round_to_power_of_two.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <utility>
+#include <vector>
 
 namespace thrill {
 namespace net {
@@ -234,10 +237,110 @@ void Group::BroadcastBinomialTree(T& value, size_t origin) {
     }
 }
 
+/*!
+ * Broadcasts the value of the worker with index "origin" to all the others
+ * along the tree of BroadcastTree(): if a host topology is set, a binomial tree
+ * among origin and the rack leaders crosses racks once, followed by binomial
+ * trees inside each rack.
+ *
+ * \param value The value to be broadcast / receive into.
+ *
+ * \param origin The PE to broadcast value from.
+ */
+template <typename T>
+void Group::BroadcastHierarchical(T& value, size_t origin) {
+    size_t parent;
+    std::vector<size_t> children;
+    BroadcastTree(origin, &parent, &children);
+
+    if (my_host_rank() != origin)
+        ReceiveFrom(parent, &value);
+    for (const size_t& child : children)
+        SendTo(child, value);
+}
+
+/*!
+ * Broadcasts the value of the worker with index "origin" to all the others by
+ * serializing it and sending the bytes in chunks along the chain origin,
+ * origin + 1, ..., origin - 1. Each host forwards a chunk as soon as it has
+ * received it, hence, the time is nearly independent of the number of hosts for
+ * large values.
+ *
+ * \param value The value to be broadcast / receive into.
+ *
+ * \param origin The PE to broadcast value from.
+ */
+template <typename T>
+void Group::BroadcastPipelinedChain(T& value, size_t origin) {
+    if (num_hosts() <= 1) return;
+
+    BufferBuilder bb;
+    if (my_host_rank() == origin)
+        data::Serialization<BufferBuilder, T>::Serialize(value, bb);
+
+    size_t size = bb.size();
+    BroadcastChainBytes(&size, sizeof(size), origin);
+
+    if (my_host_rank() != origin)
+        bb.Reserve(size).set_size(size);
+    BroadcastChainBytes(bb.data(), size, origin);
+
+    if (my_host_rank() != origin) {
+        BufferReader br(bb.data(), bb.size());
+        value = data::Serialization<BufferReader, T>::Deserialize(br);
+    }
+}
+
 //! select broadcast implementation (often due to total number of processors)
 template <typename T>
 void Group::BroadcastSelect(T& value, size_t origin) {
-    return BroadcastBinomialTree(value, origin);
+    using Serialization = data::Serialization<BufferBuilder, T>;
+
+    // small fixed-size items are sent directly along a tree
+    if (Serialization::is_fixed_size &&
+        Serialization::fixed_size < kBroadcastChainThreshold) {
+        if (hierarchical())
+            return BroadcastHierarchical(value, origin);
+        return BroadcastBinomialTree(value, origin);
+    }
+
+    // otherwise serialize and distribute the size along the tree, small items
+    // follow the same path, large ones are sent along the pipelined chain.
+    size_t parent;
+    std::vector<size_t> children;
+    BroadcastTree(origin, &parent, &children);
+
+    BufferBuilder bb;
+    if (my_host_rank() == origin)
+        Serialization::Serialize(value, bb);
+
+    size_t size = bb.size();
+    if (my_host_rank() != origin)
+        connection(parent).SyncRecv(&size, sizeof(size));
+    for (const size_t& child : children) {
+        connection(child).SyncSend(
+            &size, sizeof(size),
+            size < kBroadcastChainThreshold ? Connection::MsgMore
+            : Connection::NoFlags);
+    }
+
+    if (my_host_rank() != origin)
+        bb.Reserve(size).set_size(size);
+
+    if (size < kBroadcastChainThreshold) {
+        if (my_host_rank() != origin)
+            connection(parent).SyncRecv(bb.data(), size);
+        for (const size_t& child : children)
+            connection(child).SyncSend(bb.data(), size);
+    }
+    else {
+        BroadcastChainBytes(bb.data(), size, origin);
+    }
+
+    if (my_host_rank() != origin) {
+        BufferReader br(bb.data(), bb.size());
+        value = data::Serialization<BufferReader, T>::Deserialize(br);
+    }
 }
 
 /*!
@@ -253,6 +356,28 @@ void Group::Broadcast(T& value, size_t origin) {
     return BroadcastSelect(value, origin);
 }
 
+/*!
+ * Broadcasts the value of hosts[0] to all hosts in the list using a binomial
+ * tree.
+ */
+template <typename T>
+void Group::BroadcastHosts(
+    T& value, const std::vector<size_t>& hosts, size_t my_index) {
+    const size_t n = hosts.size();
+    size_t d = 1;
+    if (my_index > 0) {
+        d <<= tlx::ffs(my_index) - 1;
+        ReceiveFrom(hosts[my_index ^ d], &value);
+    }
+    else {
+        d = tlx::round_up_to_power_of_two(n);
+    }
+    for (d >>= 1; d > 0; d >>= 1) {
+        if (my_index + d < n)
+            SendTo(hosts[my_index + d], value);
+    }
+}
+
 /******************************************************************************/
 // AllGather Algorithms
 
@@ -354,6 +479,27 @@ void Group::Reduce(T& value, size_t root, BinarySumOp sum_op) {
     }
 }
 
+/*!
+ * Reduce the values of all hosts in the list to hosts[0] using a binomial
+ * tree. The reduction is applied in the order of the list.
+ */
+template <typename T, typename BinarySumOp>
+void Group::ReduceHosts(T& value, const std::vector<size_t>& hosts,
+                        size_t my_index, BinarySumOp sum_op) {
+    const size_t n = hosts.size();
+    for (size_t d = 1; d < n; d <<= 1) {
+        if (my_index & d) {
+            SendTo(hosts[my_index - d], value);
+            break;
+        }
+        else if (my_index + d < n) {
+            T recv_data;
+            ReceiveFrom(hosts[my_index + d], &recv_data);
+            value = sum_op(value, recv_data);
+        }
+    }
+}
+
 /******************************************************************************/
 // AllReduce Algorithms
 
@@ -546,10 +692,172 @@ void Group::AllReduceEliminationProcess(
     }
 }
 
+template <typename T, typename BinarySumOp>
+void Group::AllReduceHosts(T& value, const std::vector<size_t>& hosts,
+                           size_t my_index, BinarySumOp sum_op) {
+    ReduceHosts(value, hosts, my_index, sum_op);
+    BroadcastHosts(value, hosts, my_index);
+}
+
+template <typename Type, typename Operation>
+void Group::AllReduceHosts(
+    std::vector<Type>& values, const std::vector<size_t>& hosts,
+    size_t my_index,
+    common::ComponentSum<std::vector<Type>, Operation> sum_op) {
+    // all hosts must contribute vectors of equal size, hence, they agree on the
+    // algorithm.
+    if (values.size() * sizeof(Type) >= kAllReduceRabenseifnerThreshold)
+        return AllReduceRabenseifnerHosts(values, hosts, my_index, sum_op);
+    ReduceHosts(values, hosts, my_index, sum_op);
+    BroadcastHosts(values, hosts, my_index);
+}
+
+/*!
+ * Perform an All-Reduce of component-wise vector sums using the bandwidth
+ * optimal algorithm described in R. Rabenseifner. "Optimization of Collective
+ * Reduction Operations." In International Conference on Computational Science,
+ * 1–9. LNCS 3036. Springer, 2004.
+ *
+ * The vector is reduced-scattered by recursive halving, such that each host
+ * holds the sum of one segment, and then all-gathered by recursive doubling.
+ * Each host sends and receives only about twice the vector size. For a
+ * non-power-of-two number of hosts, the first hosts are folded pairwise
+ * beforehand. All hosts must contribute vectors of equal size.
+ */
+template <typename Type, typename Operation>
+void Group::AllReduceRabenseifnerHosts(
+    std::vector<Type>& values, const std::vector<size_t>& hosts,
+    size_t my_index,
+    const common::ComponentSum<std::vector<Type>, Operation>& sum_op) {
+    using Vector = std::vector<Type>;
+
+    const size_t n = hosts.size();
+    if (n <= 1) return;
+
+    // exchange with a peer, the host with lower rank receives first.
+    auto exchange = [this](size_t peer, const Vector& send, Vector* recv) {
+                        if (my_host_rank() > peer)
+                            connection(peer).SendReceive(&send, recv);
+                        else
+                            connection(peer).ReceiveSend(send, recv);
+                    };
+
+    // fold the first 2 * excess hosts pairwise onto the odd ones
+    const size_t p2 = tlx::round_down_to_power_of_two(n);
+    const size_t excess = n - p2;
+
+    size_t vrank;
+    if (my_index < 2 * excess) {
+        if (my_index % 2 == 0) {
+            SendTo(hosts[my_index + 1], values);
+            ReceiveFrom(hosts[my_index + 1], &values);
+            return;
+        }
+        Vector recv_data;
+        ReceiveFrom(hosts[my_index - 1], &recv_data);
+        values = sum_op(recv_data, values);
+        vrank = my_index / 2;
+    }
+    else {
+        vrank = my_index - excess;
+    }
+
+    // host of a virtual rank among the p2 remaining hosts
+    auto vhost = [&](size_t v) {
+                     return hosts[v < excess ? 2 * v + 1 : v + excess];
+                 };
+
+    // reduce-scatter by recursive halving, ranges holds the segment [lo,hi)
+    // before each halving step. Peers are combined with increasing distance,
+    // such that each partial sum covers consecutive hosts and is applied in
+    // rank order.
+    std::vector<std::pair<size_t, size_t> > ranges;
+    size_t lo = 0, hi = values.size();
+
+    for (size_t d = 1; d < p2; d <<= 1) {
+        ranges.emplace_back(lo, hi);
+        size_t mid = lo + (hi - lo) / 2;
+        bool lower = (vrank & d) == 0;
+
+        Vector send_data(values.begin() + (lower ? mid : lo),
+                         values.begin() + (lower ? hi : mid));
+        if (lower) hi = mid;
+        else lo = mid;
+
+        Vector recv_data;
+        exchange(vhost(vrank ^ d), send_data, &recv_data);
+
+        Vector mine(values.begin() + lo, values.begin() + hi);
+        Vector sum = lower ? sum_op(mine, recv_data) : sum_op(recv_data, mine);
+        std::copy(sum.begin(), sum.end(), values.begin() + lo);
+    }
+
+    // allgather by recursive doubling in reverse order
+    for (size_t d = p2 / 2; d > 0; d >>= 1) {
+        size_t plo = ranges.back().first, phi = ranges.back().second;
+        ranges.pop_back();
+
+        Vector send_data(values.begin() + lo, values.begin() + hi);
+        Vector recv_data;
+        exchange(vhost(vrank ^ d), send_data, &recv_data);
+
+        // the peer holds the other half of the parent segment
+        size_t peer_lo = (lo == plo) ? hi : plo;
+        assert(recv_data.size() == (lo == plo ? phi - hi : lo - plo));
+        std::copy(recv_data.begin(), recv_data.end(),
+                  values.begin() + peer_lo);
+        lo = plo, hi = phi;
+    }
+
+    // unfold: send result to the folded partner
+    if (my_index < 2 * excess)
+        SendTo(hosts[my_index - 1], values);
+}
+
+/*!
+ * Perform a hierarchical All-Reduce: values are reduced to the leader of each
+ * rack, all-reduced among the rack leaders, and broadcast inside each rack
+ * again. Hence, only one value per rack crosses the inter-rack links.
+ */
+template <typename T, typename BinarySumOp>
+void Group::AllReduceHierarchical(T& value, BinarySumOp sum_op) {
+    if (!hierarchical())
+        return AllReduceElimination(value, sum_op);
+
+    size_t my_rack = host_rack(my_host_rank());
+
+    std::vector<size_t> rack_hosts;
+    for (size_t h = rack_begin(my_rack); h < rack_end(my_rack); ++h)
+        rack_hosts.push_back(h);
+    size_t rack_index = my_host_rank() - rack_begin(my_rack);
+
+    ReduceHosts(value, rack_hosts, rack_index, sum_op);
+
+    if (rack_index == 0) {
+        std::vector<size_t> leaders;
+        for (size_t r = 0; r < num_racks(); ++r)
+            leaders.push_back(rack_begin(r));
+        AllReduceHosts(value, leaders, my_rack, sum_op);
+    }
+
+    BroadcastHosts(value, rack_hosts, rack_index);
+}
+
+template <typename Type, typename Operation>
+void Group::AllReduceRabenseifner(
+    std::vector<Type>& values,
+    common::ComponentSum<std::vector<Type>, Operation> sum_op) {
+    std::vector<size_t> hosts(num_hosts());
+    for (size_t h = 0; h < hosts.size(); ++h) hosts[h] = h;
+    AllReduceRabenseifnerHosts(values, hosts, my_host_rank(), sum_op);
+}
+
 //! select allreduce implementation (often due to total number of processors)
 template <typename T, typename BinarySumOp>
 void Group::AllReduceSelect(T& value, BinarySumOp sum_op) {
-    // always use 3-2-elimination reduction method.
+    if (hierarchical())
+        return AllReduceHierarchical(value, sum_op);
+    // otherwise always use 3-2-elimination reduction method.
     AllReduceElimination(value, sum_op);
     /*if (tlx::is_power_of_two(num_hosts()))
         AllReduceHypercube(value, sum_op);
@@ -557,6 +865,19 @@ void Group::AllReduceSelect(T& value, BinarySumOp sum_op) {
         AllReduceAtRoot(value, sum_op);*/
 }
 
+//! select allreduce implementation for component-wise vector sums: large
+//! vectors use Rabenseifner's algorithm.
+template <typename Type, typename Operation>
+void Group::AllReduceSelect(
+    std::vector<Type>& values,
+    common::ComponentSum<std::vector<Type>, Operation> sum_op) {
+    if (hierarchical())
+        return AllReduceHierarchical(values, sum_op);
+    if (values.size() * sizeof(Type) >= kAllReduceRabenseifnerThreshold)
+        return AllReduceRabenseifner(values, sum_op);
+    AllReduceElimination(values, sum_op);
+}
+
 /*!
  * Perform an All-Reduce on the workers.  This is done by aggregating all values
  * according to a summation operator and sending them backto all workers.
@@ -65,9 +65,11 @@ public:
     //! Signature of async jobs to be run by the dispatcher thread.
     using Job = tlx::delegate<void (), mem::GPoolAllocator<char> >;
 
+    //! Start the dispatcher thread. Additional dispatchers on one host are
+    //! distinguished by index, which also selects the core they are pinned to.
     DispatcherThread(
         std::unique_ptr<class Dispatcher> dispatcher,
-        size_t host_rank);
+        size_t host_rank, size_t index = 0);
 
     ~DispatcherThread();
 
@@ -171,6 +173,9 @@ private:
 
     //! for thread name for logging
     size_t host_rank_;
+
+    //! index of the dispatcher on this host, for thread name and pinning
+    size_t index_;
 };
 
 //! \}
@@ -8,25 +8,78 @@
  * All rights reserved. Published under the BSD-2 license in the LICENSE file.
  ******************************************************************************/
 
+#include <thrill/common/logger.hpp>
 #include <thrill/net/flow_control_channel.hpp>
 
 #include <functional>
+#include <memory>
 
 namespace thrill {
 namespace net {
 
+/******************************************************************************/
+// CollectiveThread
+
+CollectiveThread::~CollectiveThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    terminate_ = true;
+    lock.unlock();
+    cv_.notify_all();
+
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void CollectiveThread::Enqueue(Job&& job) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.emplace_back(std::move(job));
+    ++pending_;
+    if (!thread_.joinable())
+        thread_ = std::thread(&CollectiveThread::Work, this);
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void CollectiveThread::WaitAll() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_ != 0)
+        cv_.wait(lock);
+}
+
+void CollectiveThread::Work() {
+    common::NameThisThread("collectives");
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        while (jobs_.empty() && !terminate_)
+            cv_.wait(lock);
+        if (jobs_.empty()) break;
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        --pending_;
+        cv_.notify_all();
+    }
+}
+
 /******************************************************************************/
 // FlowControlChannel
 
 FlowControlChannel::FlowControlChannel(
     Group& group, size_t local_id, size_t thread_count,
     common::ThreadBarrier& barrier, LocalData* shmem,
-    std::atomic<size_t>& generation)
+    std::atomic<size_t>& generation, CollectiveThread& collective_thread)
     : group_(group),
       host_rank_(group_.my_host_rank()), num_hosts_(group_.num_hosts()),
       local_id_(local_id),
       thread_count_(thread_count),
-      barrier_(barrier), shmem_(shmem), generation_(generation) { }
+      barrier_(barrier), collective_thread_(collective_thread),
+      shmem_(shmem), generation_(generation) { }
 
 FlowControlChannel::~FlowControlChannel() {
     sLOGC(enable_stats)
@@ -56,6 +109,7 @@ void FlowControlChannel::Barrier() {
     barrier_.wait(
         [&]() {
             RunTimer net_timer(timer_communication_);
+            collective_thread_.WaitAll();
 
             LOG << "FCC::Barrier() COMMUNICATE BEGIN"
                 << " count=" << count_barrier_;
@@ -71,6 +125,38 @@ void FlowControlChannel::Barrier() {
     LOG << "FCC::Barrier() EXIT count=" << count_barrier_;
 }
 
+std::shared_future<void> FlowControlChannel::BarrierAsync() {
+    if (enable_stats || debug) ++count_barrier_;
+
+    std::shared_future<void> future;
+    size_t step = GetNextStep();
+    SetLocalShared(step, &future);
+
+    barrier_.wait(
+        [&]() {
+            auto promise = std::make_shared<std::promise<void> >();
+            std::shared_future<void> f = promise->get_future().share();
+            for (size_t i = 0; i < thread_count_; i++) {
+                *GetLocalShared<std::shared_future<void> >(step, i) = f;
+            }
+
+            Group& group = group_;
+            collective_thread_.Enqueue(
+                [&group, promise]() {
+                    try {
+                        size_t i = 0;
+                        group.AllReduce(i);
+                        promise->set_value();
+                    }
+                    catch (...) {
+                        promise->set_exception(std::current_exception());
+                    }
+                });
+        });
+
+    return future;
+}
+
 void FlowControlChannel::LocalBarrier() {
     barrier_.wait();
 }
@@ -22,9 +22,14 @@
 #include <algorithm>
 #include <array>
 #include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -34,12 +39,64 @@ namespace net {
 //! \addtogroup net_layer
 //! \{
 
+/*!
+ * Thread which runs the host-global communication of asynchronous collectives
+ * in the order they were submitted. The thread is started on first use and
+ * joined after all jobs are done on destruction.
+ */
+class CollectiveThread
+{
+public:
+    using Job = std::function<void()>;
+
+    CollectiveThread() = default;
+
+    //! non-copyable: delete copy-constructor
+    CollectiveThread(const CollectiveThread&) = delete;
+    //! non-copyable: delete assignment operator
+    CollectiveThread& operator = (const CollectiveThread&) = delete;
+
+    ~CollectiveThread();
+
+    //! Enqueue job, starts the thread if not running yet.
+    void Enqueue(Job&& job);
+
+    //! Wait until all enqueued jobs are done.
+    void WaitAll();
+
+private:
+    //! What happens in the collective thread
+    void Work();
+
+    //! mutex protecting all fields
+    std::mutex mutex_;
+
+    //! condition variable for new jobs and finished jobs
+    std::condition_variable cv_;
+
+    //! queue of jobs to run
+    std::deque<Job> jobs_;
+
+    //! number of enqueued but unfinished jobs
+    size_t pending_ = 0;
+
+    //! termination flag
+    bool terminate_ = false;
+
+    //! the thread, if started
+    std::thread thread_;
+};
+
 /*!
  * Provides a blocking collection for communication.
  *
  * This wraps a raw net group, adds multi-worker/thread support, and should be
  * used for flow control with integral types.
  *
+ * Local workers are combined via shared memory and one thread runs the
+ * net::Group collective between hosts, which selects the algorithm by host
+ * topology (see Group::SetHostRacks()) and message size.
+ *
  * Important notice on threading: It is not allowed to call two different
  * methods of two different instances of FlowControlChannel simultaniously by
  * different threads, since the internal synchronization state (the barrier) is
@@ -93,6 +150,9 @@ private:
     //! node.
     common::ThreadBarrier& barrier_;
 
+    //! Host-global thread running asynchronous collectives.
+    CollectiveThread& collective_thread_;
+
     //! Thread local data structure: aligned such that no cache line is
     //! shared. The actual vector is in the FlowControlChannelManager.
     class LocalData
@@ -188,7 +248,7 @@ public:
     FlowControlChannel(
         Group& group, size_t local_id, size_t thread_count,
         common::ThreadBarrier& barrier, LocalData* shmem,
-        std::atomic<size_t>& generation);
+        std::atomic<size_t>& generation, CollectiveThread& collective_thread);
 
     //! Return the associated net::Group. USE AT YOUR OWN RISK.
     Group& group() { return group_; }
@@ -249,6 +309,7 @@ public:
         barrier_.wait(
             [&]() {
                 RunTimer net_timer(timer_communication_);
+                collective_thread_.WaitAll();
 
                 LOG << "FCC::PrefixSum() COMMUNICATE BEGIN"
                     << " count=" << count_prefixsum_;
@@ -364,6 +425,7 @@ public:
         barrier_.wait(
             [&]() {
                 RunTimer net_timer(timer_communication_);
+                collective_thread_.WaitAll();
 
                 LOG << "FCC::ExPrefixSumTotal() COMMUNICATE BEGIN"
                     << " count=" << count_prefixsum_;
@@ -438,6 +500,7 @@ public:
 
         if (local_id_ == primary_pe) {
             RunTimer net_timer(timer_communication_);
+            collective_thread_.WaitAll();
             group_.Broadcast(local, origin / thread_count_);
         }
 
@@ -489,6 +552,7 @@ public:
         barrier_.wait(
             [&]() {
                 RunTimer net_timer(timer_communication_);
+                collective_thread_.WaitAll();
 
                 size_t n = num_workers();
 
@@ -556,6 +620,7 @@ public:
         barrier_.wait(
             [&]() {
                 RunTimer net_timer(timer_communication_);
+                collective_thread_.WaitAll();
 
                 LOG << "FCC::Reduce() COMMUNICATE BEGIN"
                     << " count=" << count_reduce_;
@@ -610,6 +675,7 @@ public:
         barrier_.wait(
             [&]() {
                 RunTimer net_timer(timer_communication_);
+                collective_thread_.WaitAll();
 
                 LOG << "FCC::AllReduce() COMMUNICATE BEGIN"
                     << " count=" << count_allreduce_;
@@ -637,6 +703,198 @@ public:
         return local;
     }
 
+    /*!
+     * \name Asynchronous Collectives
+     *
+     * These must be called by all local workers in the same order as the
+     * blocking collectives. The local values are combined via shared memory,
+     * then the host-global communication is enqueued for the CollectiveThread,
+     * which runs it in submission order while the workers continue. The
+     * returned future becomes ready when the collective is done. Blocking
+     * collectives first wait for all pending asynchronous ones.
+     * \{
+     */
+
+    /*!
+     * Asynchronously reduces a value of a serializable type T over all workers
+     * given a certain reduce function, see AllReduce().
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::shared_future<T> TLX_ATTRIBUTE_WARN_UNUSED_RESULT
+    AllReduceAsync(const T& value, const BinarySumOp& sum_op = BinarySumOp()) {
+
+        if (enable_stats || debug) ++count_allreduce_;
+        LOG << "FCC::AllReduceAsync() ENTER count=" << count_allreduce_;
+
+        using Local = std::pair<T, std::shared_future<T> >;
+        Local local(value, std::shared_future<T>());
+
+        size_t step = GetNextStep();
+        SetLocalShared(step, &local);
+
+        barrier_.wait(
+            [&]() {
+                // local reduce
+                T local_sum = GetLocalShared<Local>(step, 0)->first;
+                for (size_t i = 1; i < thread_count_; i++) {
+                    local_sum = sum_op(
+                        local_sum, GetLocalShared<Local>(step, i)->first);
+                }
+
+                auto promise = std::make_shared<std::promise<T> >();
+                std::shared_future<T> future = promise->get_future().share();
+                for (size_t i = 0; i < thread_count_; i++) {
+                    GetLocalShared<Local>(step, i)->second = future;
+                }
+
+                // global reduce in the collective thread
+                Group& group = group_;
+                collective_thread_.Enqueue(
+                    [&group, promise, local_sum, sum_op]() {
+                        try {
+                            T sum = local_sum;
+                            group.AllReduce(sum, sum_op);
+                            promise->set_value(std::move(sum));
+                        }
+                        catch (...) {
+                            promise->set_exception(std::current_exception());
+                        }
+                    });
+            });
+
+        LOG << "FCC::AllReduceAsync() EXIT count=" << count_allreduce_;
+
+        return local.second;
+    }
+
+    /*!
+     * Asynchronously calculates the prefix sum over all workers, see
+     * PrefixSumBase().
+     */
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    std::shared_future<T> TLX_ATTRIBUTE_WARN_UNUSED_RESULT
+    PrefixSumAsync(const T& value, const BinarySumOp& sum_op = BinarySumOp(),
+                   const T& initial = T(), bool inclusive = true) {
+
+        if (enable_stats || debug) ++count_prefixsum_;
+        LOG << "FCC::PrefixSumAsync() ENTER count=" << count_prefixsum_;
+
+        using Local = std::pair<T, std::shared_future<T> >;
+        Local local(value, std::shared_future<T>());
+
+        size_t step = GetNextStep();
+        SetLocalShared(step, &local);
+
+        barrier_.wait(
+            [&]() {
+                // local inclusive prefix sums
+                std::vector<T> locals;
+                locals.reserve(thread_count_);
+                locals.push_back(GetLocalShared<Local>(step, 0)->first);
+                for (size_t i = 1; i < thread_count_; i++) {
+                    locals.push_back(sum_op(
+                                         locals.back(),
+                                         GetLocalShared<Local>(step, i)->first));
+                }
+
+                auto promises =
+                    std::make_shared<std::vector<std::promise<T> > >(
+                        thread_count_);
+                for (size_t i = 0; i < thread_count_; i++) {
+                    GetLocalShared<Local>(step, i)->second =
+                        (*promises)[i].get_future().share();
+                }
+
+                // global exclusive prefix sum in the collective thread
+                Group& group = group_;
+                collective_thread_.Enqueue(
+                    [&group, promises, locals, sum_op, initial, inclusive]() {
+                        // number of promises already fulfilled, sum_op may
+                        // throw after some of them.
+                        size_t done = 0;
+                        try {
+                            T base_sum = locals.back();
+                            group.ExPrefixSum(base_sum, sum_op, initial);
+
+                            for (; done < locals.size(); done++) {
+                                if (inclusive)
+                                    (*promises)[done].set_value(
+                                        sum_op(base_sum, locals[done]));
+                                else if (done == 0)
+                                    (*promises)[done].set_value(base_sum);
+                                else
+                                    (*promises)[done].set_value(
+                                        sum_op(base_sum, locals[done - 1]));
+                            }
+                        }
+                        catch (...) {
+                            for (; done < promises->size(); done++) {
+                                (*promises)[done].set_exception(
+                                    std::current_exception());
+                            }
+                        }
+                    });
+            });
+
+        LOG << "FCC::PrefixSumAsync() EXIT count=" << count_prefixsum_;
+
+        return local.second;
+    }
+
+    /*!
+     * Asynchronously broadcasts a value of a serializable type T from the
+     * worker origin to all other workers, see Broadcast().
+     */
+    template <typename T>
+    std::shared_future<T> TLX_ATTRIBUTE_WARN_UNUSED_RESULT
+    BroadcastAsync(const T& value, size_t origin = 0) {
+
+        if (enable_stats || debug) ++count_broadcast_;
+        LOG << "FCC::BroadcastAsync() ENTER count=" << count_broadcast_;
+
+        using Local = std::pair<T, std::shared_future<T> >;
+        Local local(value, std::shared_future<T>());
+
+        size_t step = GetNextStep();
+        SetLocalShared(step, &local);
+
+        barrier_.wait(
+            [&]() {
+                T origin_value =
+                    GetLocalShared<Local>(step, origin % thread_count_)->first;
+
+                auto promise = std::make_shared<std::promise<T> >();
+                std::shared_future<T> future = promise->get_future().share();
+                for (size_t i = 0; i < thread_count_; i++) {
+                    GetLocalShared<Local>(step, i)->second = future;
+                }
+
+                Group& group = group_;
+                size_t origin_host = origin / thread_count_;
+                collective_thread_.Enqueue(
+                    [&group, promise, origin_value, origin_host]() {
+                        try {
+                            T res = origin_value;
+                            group.Broadcast(res, origin_host);
+                            promise->set_value(std::move(res));
+                        }
+                        catch (...) {
+                            promise->set_exception(std::current_exception());
+                        }
+                    });
+            });
+
+        LOG << "FCC::BroadcastAsync() EXIT count=" << count_broadcast_;
+
+        return local.second;
+    }
+
+    //! Asynchronous global barrier: the future becomes ready when all workers
+    //! have entered it.
+    std::shared_future<void> TLX_ATTRIBUTE_WARN_UNUSED_RESULT BarrierAsync();
+
+    //! \}
+
     /*!
      * Collects up to k predecessors of type T from preceding PEs. k must be
      * equal on all PEs.
@@ -665,6 +923,10 @@ public:
         // get generation counter
         size_t this_gen = generation_.load(std::memory_order_acquire) + 1;
 
+        // the first and last local worker communicate with other hosts
+        if (local_id_ == 0 || local_id_ + 1 == thread_count_)
+            collective_thread_.WaitAll();
+
         if (my_values.size() >= k) {
             // if we already have k items, then "transmit" them to our successor
             if (local_id_ + 1 != thread_count_) {
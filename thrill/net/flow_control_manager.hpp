@@ -33,6 +33,9 @@ private:
     //! node.
     common::ThreadBarrier barrier_;
 
+    //! Thread running asynchronous collectives, must outlive the channels.
+    CollectiveThread collective_thread_;
+
     //! The flow control channels associated with this node.
     std::vector<FlowControlChannel> channels_;
 
@@ -59,7 +62,8 @@ public:
         channels_.reserve(local_worker_count);
         for (size_t i = 0; i < local_worker_count; i++) {
             channels_.emplace_back(group, i, local_worker_count,
-                                   barrier_, shmem_.data(), generation_);
+                                   barrier_, shmem_.data(), generation_,
+                                   collective_thread_);
         }
     }
 
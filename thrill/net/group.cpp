@@ -17,6 +17,10 @@
 #include <thrill/net/tcp/group.hpp>
 #endif
 
+#include <tlx/math/ffs.hpp>
+#include <tlx/math/round_to_power_of_two.hpp>
+
+#include <algorithm>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -70,11 +74,13 @@ net::Traffic Manager::Traffic() const {
     for (size_t g = 0; g < kGroupCount; ++g) {
         Group& group = *groups_[g];
 
-        for (size_t h = 0; h < group.num_hosts(); ++h) {
-            if (h == group.my_host_rank()) continue;
+        for (size_t s = 0; s < group.num_stripes(); ++s) {
+            for (size_t h = 0; h < group.num_hosts(); ++h) {
+                if (h == group.my_host_rank()) continue;
 
-            total_tx += group.connection(h).tx_bytes_;
-            total_rx += group.connection(h).rx_bytes_;
+                total_tx += group.stripe_connection(h, s).tx_bytes_;
+                total_rx += group.stripe_connection(h, s).rx_bytes_;
+            }
         }
     }
 
@@ -104,28 +110,30 @@ void Manager::RunTask(const std::chrono::steady_clock::time_point& tp) {
         std::vector<size_t> tx_per_host(group.num_hosts());
         std::vector<size_t> rx_per_host(group.num_hosts());
 
-        for (size_t h = 0; h < group.num_hosts(); ++h) {
-            if (h == group.my_host_rank()) continue;
+        for (size_t s = 0; s < group.num_stripes(); ++s) {
+            for (size_t h = 0; h < group.num_hosts(); ++h) {
+                if (h == group.my_host_rank()) continue;
 
-            Connection& conn = group.connection(h);
+                Connection& conn = group.stripe_connection(h, s);
 
-            size_t tx = conn.tx_bytes_.load(std::memory_order_relaxed);
-            size_t rx = conn.rx_bytes_.load(std::memory_order_relaxed);
-            size_t prev_tx = conn.prev_tx_bytes_;
-            size_t prev_rx = conn.prev_rx_bytes_;
+                size_t tx = conn.tx_bytes_.load(std::memory_order_relaxed);
+                size_t rx = conn.rx_bytes_.load(std::memory_order_relaxed);
+                size_t prev_tx = conn.prev_tx_bytes_;
+                size_t prev_rx = conn.prev_rx_bytes_;
 
-            group_tx += tx;
-            prev_group_tx += prev_tx;
-            group.connection(h).prev_tx_bytes_ = tx;
-            group_tx_active += conn.tx_active_;
+                group_tx += tx;
+                prev_group_tx += prev_tx;
+                conn.prev_tx_bytes_ = tx;
+                group_tx_active += conn.tx_active_;
 
-            group_rx += rx;
-            prev_group_rx += prev_rx;
-            group.connection(h).prev_rx_bytes_ = rx;
-            group_rx_active += conn.rx_active_;
+                group_rx += rx;
+                prev_group_rx += prev_rx;
+                conn.prev_rx_bytes_ = rx;
+                group_rx_active += conn.rx_active_;
 
-            tx_per_host[h] = tx;
-            rx_per_host[h] = rx;
+                tx_per_host[h] += tx;
+                rx_per_host[h] += rx;
+            }
         }
 
         line.sub(g == 0 ? "flow" : g == 1 ? "data" : "???")
@@ -167,6 +175,119 @@ size_t Group::num_parallel_async() const {
     return 0;
 }
 
+constexpr size_t Group::kBroadcastChainThreshold;
+constexpr size_t Group::kBroadcastChainChunk;
+constexpr size_t Group::kAllReduceRabenseifnerThreshold;
+
+bool Group::SetHostRacks(const std::vector<size_t>& host_racks) {
+    rack_begin_.clear();
+    if (host_racks.size() != num_hosts())
+        return false;
+
+    std::vector<size_t> seen;
+    for (size_t h = 0; h < host_racks.size(); ++h) {
+        if (h != 0 && host_racks[h] == host_racks[h - 1]) continue;
+        // a rack must not reappear after another one started
+        if (std::find(seen.begin(), seen.end(), host_racks[h]) != seen.end()) {
+            rack_begin_.clear();
+            return false;
+        }
+        seen.push_back(host_racks[h]);
+        rack_begin_.push_back(h);
+    }
+    return true;
+}
+
+size_t Group::host_rack(size_t host) const {
+    assert(host < num_hosts());
+    if (rack_begin_.empty()) return 0;
+    return std::upper_bound(rack_begin_.begin(), rack_begin_.end(), host)
+           - rack_begin_.begin() - 1;
+}
+
+//! Calculate parent and children of shifted rank in a binomial tree of n nodes
+//! rooted at rank 0.
+static void BinomialTree(size_t n, size_t rank,
+                         size_t* parent, std::vector<size_t>* children) {
+    size_t d = 1;
+    if (rank > 0) {
+        d <<= tlx::ffs(rank) - 1;
+        *parent = rank ^ d;
+    }
+    else {
+        d = tlx::round_up_to_power_of_two(n);
+    }
+    for (d >>= 1; d > 0; d >>= 1) {
+        if (rank + d < n)
+            children->push_back(rank + d);
+    }
+}
+
+void Group::BroadcastTree(size_t origin, size_t* parent,
+                          std::vector<size_t>* children) const {
+    const size_t p = num_hosts(), my_rank = my_host_rank();
+    children->clear();
+
+    if (!hierarchical()) {
+        size_t shifted_parent;
+        std::vector<size_t> shifted;
+        BinomialTree(p, (my_rank + p - origin) % p, &shifted_parent, &shifted);
+        if (my_rank != origin)
+            *parent = (shifted_parent + origin) % p;
+        for (const size_t& c : shifted)
+            children->push_back((c + origin) % p);
+        return;
+    }
+
+    // inter-rack tree among the representatives of each rack: origin for its
+    // own rack and the rack leaders otherwise.
+    const size_t R = num_racks();
+    const size_t origin_rack = host_rack(origin), my_rack = host_rack(my_rank);
+    auto rack_rep = [&](size_t r) {
+                        return r == origin_rack ? origin : rack_begin(r);
+                    };
+
+    const size_t my_rep = rack_rep(my_rack);
+    if (my_rank == my_rep) {
+        size_t shifted_parent;
+        std::vector<size_t> shifted;
+        BinomialTree(R, (my_rack + R - origin_rack) % R,
+                     &shifted_parent, &shifted);
+        if (my_rank != origin)
+            *parent = rack_rep((shifted_parent + origin_rack) % R);
+        for (const size_t& c : shifted)
+            children->push_back(rack_rep((c + origin_rack) % R));
+    }
+
+    // intra-rack tree rooted at the representative
+    const size_t begin = rack_begin(my_rack);
+    const size_t size = rack_end(my_rack) - begin;
+    const size_t root = my_rep - begin;
+
+    size_t shifted_parent;
+    std::vector<size_t> shifted;
+    BinomialTree(size, (my_rank - begin + size - root) % size,
+                 &shifted_parent, &shifted);
+    if (my_rank != my_rep)
+        *parent = begin + (shifted_parent + root) % size;
+    for (const size_t& c : shifted)
+        children->push_back(begin + (c + root) % size);
+}
+
+void Group::BroadcastChainBytes(void* data, size_t size, size_t origin) {
+    const size_t p = num_hosts();
+    const size_t pos = (my_host_rank() + p - origin) % p;
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(data);
+
+    for (size_t offset = 0; offset < size; offset += kBroadcastChainChunk) {
+        size_t n = std::min(kBroadcastChainChunk, size - offset);
+        if (pos != 0)
+            connection((my_host_rank() + p - 1) % p).SyncRecv(bytes + offset, n);
+        if (pos + 1 != p)
+            connection((my_host_rank() + 1) % p).SyncSend(bytes + offset, n);
+    }
+}
+
 /*[[[perl
   for my $e (
     ["int", "Int"], ["unsigned int", "UnsignedInt"],
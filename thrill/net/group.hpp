@@ -22,7 +22,10 @@
 #include <thrill/common/math.hpp>
 #include <thrill/net/connection.hpp>
 
+#include <tlx/unused.hpp>
+
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <functional>
 #include <thread>
@@ -74,6 +77,17 @@ public:
     //! Return Connection to client id.
     virtual Connection& connection(size_t id) = 0;
 
+    //! Number of parallel connections (stripes) to each peer. Stripe 0 is
+    //! always the Connection returned by connection(id).
+    virtual size_t num_stripes() const { return 1; }
+
+    //! Return the stripe-th parallel Connection to client id.
+    virtual Connection& stripe_connection(size_t id, size_t stripe) {
+        assert(stripe < num_stripes());
+        tlx::unused(stripe);
+        return connection(id);
+    }
+
     //! Close
     virtual void Close() = 0;
 
@@ -99,6 +113,48 @@ public:
 
     //! \}
 
+    //! \name Host Topology
+    //! \{
+
+    //! Set the rack (or switch) id of each host. The collectives then run
+    //! intra-rack phases before a small inter-rack phase. Since reductions are
+    //! applied in rank order, hosts of a rack must have consecutive ranks,
+    //! otherwise the topology is rejected and false is returned.
+    bool SetHostRacks(const std::vector<size_t>& host_racks);
+
+    //! Number of racks, one if no topology was set.
+    size_t num_racks() const {
+        return rack_begin_.empty() ? 1 : rack_begin_.size();
+    }
+
+    //! Whether collectives use the host topology: there must be more than one
+    //! rack and at least one rack must contain multiple hosts.
+    bool hierarchical() const {
+        return num_racks() > 1 && num_racks() < num_hosts();
+    }
+
+    //! Return the rack index of a host.
+    size_t host_rack(size_t host) const;
+
+    //! First host of rack r, the rack's leader.
+    size_t rack_begin(size_t r) const {
+        return rack_begin_.empty() ? 0 : rack_begin_[r];
+    }
+
+    //! One past the last host of rack r.
+    size_t rack_end(size_t r) const {
+        return r + 1 < rack_begin_.size() ? rack_begin_[r + 1] : num_hosts();
+    }
+
+    //! Calculate the parent (undefined on origin) and the children of this
+    //! host in the broadcast tree rooted at origin. Without topology this is a
+    //! binomial tree, otherwise a binomial tree among origin and the leaders of
+    //! all other racks is followed by binomial trees inside each rack.
+    void BroadcastTree(size_t origin,
+                       size_t* parent, std::vector<size_t>* children) const;
+
+    //! \}
+
     //! \name Convenience Functions
     //! \{
 
@@ -179,6 +235,12 @@ public:
     template <typename T>
     void BroadcastBinomialTree(T& value, size_t origin = 0);
 
+    template <typename T>
+    void BroadcastHierarchical(T& value, size_t origin = 0);
+
+    template <typename T>
+    void BroadcastPipelinedChain(T& value, size_t origin = 0);
+
     /**************************************************************************/
 
     template <typename T>
@@ -204,6 +266,30 @@ public:
     template <typename T, typename BinarySumOp = std::plus<T> >
     void AllReduceElimination(T& value, BinarySumOp sum_op = BinarySumOp());
 
+    template <typename T, typename BinarySumOp = std::plus<T> >
+    void AllReduceHierarchical(T& value, BinarySumOp sum_op = BinarySumOp());
+
+    template <typename Type, typename Operation>
+    void AllReduceSelect(
+        std::vector<Type>& values,
+        common::ComponentSum<std::vector<Type>, Operation> sum_op);
+
+    template <typename Type, typename Operation>
+    void AllReduceRabenseifner(
+        std::vector<Type>& values,
+        common::ComponentSum<std::vector<Type>, Operation> sum_op);
+
+    //! Serialized payloads of at least this size are broadcast along a
+    //! pipelined chain instead of a tree.
+    static constexpr size_t kBroadcastChainThreshold = 1024 * 1024;
+
+    //! Chunk size of the pipelined chain broadcast.
+    static constexpr size_t kBroadcastChainChunk = 64 * 1024;
+
+    //! Component-wise vector sums of at least this many bytes are all-reduced
+    //! using Rabenseifner's reduce-scatter/allgather algorithm.
+    static constexpr size_t kAllReduceRabenseifnerThreshold = 64 * 1024;
+
     /**************************************************************************/
 
 protected:
@@ -227,10 +313,53 @@ protected:
 
     //! \}
 
+    //! \name Collectives on a Subset of Hosts
+    //! Used by the hierarchical collectives, the subset is given as list of
+    //! hosts in rank order, my_index is this host's position in it.
+    //! \{
+
+    //! Reduce to hosts[0], applying sum_op in list order.
+    template <typename T, typename BinarySumOp>
+    void ReduceHosts(T& value, const std::vector<size_t>& hosts,
+                     size_t my_index, BinarySumOp sum_op);
+
+    //! Binomial tree broadcast from hosts[0].
+    template <typename T>
+    void BroadcastHosts(T& value, const std::vector<size_t>& hosts,
+                        size_t my_index);
+
+    //! Reduce and broadcast back among hosts.
+    template <typename T, typename BinarySumOp>
+    void AllReduceHosts(T& value, const std::vector<size_t>& hosts,
+                        size_t my_index, BinarySumOp sum_op);
+
+    //! Large component-wise vector sums use Rabenseifner's algorithm.
+    template <typename Type, typename Operation>
+    void AllReduceHosts(
+        std::vector<Type>& values, const std::vector<size_t>& hosts,
+        size_t my_index,
+        common::ComponentSum<std::vector<Type>, Operation> sum_op);
+
+    //! Rabenseifner's reduce-scatter and allgather AllReduce.
+    template <typename Type, typename Operation>
+    void AllReduceRabenseifnerHosts(
+        std::vector<Type>& values, const std::vector<size_t>& hosts,
+        size_t my_index,
+        const common::ComponentSum<std::vector<Type>, Operation>& sum_op);
+
+    //! Send a byte buffer along the chain of hosts starting at origin in
+    //! pipelined chunks.
+    void BroadcastChainBytes(void* data, size_t size, size_t origin);
+
+    //! \}
+
 protected:
     //! our rank in the network group
     size_t my_rank_;
 
+    //! first host of each rack if a topology was set, ascending.
+    std::vector<size_t> rack_begin_;
+
     //! \name Virtual Synchronous Collectives to Override Implementations
     //! \{
 
@@ -76,7 +76,8 @@ public:
         : socket_(std::move(other.socket_)),
           state_(other.state_),
           group_id_(other.group_id_),
-          peer_id_(other.peer_id_) {
+          peer_id_(other.peer_id_),
+          stripe_id_(other.stripe_id_) {
         other.state_ = ConnectionState::Invalid;
     }
 
@@ -90,6 +91,7 @@ public:
         state_ = other.state_;
         group_id_ = other.group_id_;
         peer_id_ = other.peer_id_;
+        stripe_id_ = other.stripe_id_;
 
         other.state_ = ConnectionState::Invalid;
         return *this;
@@ -107,6 +109,11 @@ public:
     size_t peer_id() const
     { return peer_id_; }
 
+    //! Gets the index of this connection among the parallel connections to
+    //! the same peer.
+    size_t stripe_id() const
+    { return stripe_id_; }
+
     //! Sets the state of this connection.
     void set_state(ConnectionState state)
     { state_ = state; }
@@ -119,6 +126,10 @@ public:
     void set_peer_id(size_t peerId)
     { peer_id_ = peerId; }
 
+    //! Sets the stripe index of this connection.
+    void set_stripe_id(size_t stripeId)
+    { stripe_id_ = stripeId; }
+
     //! Check whether the contained file descriptor is valid.
     bool IsValid() const final
     { return socket_.IsValid(); }
@@ -238,6 +249,9 @@ private:
 
     //! The id of the worker this connection is connected to.
     size_t peer_id_ = size_t(-1);
+
+    //! The index of this connection among parallel connections to the peer.
+    size_t stripe_id_ = 0;
 };
 
 // \}
@@ -16,9 +16,11 @@
 
 #include <tlx/die.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <map>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -35,11 +37,16 @@ class Construction
 
 public:
     Construction(SelectDispatcher& dispatcher,
-                 std::unique_ptr<Group>* groups, size_t group_count)
+                 std::unique_ptr<Group>* groups, size_t group_count,
+                 const size_t* num_stripes = nullptr)
         : dispatcher_(dispatcher),
           groups_(groups),
-          group_count_(group_count)
-    { }
+          group_count_(group_count),
+          num_stripes_(group_count, 1) {
+        if (num_stripes)
+            std::copy(num_stripes, num_stripes + group_count,
+                      num_stripes_.begin());
+    }
 
     /*!
      * Initializes this Manager and initializes all Groups.  When this method
@@ -58,7 +65,9 @@ public:
         LOG << "Client " << my_rank_ << " starting: " << endpoints[my_rank_];
 
         for (size_t i = 0; i < group_count_; i++) {
-            groups_[i] = std::make_unique<Group>(my_rank_, endpoints.size());
+            die_unless(num_stripes_[i] >= 1);
+            groups_[i] = std::make_unique<Group>(
+                my_rank_, endpoints.size(), num_stripes_[i]);
         }
 
         // Parse endpoints.
@@ -87,8 +96,10 @@ public:
 
         // Initiate connections to all hosts with higher id.
         for (uint32_t g = 0; g < group_count_; g++) {
-            for (size_t id = my_rank_ + 1; id < address_list.size(); ++id) {
-                AsyncConnect(g, id, address_list[id]);
+            for (size_t s = 0; s < num_stripes_[g]; ++s) {
+                for (size_t id = my_rank_ + 1; id < address_list.size(); ++id) {
+                    AsyncConnect(g, id, s, address_list[id]);
+                }
             }
         }
 
@@ -114,11 +125,13 @@ public:
 
         for (size_t j = 0; j < group_count_; j++) {
             // output list of file descriptors connected to partners
-            for (size_t i = 0; i != address_list.size(); ++i) {
-                if (i == my_rank_) continue;
-                LOG << "Group " << j
-                    << " link " << my_rank_ << " -> " << i << " = fd "
-                    << groups_[j]->tcp_connection(i).GetSocket().fd();
+            for (size_t s = 0; s < num_stripes_[j]; ++s) {
+                for (size_t i = 0; i != address_list.size(); ++i) {
+                    if (i == my_rank_) continue;
+                    LOG << "Group " << j << " stripe " << s
+                        << " link " << my_rank_ << " -> " << i << " = fd "
+                        << groups_[j]->tcp_connection(i, s).GetSocket().fd();
+                }
             }
         }
     }
@@ -136,14 +149,17 @@ private:
     //! number of groups to initialize
     size_t group_count_;
 
+    //! number of parallel connections per peer in each group
+    std::vector<size_t> num_stripes_;
+
     //! The rank associated with the local worker.
     size_t my_rank_ = size_t(-1);
 
     //! The Connections responsible for listening to incoming connections.
     Connection listener_;
 
-    //! Some definitions for convenience
-    using GroupNodeIdPair = std::pair<size_t, size_t>;
+    //! Some definitions for convenience: (group, id, stripe)
+    using GroupNodeIdTriple = std::tuple<size_t, size_t, size_t>;
 
     //! Array of opened connections that are not assigned to any (group,id)
     //! client, yet. This must be a deque. When welcomes are received the
@@ -152,7 +168,7 @@ private:
 
     //! Array of connect timeouts which are exponentially increased from 10msec
     //! on failed connects.
-    std::map<GroupNodeIdPair, size_t> timeouts_;
+    std::map<GroupNodeIdTriple, size_t> timeouts_;
 
     //! start connect backoff at 10msec
     const size_t initial_timeout_ = 10;
@@ -172,6 +188,9 @@ private:
 
         //! the id of the worker associated with the sending Connection.
         size_t   id;
+
+        //! the stripe index of the sending Connection.
+        size_t   stripe_id;
     };
 
     //! The Thrill signature flag - introduced by Master Timo.
@@ -211,14 +230,17 @@ private:
 
         for (size_t g = 0; g < group_count_; g++) {
 
-            for (size_t id = 0; id < groups_[g]->num_hosts(); ++id) {
-                if (id == my_rank_) continue;
-
-                // Just checking the state works since this implicitey checks the
-                // size. Unset connections have state ConnectionState::Invalid.
-                if (groups_[g]->tcp_connection(id).state()
-                    != ConnectionState::Connected)
-                    return false;
+            for (size_t s = 0; s < num_stripes_[g]; ++s) {
+                for (size_t id = 0; id < groups_[g]->num_hosts(); ++id) {
+                    if (id == my_rank_) continue;
+
+                    // Just checking the state works since this implicitey
+                    // checks the size. Unset connections have state
+                    // ConnectionState::Invalid.
+                    if (groups_[g]->tcp_connection(id, s).state()
+                        != ConnectionState::Connected)
+                        return false;
+                }
             }
         }
 
@@ -276,18 +298,20 @@ private:
      *
      * \param group The id of the Group to connect to.
      * \param id The id of the worker to connect to.
+     * \param stripe The index of the parallel connection to the worker.
      * \param address The address of the endpoint to connect to.
      */
     void AsyncConnect(
-        size_t group, size_t id, const SocketAddress& address) {
+        size_t group, size_t id, size_t stripe, const SocketAddress& address) {
 
         // Construct a new socket (old one is destroyed)
-        Connection& nc = groups_[group]->tcp_connection(id);
+        Connection& nc = groups_[group]->tcp_connection(id, stripe);
         if (nc.IsValid()) nc.Close();
 
         nc = Connection(Socket::Create());
         nc.set_group_id(group);
         nc.set_peer_id(id);
+        nc.set_stripe_id(stripe);
 
         AsyncConnect(nc, address);
     }
@@ -314,9 +338,9 @@ private:
     }
 
     //! calculate the next timeout on connect() errors
-    size_t NextConnectTimeout(size_t group, size_t id,
+    size_t NextConnectTimeout(size_t group, size_t id, size_t stripe,
                               const SocketAddress& address) {
-        GroupNodeIdPair gnip(group, id);
+        GroupNodeIdTriple gnip(group, id, stripe);
         auto it = timeouts_.find(gnip);
         if (it == timeouts_.end()) {
             it = timeouts_.insert(std::make_pair(gnip, initial_timeout_)).first;
@@ -367,7 +391,7 @@ private:
             // Connection refused. The other workers might not be online yet.
 
             size_t next_timeout = NextConnectTimeout(
-                tcp.group_id(), tcp.peer_id(), address);
+                tcp.group_id(), tcp.peer_id(), tcp.stripe_id(), address);
 
             LOG << "Connect to " << address.ToStringHostPort()
                 << " fd=" << tcp.GetSocket().fd()
@@ -379,7 +403,8 @@ private:
                 [&]() {
                     // Construct a new connection since the socket might not be
                     // reusable.
-                    AsyncConnect(tcp.group_id(), tcp.peer_id(), address);
+                    AsyncConnect(tcp.group_id(), tcp.peer_id(),
+                                 tcp.stripe_id(), address);
                     return false;
                 });
 
@@ -402,10 +427,13 @@ private:
             << " fd=" << tcp.GetSocket().fd()
             << " to=" << tcp.GetSocket().GetPeerAddress()
             << " err=" << err
-            << " group=" << tcp.group_id();
+            << " group=" << tcp.group_id()
+            << " stripe=" << tcp.stripe_id();
 
         // send welcome message
-        const WelcomeMsg hello = { thrill_sign, tcp.group_id(), my_rank_ };
+        const WelcomeMsg hello = {
+            thrill_sign, tcp.group_id(), my_rank_, tcp.stripe_id()
+        };
 
         dispatcher_.AsyncWriteCopy(
             tcp, /* seq */ 0, &hello, sizeof(hello),
@@ -454,6 +482,7 @@ private:
 
         die_unequal(tcp.peer_id(), msg->id);
         die_unequal(tcp.group_id(), msg->group_id);
+        die_unequal(tcp.stripe_id(), msg->stripe_id);
 
         tcp.set_state(ConnectionState::Connected);
     }
@@ -478,12 +507,15 @@ private:
 
         LOG << "client " << my_rank_ << " got signature from client"
             << " group " << msg_in->group_id
-            << " id " << msg_in->id;
+            << " id " << msg_in->id
+            << " stripe " << msg_in->stripe_id;
 
         die_unless(msg_in->group_id < group_count_);
         die_unless(msg_in->id < groups_[msg_in->group_id]->num_hosts());
+        die_unless(msg_in->stripe_id < num_stripes_[msg_in->group_id]);
 
-        die_unequal(groups_[msg_in->group_id]->tcp_connection(msg_in->id).state(),
+        die_unequal(groups_[msg_in->group_id]
+                    ->tcp_connection(msg_in->id, msg_in->stripe_id).state(),
                     ConnectionState::Invalid);
 
         // move connection into Group.
@@ -491,12 +523,15 @@ private:
         tcp.set_state(ConnectionState::HelloReceived);
         tcp.set_peer_id(msg_in->id);
         tcp.set_group_id(msg_in->group_id);
+        tcp.set_stripe_id(msg_in->stripe_id);
 
         Connection& c = groups_[msg_in->group_id]->AssignConnection(tcp);
 
         // send welcome message (via new connection's place)
 
-        const WelcomeMsg msg_out = { thrill_sign, msg_in->group_id, my_rank_ };
+        const WelcomeMsg msg_out = {
+            thrill_sign, msg_in->group_id, my_rank_, msg_in->stripe_id
+        };
 
         dispatcher_.AsyncWriteCopy(
             c, /* seq */ 0, &msg_out, sizeof(msg_out),
@@ -542,8 +577,9 @@ private:
 //! tcp::Group objects at once. Within each Group this host has my_rank.
 void Construct(SelectDispatcher& dispatcher, size_t my_rank,
                const std::vector<std::string>& endpoints,
-               std::unique_ptr<Group>* groups, size_t group_count) {
-    Construction(dispatcher, groups, group_count)
+               std::unique_ptr<Group>* groups, size_t group_count,
+               const size_t* num_stripes) {
+    Construction(dispatcher, groups, group_count, num_stripes)
     .Initialize(my_rank, endpoints);
 }
 
@@ -551,9 +587,10 @@ void Construct(SelectDispatcher& dispatcher, size_t my_rank,
 //! net::Group objects at once. Within each Group this host has my_rank.
 std::vector<std::unique_ptr<net::Group> >
 Construct(SelectDispatcher& dispatcher, size_t my_rank,
-          const std::vector<std::string>& endpoints, size_t group_count) {
+          const std::vector<std::string>& endpoints, size_t group_count,
+          const size_t* num_stripes) {
     std::vector<std::unique_ptr<tcp::Group> > tcp_groups(group_count);
-    Construction(dispatcher, &tcp_groups[0], tcp_groups.size())
+    Construction(dispatcher, &tcp_groups[0], tcp_groups.size(), num_stripes)
     .Initialize(my_rank, endpoints);
     std::vector<std::unique_ptr<net::Group> > groups(group_count);
     std::move(tcp_groups.begin(), tcp_groups.end(), groups.begin());
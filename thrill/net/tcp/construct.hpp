@@ -27,16 +27,20 @@ namespace tcp {
 //! \{
 
 //! Connect to peers via endpoints using TCP sockets. Construct a group_count
-//! tcp::Group objects at once. Within each Group this host has my_rank.
+//! tcp::Group objects at once. Within each Group this host has my_rank. If
+//! num_stripes is given, it must contain group_count entries with the number of
+//! parallel connections to each peer in the corresponding Group (default: 1).
 void Construct(SelectDispatcher& dispatcher, size_t my_rank,
                const std::vector<std::string>& endpoints,
-               std::unique_ptr<Group>* groups, size_t group_count);
+               std::unique_ptr<Group>* groups, size_t group_count,
+               const size_t* num_stripes = nullptr);
 
 //! Connect to peers via endpoints using TCP sockets. Construct a group_count
 //! net::Group objects at once. Within each Group this host has my_rank.
 std::vector<std::unique_ptr<net::Group> >
 Construct(SelectDispatcher& dispatcher, size_t my_rank,
-          const std::vector<std::string>& endpoints, size_t group_count);
+          const std::vector<std::string>& endpoints, size_t group_count,
+          const size_t* num_stripes = nullptr);
 
 //! \}
 
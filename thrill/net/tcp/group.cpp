@@ -34,27 +34,36 @@ Group::ConstructDispatcher() const {
 }
 
 std::vector<std::unique_ptr<Group> > Group::ConstructLoopbackMesh(
-    size_t num_hosts) {
+    size_t num_hosts, size_t num_stripes) {
 
     // construct a group of num_hosts
     std::vector<std::unique_ptr<Group> > group(num_hosts);
 
     for (size_t i = 0; i < num_hosts; ++i) {
-        group[i] = std::make_unique<Group>(i, num_hosts);
+        group[i] = std::make_unique<Group>(i, num_hosts, num_stripes);
     }
 
-    // construct a stream socket pair for (i,j) with i < j
-    for (size_t i = 0; i != num_hosts; ++i) {
-        for (size_t j = i + 1; j < num_hosts; ++j) {
-            LOG << "doing Socket::CreatePair() for i=" << i << " j=" << j;
+    // construct a stream socket pair for (i,j) with i < j for each stripe
+    for (size_t s = 0; s < num_stripes; ++s) {
+        for (size_t i = 0; i != num_hosts; ++i) {
+            for (size_t j = i + 1; j < num_hosts; ++j) {
+                LOG << "doing Socket::CreatePair() for i=" << i << " j=" << j
+                    << " stripe=" << s;
 
-            std::pair<Socket, Socket> sp = Socket::CreatePair();
+                std::pair<Socket, Socket> sp = Socket::CreatePair();
 
-            group[i]->connections_[j] = Connection(std::move(sp.first));
-            group[j]->connections_[i] = Connection(std::move(sp.second));
+                Connection& ci = group[i]->tcp_connection(j, s);
+                Connection& cj = group[j]->tcp_connection(i, s);
 
-            group[i]->connections_[j].is_loopback_ = true;
-            group[j]->connections_[i].is_loopback_ = true;
+                ci = Connection(std::move(sp.first));
+                cj = Connection(std::move(sp.second));
+
+                ci.set_stripe_id(s);
+                cj.set_stripe_id(s);
+
+                ci.is_loopback_ = true;
+                cj.is_loopback_ = true;
+            }
         }
     }
 
@@ -62,7 +71,7 @@ std::vector<std::unique_ptr<Group> > Group::ConstructLoopbackMesh(
 }
 
 std::vector<std::unique_ptr<Group> > Group::ConstructLocalRealTCPMesh(
-    size_t num_hosts) {
+    size_t num_hosts, size_t num_stripes) {
 
     // randomize base port number for test
     std::default_random_engine generator(std::random_device { } ());
@@ -86,10 +95,11 @@ std::vector<std::unique_ptr<Group> > Group::ConstructLocalRealTCPMesh(
 
     for (size_t i = 0; i < num_hosts; i++) {
         threads[i] = std::thread(
-            [i, &endpoints, &groups]() {
+            [i, num_stripes, &endpoints, &groups]() {
                 // construct Group i with endpoints -- with temporary Dispatcher
                 net::tcp::SelectDispatcher dispatcher;
-                Construct(dispatcher, i, endpoints, groups.data() + i, 1);
+                Construct(dispatcher, i, endpoints, groups.data() + i, 1,
+                          &num_stripes);
             });
     }
 
@@ -55,19 +55,22 @@ public:
      * protocols.
      */
     static std::vector<std::unique_ptr<Group> > ConstructLoopbackMesh(
-        size_t num_hosts);
+        size_t num_hosts, size_t num_stripes = 1);
 
     /*!
      * Construct a test network with an underlying full mesh of *REAL* tcp
      * streams interconnected via localhost ports.
      */
     static std::vector<std::unique_ptr<Group> > ConstructLocalRealTCPMesh(
-        size_t num_hosts);
+        size_t num_hosts, size_t num_stripes = 1);
 
     //! Initializing constructor, used by tests for creating Groups.
-    Group(size_t my_rank, size_t group_size)
+    Group(size_t my_rank, size_t group_size, size_t num_stripes = 1)
         : net::Group(my_rank),
-          connections_(group_size) { }
+          num_stripes_(num_stripes),
+          connections_(group_size * num_stripes) {
+        assert(num_stripes_ >= 1);
+    }
 
     //! \}
 
@@ -84,8 +87,8 @@ public:
     //! \{
 
     //! Return Connection to client id.
-    Connection& tcp_connection(size_t id) {
-        if (id >= connections_.size())
+    Connection& tcp_connection(size_t id, size_t stripe = 0) {
+        if (id >= num_hosts())
             throw Exception("Group::Connection() requested "
                             "invalid client id " + std::to_string(id));
 
@@ -93,14 +96,26 @@ public:
             throw Exception("Group::Connection() requested "
                             "connection to self.");
 
+        if (stripe >= num_stripes_)
+            throw Exception("Group::Connection() requested "
+                            "invalid stripe " + std::to_string(stripe));
+
         // return Connection to client id.
-        return connections_[id];
+        return connections_[stripe * num_hosts() + id];
     }
 
     net::Connection& connection(size_t id) final {
         return tcp_connection(id);
     }
 
+    size_t num_stripes() const final {
+        return num_stripes_;
+    }
+
+    net::Connection& stripe_connection(size_t id, size_t stripe) final {
+        return tcp_connection(id, stripe);
+    }
+
     using Dispatcher = tcp::SelectDispatcher;
 
     std::unique_ptr<net::Dispatcher> ConstructDispatcher() const final;
@@ -116,26 +131,34 @@ public:
      * might be different from the inut connection.
      */
     Connection& AssignConnection(Connection& connection) {
-        if (connection.peer_id() >= connections_.size())
+        if (connection.peer_id() >= num_hosts())
             throw Exception("Group::GetClient() requested "
                             "invalid client id "
                             + std::to_string(connection.peer_id()));
 
-        connections_[connection.peer_id()] = std::move(connection);
+        if (connection.stripe_id() >= num_stripes_)
+            throw Exception("Group::GetClient() requested "
+                            "invalid stripe "
+                            + std::to_string(connection.stripe_id()));
+
+        size_t index =
+            connection.stripe_id() * num_hosts() + connection.peer_id();
 
-        return connections_[connection.peer_id()];
+        connections_[index] = std::move(connection);
+
+        return connections_[index];
     }
 
     //! Return number of connections in this group (= number computing hosts)
     size_t num_hosts() const final {
-        return connections_.size();
+        return connections_.size() / num_stripes_;
     }
 
     //! Closes all client connections
     void Close() {
         for (size_t i = 0; i != connections_.size(); ++i)
         {
-            if (i == my_rank_) continue;
+            if (i % num_hosts() == my_rank_) continue;
 
             if (connections_[i].IsValid())
                 connections_[i].Close();
@@ -152,7 +175,11 @@ public:
     //! \}
 
 private:
-    //! Connections to all other clients in the Group.
+    //! number of parallel connections to each peer
+    size_t num_stripes_;
+
+    //! Connections to all other clients in the Group, stored stripe-major:
+    //! connection to host id in stripe s is at [s * num_hosts() + id].
     std::vector<Connection> connections_;
 };
 
@@ -45,6 +45,7 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/prefix_sum.hpp>
 #include <thrill/api/print.hpp>
 #include <thrill/api/read_binary.hpp>
+#include <thrill/api/read_columnar.hpp>
 #include <thrill/api/read_lines.hpp>
 #include <thrill/api/rebalance.hpp>
 #include <thrill/api/reduce_by_key.hpp>
@@ -57,6 +58,7 @@ print "#include <$_>\n" foreach sort glob("thrill/api/"."*.hpp");
 #include <thrill/api/union.hpp>
 #include <thrill/api/window.hpp>
 #include <thrill/api/write_binary.hpp>
+#include <thrill/api/write_columnar.hpp>
 #include <thrill/api/write_lines.hpp>
 #include <thrill/api/write_lines_one.hpp>
 #include <thrill/api/zip.hpp>
@@ -15,8 +15,11 @@
 #include <thrill/vfs/bzip2_filter.hpp>
 #include <thrill/vfs/gzip_filter.hpp>
 #include <thrill/vfs/hdfs3_file.hpp>
+#include <thrill/vfs/lz4_filter.hpp>
 #include <thrill/vfs/s3_file.hpp>
 #include <thrill/vfs/sys_file.hpp>
+#include <thrill/vfs/xz_filter.hpp>
+#include <thrill/vfs/zstd_filter.hpp>
 
 #include <tlx/die.hpp>
 #include <tlx/string/ends_with.hpp>
@@ -24,6 +27,7 @@
 #include <tlx/string/starts_with.hpp>
 
 #include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -49,7 +53,8 @@ bool IsCompressed(const std::string& path) {
            tlx::ends_with(path, ".bz2") ||
            tlx::ends_with(path, ".xz") ||
            tlx::ends_with(path, ".lzo") ||
-           tlx::ends_with(path, ".lz4");
+           tlx::ends_with(path, ".lz4") ||
+           tlx::ends_with(path, ".zst");
 }
 
 bool IsRemoteUri(const std::string& path) {
@@ -57,6 +62,12 @@ bool IsRemoteUri(const std::string& path) {
            tlx::starts_with(path, "hdfs://");
 }
 
+bool IsDirectIO(const std::string& path) {
+    if (tlx::starts_with(path, "file://"))
+        return SysIsDirectIO(path.substr(7));
+    return !IsRemoteUri(path) && SysIsDirectIO(path);
+}
+
 std::ostream& operator << (std::ostream& os, const Type& t) {
     switch (t) {
     case Type::File:
@@ -175,9 +186,18 @@ FileList Glob(const std::string& glob, const GlobType& gtype) {
 
 /******************************************************************************/
 
+//! whether the local file at path is piped through an external (de)compressor
+//! by SysFile instead of a filter
+static bool IsPipedLocal(const std::string& path) {
+    if (tlx::starts_with(path, "file://"))
+        return SysPipeProgram(path.substr(7)) != nullptr;
+    return !IsRemoteUri(path) && SysPipeProgram(path) != nullptr;
+}
+
 ReadStream::~ReadStream() { }
 
-ReadStreamPtr OpenReadStream(
+//! open a stream without decompression filters
+static ReadStreamPtr OpenRawReadStream(
     const std::string& path, const common::Range& range) {
 
     ReadStreamPtr p;
@@ -193,8 +213,23 @@ ReadStreamPtr OpenReadStream(
     else {
         p = SysOpenReadStream(path, range);
     }
+    return p;
+}
+
+bool IsSplittableCompressed(const std::string& path) {
+    if (!tlx::ends_with(path, ".gz")) return false;
+    return GZipIsBlockCompressed(OpenRawReadStream(path, common::Range()));
+}
+
+ReadStreamPtr OpenReadStream(
+    const std::string& path, const common::Range& range) {
 
-    if (tlx::ends_with(path, ".gz")) {
+    ReadStreamPtr p = OpenRawReadStream(path, range);
+
+    if (IsPipedLocal(path)) {
+        // decompressed by an external program in SysOpenReadStream()
+    }
+    else if (tlx::ends_with(path, ".gz")) {
         p = MakeGZipReadFilter(p);
         die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
     }
@@ -202,10 +237,42 @@ ReadStreamPtr OpenReadStream(
         p = MakeBZip2ReadFilter(p);
         die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
     }
+    else if (tlx::ends_with(path, ".xz")) {
+        p = MakeXZReadFilter(p);
+        die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
+    }
+    else if (tlx::ends_with(path, ".lz4")) {
+        p = MakeLZ4ReadFilter(p);
+        die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
+    }
+    else if (tlx::ends_with(path, ".zst")) {
+        p = MakeZstdReadFilter(p);
+        die_unless(range.begin == 0 || "Cannot seek in compressed streams.");
+    }
+    else if (tlx::ends_with(path, ".lzo")) {
+        die(".lzo decompression is only supported for local files: " << path);
+    }
 
     return p;
 }
 
+MemberReadStreamPtr OpenMemberReadStream(
+    const std::string& path, uint64_t offset) {
+
+    die_unless(tlx::ends_with(path, ".gz"));
+
+    uint64_t member = offset;
+    if (offset != 0) {
+        member = GZipFindBlock(
+            OpenRawReadStream(path, common::Range(offset, 0)), offset);
+        if (member == std::numeric_limits<uint64_t>::max())
+            return MemberReadStreamPtr();
+    }
+
+    return MakeGZipMemberReadFilter(
+        OpenRawReadStream(path, common::Range(member, 0)), member);
+}
+
 WriteStream::~WriteStream() { }
 
 WriteStreamPtr OpenWriteStream(const std::string& path) {
@@ -224,12 +291,27 @@ WriteStreamPtr OpenWriteStream(const std::string& path) {
         p = SysOpenWriteStream(path);
     }
 
-    if (tlx::ends_with(path, ".gz")) {
+    if (IsPipedLocal(path)) {
+        // compressed by an external program in SysOpenWriteStream()
+    }
+    else if (tlx::ends_with(path, ".gz")) {
         p = MakeGZipWriteFilter(p);
     }
     else if (tlx::ends_with(path, ".bz2")) {
         p = MakeBZip2WriteFilter(p);
     }
+    else if (tlx::ends_with(path, ".xz")) {
+        p = MakeXZWriteFilter(p);
+    }
+    else if (tlx::ends_with(path, ".lz4")) {
+        p = MakeLZ4WriteFilter(p);
+    }
+    else if (tlx::ends_with(path, ".zst")) {
+        p = MakeZstdWriteFilter(p);
+    }
+    else if (tlx::ends_with(path, ".lzo")) {
+        die(".lzo compression is only supported for local files: " << path);
+    }
 
     return p;
 }
@@ -42,12 +42,22 @@ std::string FillFilePattern(const std::string& pathbase,
                             size_t worker, size_t file_part);
 
 //! Returns true, if file at filepath is compressed (e.g, ends with
-//! '.{gz,bz2,xz,lzo}')
+//! '.{gz,bz2,xz,lzo,lz4,zst}')
 bool IsCompressed(const std::string& path);
 
+//! Returns true, if the compressed file at path consists of independently
+//! decompressible members which can be located from any byte offset, such that
+//! the file can be split among workers. Currently these are block compressed
+//! gzip files (BGZF) as written by bgzip. Reads the header of the file.
+bool IsSplittableCompressed(const std::string& path);
+
 //! Returns true, if file at filepath is a remote uri like s3:// or hdfs://
 bool IsRemoteUri(const std::string& path);
 
+//! Returns true, if the local file at path is read and written with direct I/O
+//! bypassing the page cache, see THRILL_DIRECT_IO.
+bool IsDirectIO(const std::string& path);
+
 //! VFS object type
 enum class Type { File, Directory };
 
@@ -142,8 +152,21 @@ public:
     virtual void close() = 0;
 };
 
+/*!
+ * Reader object for splittable compressed files, which decompresses the file
+ * member-wise and never returns data of two members in one read() call.
+ */
+class MemberReadStream : public virtual ReadStream
+{
+public:
+    //! byte offset in the compressed file of the member from which the last
+    //! read() returned data.
+    virtual uint64_t member_offset() const = 0;
+};
+
 using ReadStreamPtr = tlx::CountingPtr<ReadStream>;
 using WriteStreamPtr = tlx::CountingPtr<WriteStream>;
+using MemberReadStreamPtr = tlx::CountingPtr<MemberReadStream>;
 
 /******************************************************************************/
 
@@ -161,6 +184,15 @@ using WriteStreamPtr = tlx::CountingPtr<WriteStream>;
 ReadStreamPtr OpenReadStream(
     const std::string& path, const common::Range& range = common::Range());
 
+/*!
+ * Construct a member-wise decompressing reader for the splittable compressed
+ * file at path, which starts at the first member beginning at or after the
+ * byte offset in the compressed file. Returns an empty pointer if no member
+ * starts at or after offset.
+ */
+MemberReadStreamPtr OpenMemberReadStream(
+    const std::string& path, uint64_t offset);
+
 WriteStreamPtr OpenWriteStream(const std::string& path);
 
 /******************************************************************************/
@@ -16,11 +16,104 @@
 #include <zlib.h>
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <vector>
 
 namespace thrill {
 namespace vfs {
 
+/******************************************************************************/
+// BGZF member headers
+
+//! size of a BGZF member header up to and including the BSIZE field
+static constexpr size_t bgzf_header_size = 18;
+
+//! maximum size of a BGZF member
+static constexpr size_t bgzf_max_block_size = 65536;
+
+//! maximum number of uncompressed bytes in a BGZF member, such that
+//! incompressible data still fits into bgzf_max_block_size.
+static constexpr size_t bgzf_max_data_size = 65280;
+
+//! Check for a BGZF member header at p and return the member's size, or zero.
+static size_t BGZFBlockSize(const unsigned char* p) {
+    // gzip magic, deflate, FEXTRA flag, XLEN = 6, subfield 'BC' of length 2
+    if (p[0] != 0x1F || p[1] != 0x8B || p[2] != 8 || (p[3] & 4) == 0 ||
+        p[10] != 6 || p[11] != 0 || p[12] != 'B' || p[13] != 'C' ||
+        p[14] != 2 || p[15] != 0)
+        return 0;
+    // BSIZE = member size - 1
+    return (static_cast<size_t>(p[16]) | (static_cast<size_t>(p[17]) << 8)) + 1;
+}
+
+bool GZipIsBlockCompressed(const ReadStreamPtr& stream) {
+    unsigned char header[bgzf_header_size];
+    size_t pos = 0;
+    while (pos < bgzf_header_size) {
+        ssize_t rb = stream->read(header + pos, bgzf_header_size - pos);
+        if (rb <= 0) break;
+        pos += rb;
+    }
+    stream->close();
+    return pos == bgzf_header_size && BGZFBlockSize(header) != 0;
+}
+
+uint64_t GZipFindBlock(const ReadStreamPtr& stream, uint64_t offset) {
+    static constexpr size_t read_size = 256 * 1024;
+
+    std::vector<unsigned char> buffer;
+    size_t pos = 0;
+    bool eof = false;
+
+    while (true) {
+        // keep enough data to verify the member following a candidate
+        while (!eof && buffer.size() <
+               pos + bgzf_max_block_size + bgzf_header_size) {
+            size_t old_size = buffer.size();
+            buffer.resize(old_size + read_size);
+            ssize_t rb = stream->read(buffer.data() + old_size, read_size);
+            buffer.resize(old_size + std::max<ssize_t>(rb, 0));
+            eof = (rb <= 0);
+        }
+
+        if (pos + bgzf_header_size > buffer.size()) break;
+
+        // jump to next gzip magic byte
+        const unsigned char* p = static_cast<const unsigned char*>(
+            std::memchr(buffer.data() + pos, 0x1F,
+                        buffer.size() - bgzf_header_size + 1 - pos));
+        if (!p) {
+            pos = buffer.size() - bgzf_header_size + 1;
+        }
+        else {
+            pos = p - buffer.data();
+            size_t size = BGZFBlockSize(p);
+            if (size != 0) {
+                size_t next = pos + size;
+                if ((next + bgzf_header_size <= buffer.size() &&
+                     BGZFBlockSize(buffer.data() + next) != 0) ||
+                    (eof && next == buffer.size())) {
+                    stream->close();
+                    return offset + pos;
+                }
+            }
+            ++pos;
+        }
+
+        // discard scanned data
+        if (pos >= read_size) {
+            buffer.erase(buffer.begin(), buffer.begin() + pos);
+            offset += pos;
+            pos = 0;
+        }
+    }
+
+    stream->close();
+    return std::numeric_limits<uint64_t>::max();
+}
+
 #if THRILL_HAVE_ZLIB
 
 /******************************************************************************/
@@ -259,6 +352,229 @@ ReadStreamPtr MakeGZipReadFilter(const ReadStreamPtr& stream) {
     return tlx::make_counting<GZipReadFilter>(stream);
 }
 
+/******************************************************************************/
+// GZipMemberReadFilter - member-wise gzip decompressor
+
+class GZipMemberReadFilter final : public virtual MemberReadStream
+{
+    static constexpr bool debug = false;
+
+public:
+    GZipMemberReadFilter(const ReadStreamPtr& input, uint64_t offset)
+        : input_(input), buffer_offset_(offset), member_offset_(offset) {
+        memset(&z_stream_, 0, sizeof(z_stream_));
+
+        /* windowBits = 15 (largest allocation) + 16 (gzip header) */
+        int err = inflateInit2(&z_stream_, 15 + 16);
+        die_unequal(err, Z_OK);
+
+        // input buffer
+        buffer_.resize(2 * 1024 * 1024);
+        z_stream_.next_in = buffer_.data();
+        z_stream_.avail_in = 0;
+
+        initialized_ = true;
+    }
+
+    ~GZipMemberReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        z_stream_.next_out = reinterpret_cast<Bytef*>(data);
+        z_stream_.avail_out = size;
+
+        while (true)
+        {
+            if (member_end_) {
+                // start next member, only after returning the previous one's
+                // data, such that member_offset_ matches the data.
+                inflateReset(&z_stream_);
+                member_end_ = false;
+                member_offset_ =
+                    buffer_offset_ + (z_stream_.next_in - buffer_.data());
+                LOG << "GZipMemberReadFilter: member at " << member_offset_;
+            }
+
+            if (z_stream_.avail_in == 0) {
+                // input buffer empty, so read from input_
+                buffer_offset_ += z_stream_.next_in - buffer_.data();
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                z_stream_.next_in = buffer_.data();
+                z_stream_.avail_in = rb > 0 ? rb : 0;
+
+                if (z_stream_.avail_in == 0)
+                    return size - z_stream_.avail_out;
+            }
+
+            int err = inflate(&z_stream_, Z_SYNC_FLUSH);
+
+            if (err == Z_STREAM_END) {
+                member_end_ = true;
+                if (z_stream_.avail_out != size)
+                    return size - z_stream_.avail_out;
+            }
+            else if (err == Z_BUF_ERROR && z_stream_.avail_in == 0) {
+                // member continues in the next input buffer
+            }
+            else if (err != Z_OK) {
+                die("GZipMemberReadFilter: " << Z_ERROR_to_string(err) <<
+                    " while inflating");
+            }
+
+            if (z_stream_.avail_out == 0)
+                return size;
+        }
+    }
+
+    uint64_t member_offset() const final { return member_offset_; }
+
+    void close() final {
+        if (!initialized_) return;
+
+        inflateEnd(&z_stream_);
+        input_->close();
+
+        initialized_ = false;
+    }
+
+private:
+    //! if z_stream_ is initialized
+    bool initialized_;
+
+    //! zlib context
+    z_stream z_stream_;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<Bytef> buffer_;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+
+    //! file offset of buffer_[0]
+    uint64_t buffer_offset_;
+
+    //! file offset of the current member
+    uint64_t member_offset_;
+
+    //! whether the current member was fully decompressed
+    bool member_end_ = false;
+};
+
+MemberReadStreamPtr MakeGZipMemberReadFilter(
+    const ReadStreamPtr& stream, uint64_t offset) {
+    die_unless(stream);
+    return tlx::make_counting<GZipMemberReadFilter>(stream, offset);
+}
+
+/******************************************************************************/
+// GZipBlockWriteFilter - block compressing gzip writer (BGZF)
+
+class GZipBlockWriteFilter final : public virtual WriteStream
+{
+public:
+    explicit GZipBlockWriteFilter(const WriteStreamPtr& output)
+        : output_(output) {
+        memset(&z_stream_, 0, sizeof(z_stream_));
+
+        // windowBits = 15 (largest allocation) + 16 (gzip header)
+        int err = deflateInit2(&z_stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               15 + 16, /* memLevel */ 8, Z_DEFAULT_STRATEGY);
+        die_unequal(err, Z_OK);
+
+        block_.reserve(bgzf_max_data_size);
+        buffer_.resize(bgzf_max_block_size);
+
+        initialized_ = true;
+    }
+
+    ~GZipBlockWriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        const Bytef* cdata = reinterpret_cast<const Bytef*>(data);
+        size_t remain = size;
+
+        while (remain != 0) {
+            size_t n = std::min(remain, bgzf_max_data_size - block_.size());
+            block_.insert(block_.end(), cdata, cdata + n);
+            cdata += n, remain -= n;
+
+            if (block_.size() == bgzf_max_data_size)
+                WriteBlock();
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        if (!block_.empty())
+            WriteBlock();
+        // empty member as end-of-file marker
+        WriteBlock();
+
+        output_->close();
+
+        deflateEnd(&z_stream_);
+        initialized_ = false;
+    }
+
+private:
+    //! if z_stream_ is initialized
+    bool initialized_;
+
+    //! zlib context
+    z_stream z_stream_;
+
+    //! uncompressed data of the current member
+    std::vector<Bytef> block_;
+
+    //! compressed member
+    std::vector<Bytef> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    //! compress block_ into one member and write it to the output
+    void WriteBlock() {
+        int err = deflateReset(&z_stream_);
+        die_unequal(err, Z_OK);
+
+        // 'BC' extra subfield, the member size is filled in afterwards
+        Bytef extra[6] = { 'B', 'C', 2, 0, 0, 0 };
+        gz_header header;
+        memset(&header, 0, sizeof(header));
+        header.extra = extra;
+        header.extra_len = sizeof(extra);
+        header.os = 255;
+        err = deflateSetHeader(&z_stream_, &header);
+        die_unequal(err, Z_OK);
+
+        z_stream_.next_in = block_.data();
+        z_stream_.avail_in = block_.size();
+        z_stream_.next_out = buffer_.data();
+        z_stream_.avail_out = buffer_.size();
+
+        err = deflate(&z_stream_, Z_FINISH);
+        die_unequal(err, Z_STREAM_END);
+
+        size_t size = buffer_.size() - z_stream_.avail_out;
+        buffer_[16] = static_cast<Bytef>((size - 1) & 0xFF);
+        buffer_[17] = static_cast<Bytef>((size - 1) >> 8);
+
+        output_->write(buffer_.data(), size);
+        block_.clear();
+    }
+};
+
+WriteStreamPtr MakeGZipBlockWriteFilter(const WriteStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<GZipBlockWriteFilter>(stream);
+}
+
 /******************************************************************************/
 
 #else   // !THRILL_HAVE_ZLIB
@@ -273,6 +589,16 @@ ReadStreamPtr MakeGZipReadFilter(const ReadStreamPtr&) {
         "because Thrill was built without zlib.");
 }
 
+MemberReadStreamPtr MakeGZipMemberReadFilter(const ReadStreamPtr&, uint64_t) {
+    die(".gz decompression is not available, "
+        "because Thrill was built without zlib.");
+}
+
+WriteStreamPtr MakeGZipBlockWriteFilter(const WriteStreamPtr&) {
+    die(".gz compression is not available, "
+        "because Thrill was built without zlib.");
+}
+
 #endif
 
 } // namespace vfs
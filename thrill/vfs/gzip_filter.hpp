@@ -23,6 +23,30 @@ ReadStreamPtr MakeGZipReadFilter(const ReadStreamPtr& stream);
 
 WriteStreamPtr MakeGZipWriteFilter(const WriteStreamPtr& stream);
 
+/******************************************************************************/
+// Block compressed gzip (BGZF): a sequence of gzip members of at most 64 KiB,
+// each carrying its compressed size in a 'BC' extra field. Any gzip reader can
+// decompress it, but it can also be split at member boundaries.
+
+//! Check whether the stream begins with a BGZF member header. Consumes bytes.
+bool GZipIsBlockCompressed(const ReadStreamPtr& stream);
+
+/*!
+ * Scan stream, which starts at byte offset of the file, for the first BGZF
+ * member header whose size field points to another member header or to the
+ * end of the file. Returns the member's byte offset in the file, or
+ * std::numeric_limits<uint64_t>::max() if no member follows.
+ */
+uint64_t GZipFindBlock(const ReadStreamPtr& stream, uint64_t offset);
+
+//! Member-wise gzip decompressor of a stream which starts with a member at
+//! byte offset of the file.
+MemberReadStreamPtr MakeGZipMemberReadFilter(
+    const ReadStreamPtr& stream, uint64_t offset);
+
+//! Block compressing gzip writer, which outputs BGZF files.
+WriteStreamPtr MakeGZipBlockWriteFilter(const WriteStreamPtr& stream);
+
 } // namespace vfs
 } // namespace thrill
 
@@ -0,0 +1,226 @@
+/*******************************************************************************
+ * thrill/vfs/lz4_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/lz4_filter.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if THRILL_HAVE_LZ4
+
+/******************************************************************************/
+// LZ4WriteFilter - on-the-fly lz4 frame compressor
+
+class LZ4WriteFilter final : public virtual WriteStream
+{
+public:
+    explicit LZ4WriteFilter(const WriteStreamPtr& output)
+        : output_(output) {
+        memset(&prefs_, 0, sizeof(prefs_));
+        prefs_.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+        size_t err = LZ4F_createCompressionContext(&ctx_, LZ4F_VERSION);
+        die_unless(!LZ4F_isError(err));
+
+        // output buffer, large enough for the compressed input_chunk_size
+        buffer_.resize(LZ4F_compressBound(input_chunk_size, &prefs_));
+
+        size_t size = LZ4F_compressBegin(
+            ctx_, buffer_.data(), buffer_.size(), &prefs_);
+        CheckError(size);
+        output_->write(buffer_.data(), size);
+
+        initialized_ = true;
+    }
+
+    ~LZ4WriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        const char* cdata = reinterpret_cast<const char*>(data);
+        size_t remain = size;
+
+        while (remain != 0) {
+            size_t n = std::min(remain, input_chunk_size);
+            size_t written_size = LZ4F_compressUpdate(
+                ctx_, buffer_.data(), buffer_.size(), cdata, n, nullptr);
+            CheckError(written_size);
+
+            if (written_size != 0)
+                output_->write(buffer_.data(), written_size);
+
+            cdata += n, remain -= n;
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        size_t written_size = LZ4F_compressEnd(
+            ctx_, buffer_.data(), buffer_.size(), nullptr);
+        CheckError(written_size);
+        output_->write(buffer_.data(), written_size);
+
+        output_->close();
+
+        LZ4F_freeCompressionContext(ctx_);
+        initialized_ = false;
+    }
+
+private:
+    //! maximum input passed to LZ4F_compressUpdate() at once
+    static constexpr size_t input_chunk_size = 1024 * 1024;
+
+    //! if ctx_ is initialized
+    bool initialized_ = false;
+
+    //! lz4 frame context
+    LZ4F_compressionContext_t ctx_;
+
+    //! frame preferences
+    LZ4F_preferences_t prefs_;
+
+    //! compression buffer, flushed to output after each chunk
+    std::vector<char> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    static void CheckError(size_t code) {
+        if (LZ4F_isError(code))
+            die("LZ4WriteFilter: " << LZ4F_getErrorName(code));
+    }
+};
+
+constexpr size_t LZ4WriteFilter::input_chunk_size;
+
+WriteStreamPtr MakeLZ4WriteFilter(const WriteStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<LZ4WriteFilter>(stream);
+}
+
+/******************************************************************************/
+// LZ4ReadFilter - on-the-fly lz4 frame decompressor
+
+class LZ4ReadFilter final : public virtual ReadStream
+{
+public:
+    explicit LZ4ReadFilter(const ReadStreamPtr& input)
+        : input_(input) {
+        size_t err = LZ4F_createDecompressionContext(&ctx_, LZ4F_VERSION);
+        die_unless(!LZ4F_isError(err));
+
+        // input buffer
+        buffer_.resize(2 * 1024 * 1024);
+
+        initialized_ = true;
+    }
+
+    ~LZ4ReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        char* out = reinterpret_cast<char*>(data);
+        size_t out_pos = 0;
+
+        while (out_pos < size)
+        {
+            if (in_pos_ == in_size_ && !input_eof_) {
+                // input buffer empty, so read from input_
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                in_pos_ = 0;
+                in_size_ = rb > 0 ? rb : 0;
+                input_eof_ = (in_size_ == 0);
+            }
+
+            // the context may hold decompressed data even without input
+            size_t dst_size = size - out_pos;
+            size_t src_size = in_size_ - in_pos_;
+            size_t hint = LZ4F_decompress(
+                ctx_, out + out_pos, &dst_size,
+                buffer_.data() + in_pos_, &src_size, nullptr);
+            if (LZ4F_isError(hint))
+                die("LZ4ReadFilter: " << LZ4F_getErrorName(hint));
+
+            in_pos_ += src_size;
+            out_pos += dst_size;
+
+            if (input_eof_ && dst_size == 0) break;
+        }
+
+        return out_pos;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        LZ4F_freeDecompressionContext(ctx_);
+        input_->close();
+
+        initialized_ = false;
+    }
+
+private:
+    //! if ctx_ is initialized
+    bool initialized_ = false;
+
+    //! lz4 frame context
+    LZ4F_decompressionContext_t ctx_;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<char> buffer_;
+
+    //! [in_pos_, in_size_) is the unconsumed input in buffer_
+    size_t in_pos_ = 0, in_size_ = 0;
+
+    //! whether input_ returned EOF
+    bool input_eof_ = false;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+};
+
+ReadStreamPtr MakeLZ4ReadFilter(const ReadStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<LZ4ReadFilter>(stream);
+}
+
+/******************************************************************************/
+
+#else   // !THRILL_HAVE_LZ4
+
+WriteStreamPtr MakeLZ4WriteFilter(const WriteStreamPtr&) {
+    die(".lz4 compression is not available, "
+        "because Thrill was built without lz4.");
+}
+
+ReadStreamPtr MakeLZ4ReadFilter(const ReadStreamPtr&) {
+    die(".lz4 decompression is not available, "
+        "because Thrill was built without lz4.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
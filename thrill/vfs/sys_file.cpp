@@ -15,10 +15,14 @@
 #include <thrill/common/porting.hpp>
 #include <thrill/common/string.hpp>
 #include <thrill/common/system_exception.hpp>
+#include <thrill/mem/aligned_allocator.hpp>
 #include <thrill/vfs/simple_glob.hpp>
 
 #include <tlx/die.hpp>
 #include <tlx/string/ends_with.hpp>
+#include <tlx/string/split.hpp>
+#include <tlx/string/starts_with.hpp>
+#include <tlx/unused.hpp>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -44,7 +48,14 @@
 #endif
 
 #include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace thrill {
@@ -320,6 +331,371 @@ void SysFile::close() {
 
 /******************************************************************************/
 
+const char * SysPipeProgram(const std::string& path) {
+    // .gz, .bz2, and .zst files are always handled by the filters in file_io,
+    // .xz and .lz4 files only if the library was available.
+    if (tlx::ends_with(path, ".lzo"))
+        return "lzop";
+#if !THRILL_HAVE_LZMA
+    if (tlx::ends_with(path, ".xz"))
+        return "xz";
+#endif
+#if !THRILL_HAVE_LZ4
+    if (tlx::ends_with(path, ".lz4"))
+        return "lz4";
+#endif
+    return nullptr;
+}
+
+bool SysIsDirectIO(const std::string& path) {
+#if defined(O_DIRECT)
+    const char* env = getenv("THRILL_DIRECT_IO");
+    if (env == nullptr || *env == 0 || strcmp(env, "0") == 0)
+        return false;
+    if (strcmp(env, "1") == 0)
+        return true;
+
+    // list of path prefixes
+    for (const std::string& prefix : tlx::split(':', env)) {
+        if (!prefix.empty() && tlx::starts_with(path, prefix))
+            return true;
+    }
+#else
+    tlx::unused(path);
+#endif
+    return false;
+}
+
+#if defined(O_DIRECT)
+
+/*!
+ * Represents a POSIX system file opened with O_DIRECT, which bypasses the page
+ * cache. Data is transferred in large aligned buffers, one of which is read or
+ * written asynchronously by the stream's I/O thread while the other is drained
+ * or filled.
+ */
+class SysDirectFile final : public virtual ReadStream, public virtual WriteStream
+{
+    static constexpr bool debug = false;
+
+public:
+    //! alignment of buffers, offsets, and sizes required by O_DIRECT
+    static constexpr size_t alignment = THRILL_DEFAULT_ALIGN;
+
+    //! size of each of the two buffers
+    static constexpr size_t buffer_size = 4 * 1024 * 1024;
+
+    //! constructor for an fd opened with O_DIRECT, reading from or writing to
+    //! offset in the file.
+    SysDirectFile(int fd, uint64_t offset, bool write)
+        : fd_(fd), write_(write),
+          buffer_ { alloc_.allocate(buffer_size), alloc_.allocate(buffer_size) } {
+        if (write_) {
+            offset_ = offset;
+            die_unless(offset_ % alignment == 0);
+        }
+        else {
+            // reads must start at an aligned offset, skip the bytes before
+            offset_ = offset - offset % alignment;
+            skip_ = offset % alignment;
+        }
+        thread_ = std::thread([this]() { Worker(); });
+        if (!write_) StartRead();
+    }
+
+    //! non-copyable: delete copy-constructor
+    SysDirectFile(const SysDirectFile&) = delete;
+    //! non-copyable: delete assignment operator
+    SysDirectFile& operator = (const SysDirectFile&) = delete;
+
+    ~SysDirectFile() {
+        close();
+        alloc_.deallocate(buffer_[0], buffer_size);
+        alloc_.deallocate(buffer_[1], buffer_size);
+    }
+
+    //! write into the current buffer, which is written asynchronously if full.
+    ssize_t write(const void* data, size_t count) final {
+        assert(fd_ >= 0 && write_);
+        const uint8_t* cdata = static_cast<const uint8_t*>(data);
+        size_t remain = count;
+        while (remain != 0) {
+            size_t n = std::min(remain, buffer_size - size_);
+            std::copy(cdata, cdata + n, buffer_[0] + size_);
+            size_ += n, cdata += n, remain -= n;
+
+            if (size_ == buffer_size) {
+                WaitWrite();
+                std::swap(buffer_[0], buffer_[1]);
+                StartWrite(buffer_[1], offset_);
+                offset_ += buffer_size;
+                size_ = 0;
+            }
+        }
+        return count;
+    }
+
+    //! read from the current buffer, and switch to the asynchronously read
+    //! buffer if it is empty.
+    ssize_t read(void* data, size_t count) final {
+        assert(fd_ >= 0 && !write_);
+        while (pos_ == size_) {
+            // a failed read is reported again instead of the end of file
+            if (error_ != 0) {
+                errno = error_;
+                return -1;
+            }
+
+            // reached end of file
+            if (!pending_) return 0;
+
+            ssize_t rb = WaitTransfer();
+            if (rb < 0) {
+                errno = error_ = static_cast<int>(-rb);
+                return -1;
+            }
+
+            std::swap(buffer_[0], buffer_[1]);
+            size_ = rb;
+            pos_ = std::min(skip_, size_);
+            skip_ = 0;
+
+            // a short read means the end of the file was reached
+            if (size_ == buffer_size) StartRead();
+        }
+
+        size_t n = std::min(count, size_ - pos_);
+        std::copy(buffer_[0] + pos_, buffer_[0] + pos_ + n,
+                  static_cast<uint8_t*>(data));
+        pos_ += n;
+        return n;
+    }
+
+    //! finish transfers and close the file descriptor
+    void close() final;
+
+private:
+    //! file descriptor
+    int fd_ = -1;
+
+    //! whether the file is written or read
+    bool write_;
+
+    //! allocator of the buffers, which are aligned like ByteBlocks
+    mem::AlignedAllocator<uint8_t> alloc_;
+
+    //! current buffer and the buffer being transferred asynchronously
+    uint8_t* buffer_[2];
+
+    //! file offset of the next asynchronous transfer
+    uint64_t offset_ = 0;
+
+    //! bytes to skip at the beginning of the first buffer read
+    size_t skip_ = 0;
+
+    //! filled bytes in the current buffer, and read position in it
+    size_t size_ = 0, pos_ = 0;
+
+    //! whether an asynchronous transfer was started and not yet waited for
+    bool pending_ = false;
+
+    //! I/O thread performing the asynchronous transfers
+    std::thread thread_;
+
+    //! mutex protecting the request to the I/O thread
+    std::mutex mutex_;
+
+    //! condition variable signaling new requests and finished transfers
+    std::condition_variable cv_;
+
+    //! whether the I/O thread has a transfer to perform, or should terminate
+    bool requested_ = false, terminate_ = false;
+
+    //! buffer and file offset of the requested transfer
+    uint8_t* request_data_ = nullptr;
+    uint64_t request_offset_ = 0;
+
+    //! result of the last transfer: its size or -errno
+    ssize_t result_ = 0;
+
+    //! errno of a failed asynchronous read, 0 if none failed
+    int error_ = 0;
+
+    //! read or write size bytes at offset, returns the transferred size, which
+    //! is less than size only at the end of the file, or -errno.
+    static ssize_t Transfer(int fd, uint8_t* data, size_t size,
+                            uint64_t offset, bool write) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t r = write
+                        ? ::pwrite(fd, data + done, size - done, offset + done)
+                        : ::pread(fd, data + done, size - done, offset + done);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                return -errno;
+            }
+            done += r;
+            // only the end of the file is unaligned
+            if (r == 0 || done % alignment != 0) break;
+        }
+        return done;
+    }
+
+    //! loop of the I/O thread: perform requested transfers until terminated
+    void Worker() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return requested_ || terminate_; });
+            if (!requested_) return;
+            lock.unlock();
+            ssize_t r = Transfer(fd_, request_data_, buffer_size,
+                                 request_offset_, write_);
+            lock.lock();
+            result_ = r;
+            requested_ = false;
+            cv_.notify_all();
+        }
+    }
+
+    //! hand a transfer of a full buffer to the I/O thread
+    void StartTransfer(uint8_t* data, uint64_t offset) {
+        assert(!pending_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        request_data_ = data;
+        request_offset_ = offset;
+        requested_ = true;
+        pending_ = true;
+        cv_.notify_all();
+    }
+
+    //! wait for the started transfer, returns its size or -errno
+    ssize_t WaitTransfer() {
+        assert(pending_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !requested_; });
+        pending_ = false;
+        return result_;
+    }
+
+    //! terminate and join the I/O thread
+    void StopThread() {
+        if (!thread_.joinable()) return;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            terminate_ = true;
+            cv_.notify_all();
+        }
+        thread_.join();
+    }
+
+    void StartRead() {
+        StartTransfer(buffer_[1], offset_);
+        offset_ += buffer_size;
+    }
+
+    void StartWrite(uint8_t* data, uint64_t offset) {
+        StartTransfer(data, offset);
+    }
+
+    //! wait for the asynchronous write, if any
+    void WaitWrite() {
+        if (!pending_) return;
+        ssize_t wb = WaitTransfer();
+        if (wb < 0) {
+            throw common::ErrnoException(
+                      "SysDirectFile: write failed", static_cast<int>(-wb));
+        }
+        // O_DIRECT writes are short only if the disk is full
+        if (wb != static_cast<ssize_t>(buffer_size)) {
+            throw common::ErrnoException(
+                      "SysDirectFile: short write", ENOSPC);
+        }
+    }
+};
+
+void SysDirectFile::close() {
+    if (fd_ < 0) return;
+
+    sLOG << "SysDirectFile::close(): fd" << fd_;
+
+    try {
+        if (write_) {
+            WaitWrite();
+
+            // write the unaligned tail through the page cache
+            int flags = fcntl(fd_, F_GETFL);
+            if (size_ != 0 && fcntl(fd_, F_SETFL, flags & ~O_DIRECT) != 0) {
+                throw common::ErrnoException(
+                          "SysDirectFile: cannot clear O_DIRECT", errno);
+            }
+            ssize_t wb = Transfer(
+                fd_, buffer_[0], size_, offset_, /* write */ true);
+            if (wb < 0) {
+                throw common::ErrnoException(
+                          "SysDirectFile: write failed", static_cast<int>(-wb));
+            }
+            // cut off any previous contents of the file
+            if (::ftruncate(fd_, static_cast<off_t>(offset_ + size_)) != 0) {
+                throw common::ErrnoException(
+                          "SysDirectFile: ftruncate failed", errno);
+            }
+        }
+        else if (pending_) {
+            WaitTransfer();
+        }
+    }
+    catch (...) {
+        // release the file descriptor also if the transfers failed
+        StopThread();
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+
+    StopThread();
+
+    if (::close(fd_) != 0)
+    {
+        LOG1 << "SysDirectFile::close()"
+             << " fd=" << fd_
+             << " errno=" << errno
+             << " error=" << strerror(errno);
+    }
+    fd_ = -1;
+}
+
+//! set O_DIRECT on fd, returns false if the file system does not support it.
+static bool SysSetDirect(int fd, const std::string& path) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0 && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0)
+        return true;
+    LOG1 << "SysFile: O_DIRECT is not supported for " << path
+         << ", using the page cache: " << strerror(errno);
+    return false;
+}
+
+#endif  // defined(O_DIRECT)
+
+bool SysIsDirectStream(const ReadStreamPtr& stream) {
+#if defined(O_DIRECT)
+    return dynamic_cast<SysDirectFile*>(stream.get()) != nullptr;
+#else
+    tlx::unused(stream);
+    return false;
+#endif
+}
+
+bool SysIsDirectStream(const WriteStreamPtr& stream) {
+#if defined(O_DIRECT)
+    return dynamic_cast<SysDirectFile*>(stream.get()) != nullptr;
+#else
+    tlx::unused(stream);
+    return false;
+#endif
+}
+
+/******************************************************************************/
+
 ReadStreamPtr SysOpenReadStream(
     const std::string& path, const common::Range& range) {
 
@@ -334,23 +710,21 @@ ReadStreamPtr SysOpenReadStream(
 
     // then figure out whether we need to pipe it through a decompressor.
 
-    const char* decompressor;
+    const char* decompressor = SysPipeProgram(path);
 
-    if (tlx::ends_with(path, ".xz")) {
-        decompressor = "xz";
-    }
-    else if (tlx::ends_with(path, ".lzo")) {
-        decompressor = "lzop";
-    }
-    else if (tlx::ends_with(path, ".lz4")) {
-        decompressor = "lz4";
-    }
-    else {
+    if (!decompressor) {
         // not a compressed file
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForRead(): filefd" << fd;
 
+#if defined(O_DIRECT)
+        if (SysIsDirectIO(path) && SysSetDirect(fd, path)) {
+            return tlx::make_counting<SysDirectFile>(
+                fd, range.begin, /* write */ false);
+        }
+#endif
+
         if (range.begin) {
             //! POSIX lseek function from current position.
             ::lseek(fd, range.begin, SEEK_CUR);
@@ -424,23 +798,21 @@ WriteStreamPtr SysOpenWriteStream(const std::string& path) {
 
     // then figure out whether we need to pipe it through a compressor.
 
-    const char* compressor;
+    const char* compressor = SysPipeProgram(path);
 
-    if (tlx::ends_with(path, ".xz")) {
-        compressor = "xz";
-    }
-    else if (tlx::ends_with(path, ".lzo")) {
-        compressor = "lzop";
-    }
-    else if (tlx::ends_with(path, ".lz4")) {
-        compressor = "lz4";
-    }
-    else {
+    if (!compressor) {
         // not a compressed file
         common::PortSetCloseOnExec(fd);
 
         sLOG << "SysFile::OpenForWrite(): filefd" << fd;
 
+#if defined(O_DIRECT)
+        if (SysIsDirectIO(path) && SysSetDirect(fd, path)) {
+            return tlx::make_counting<SysDirectFile>(
+                fd, /* offset */ 0, /* write */ true);
+        }
+#endif
+
         return tlx::make_counting<SysFile>(fd);
     }
 
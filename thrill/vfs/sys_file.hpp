@@ -26,6 +26,15 @@ namespace vfs {
 void SysGlob(const std::string& path, const GlobType& gtype,
              FileList& filelist);
 
+/*!
+ * Returns the external program which SysOpenReadStream() and
+ * SysOpenWriteStream() pipe the file at path through, or nullptr if the file is
+ * read or written directly. These are the compression formats for which
+ * file_io has no filter: .lzo, and .xz or .lz4 if Thrill was built without
+ * liblzma or lz4.
+ */
+const char * SysPipeProgram(const std::string& path);
+
 /*!
  * Open file for reading and return file descriptor. Handles compressed files by
  * calling a decompressor in a pipe, like "cat $f | gzip -dc |" in bash.
@@ -47,6 +56,19 @@ ReadStreamPtr SysOpenReadStream(
  */
 WriteStreamPtr SysOpenWriteStream(const std::string& path);
 
+//! Returns true if the local file at path is read and written with O_DIRECT,
+//! bypassing the page cache, as selected by the environment variable
+//! THRILL_DIRECT_IO: "1" for all files, or a ':' separated list of path
+//! prefixes.
+bool SysIsDirectIO(const std::string& path);
+
+//! Returns true if the stream transfers data with O_DIRECT, false if it falls
+//! back to the page cache because the file system does not support O_DIRECT.
+bool SysIsDirectStream(const ReadStreamPtr& stream);
+
+//! Returns true if the stream writes with O_DIRECT, see above.
+bool SysIsDirectStream(const WriteStreamPtr& stream);
+
 } // namespace vfs
 } // namespace thrill
 
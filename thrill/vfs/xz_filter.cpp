@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * thrill/vfs/xz_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/xz_filter.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include <cstdint>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if THRILL_HAVE_LZMA
+
+/******************************************************************************/
+
+static const char * LZMA_RET_to_string(lzma_ret ret) {
+    switch (ret)
+    {
+    case LZMA_OK:
+        return "LZMA_OK";
+    case LZMA_STREAM_END:
+        return "LZMA_STREAM_END";
+    case LZMA_MEM_ERROR:
+        return "LZMA_MEM_ERROR";
+    case LZMA_MEMLIMIT_ERROR:
+        return "LZMA_MEMLIMIT_ERROR";
+    case LZMA_FORMAT_ERROR:
+        return "LZMA_FORMAT_ERROR";
+    case LZMA_OPTIONS_ERROR:
+        return "LZMA_OPTIONS_ERROR";
+    case LZMA_DATA_ERROR:
+        return "LZMA_DATA_ERROR";
+    case LZMA_BUF_ERROR:
+        return "LZMA_BUF_ERROR";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/******************************************************************************/
+// XZWriteFilter - on-the-fly xz compressor
+
+class XZWriteFilter final : public virtual WriteStream
+{
+public:
+    explicit XZWriteFilter(const WriteStreamPtr& output)
+        : output_(output) {
+        lzma_ret ret = lzma_easy_encoder(
+            &stream_, /* preset */ 6, LZMA_CHECK_CRC64);
+        die_unequal(ret, LZMA_OK);
+
+        // output buffer
+        buffer_.resize(2 * 1024 * 1024);
+        stream_.next_out = buffer_.data();
+        stream_.avail_out = buffer_.size();
+
+        initialized_ = true;
+    }
+
+    ~XZWriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        stream_.next_in = reinterpret_cast<const uint8_t*>(data);
+        stream_.avail_in = size;
+
+        while (stream_.avail_in != 0) {
+            lzma_ret ret = lzma_code(&stream_, LZMA_RUN);
+            if (ret != LZMA_OK) {
+                die("XZWriteFilter: " << LZMA_RET_to_string(ret) <<
+                    " while compressing");
+            }
+            if (stream_.avail_out == 0) Flush();
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        lzma_ret ret;
+        do {
+            ret = lzma_code(&stream_, LZMA_FINISH);
+            if (ret != LZMA_OK && ret != LZMA_STREAM_END) {
+                die("XZWriteFilter: " << LZMA_RET_to_string(ret) <<
+                    " while finishing");
+            }
+            if (stream_.avail_out == 0 || ret == LZMA_STREAM_END) Flush();
+        } while (ret != LZMA_STREAM_END); // NOLINT
+
+        output_->close();
+
+        lzma_end(&stream_);
+        initialized_ = false;
+    }
+
+private:
+    //! if stream_ is initialized
+    bool initialized_ = false;
+
+    //! lzma context
+    lzma_stream stream_ = LZMA_STREAM_INIT;
+
+    //! compression buffer, flushed to output when full
+    std::vector<uint8_t> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    //! write compressed data in buffer_ to output
+    void Flush() {
+        size_t written_size = buffer_.size() - stream_.avail_out;
+        if (written_size != 0)
+            output_->write(buffer_.data(), written_size);
+
+        stream_.next_out = buffer_.data();
+        stream_.avail_out = buffer_.size();
+    }
+};
+
+WriteStreamPtr MakeXZWriteFilter(const WriteStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<XZWriteFilter>(stream);
+}
+
+/******************************************************************************/
+// XZReadFilter - on-the-fly xz decompressor
+
+class XZReadFilter final : public virtual ReadStream
+{
+public:
+    explicit XZReadFilter(const ReadStreamPtr& input)
+        : input_(input) {
+        lzma_ret ret = lzma_stream_decoder(
+            &stream_, UINT64_MAX, LZMA_CONCATENATED);
+        die_unequal(ret, LZMA_OK);
+
+        // input buffer
+        buffer_.resize(2 * 1024 * 1024);
+        stream_.next_in = buffer_.data();
+        stream_.avail_in = 0;
+
+        initialized_ = true;
+    }
+
+    ~XZReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        stream_.next_out = reinterpret_cast<uint8_t*>(data);
+        stream_.avail_out = size;
+
+        while (stream_.avail_out != 0 && !stream_end_)
+        {
+            if (stream_.avail_in == 0 && !input_eof_) {
+                // input buffer empty, so read from input_
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                stream_.next_in = buffer_.data();
+                stream_.avail_in = rb > 0 ? rb : 0;
+                input_eof_ = (stream_.avail_in == 0);
+            }
+
+            // LZMA_CONCATENATED only ends the stream on LZMA_FINISH
+            lzma_ret ret = lzma_code(
+                &stream_, input_eof_ ? LZMA_FINISH : LZMA_RUN);
+
+            if (ret == LZMA_STREAM_END) {
+                stream_end_ = true;
+            }
+            else if (ret != LZMA_OK) {
+                die("XZReadFilter: " << LZMA_RET_to_string(ret) <<
+                    " while decompressing");
+            }
+        }
+
+        return size - stream_.avail_out;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        lzma_end(&stream_);
+        input_->close();
+
+        initialized_ = false;
+    }
+
+private:
+    //! if stream_ is initialized
+    bool initialized_ = false;
+
+    //! lzma context
+    lzma_stream stream_ = LZMA_STREAM_INIT;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<uint8_t> buffer_;
+
+    //! whether input_ returned EOF
+    bool input_eof_ = false;
+
+    //! whether the decoder reached the end of the last stream
+    bool stream_end_ = false;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+};
+
+ReadStreamPtr MakeXZReadFilter(const ReadStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<XZReadFilter>(stream);
+}
+
+/******************************************************************************/
+
+#else   // !THRILL_HAVE_LZMA
+
+WriteStreamPtr MakeXZWriteFilter(const WriteStreamPtr&) {
+    die(".xz compression is not available, "
+        "because Thrill was built without liblzma.");
+}
+
+ReadStreamPtr MakeXZReadFilter(const ReadStreamPtr&) {
+    die(".xz decompression is not available, "
+        "because Thrill was built without liblzma.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
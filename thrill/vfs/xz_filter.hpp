@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * thrill/vfs/xz_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_XZ_FILTER_HEADER
+#define THRILL_VFS_XZ_FILTER_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+ReadStreamPtr MakeXZReadFilter(const ReadStreamPtr& stream);
+
+WriteStreamPtr MakeXZWriteFilter(const WriteStreamPtr& stream);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_XZ_FILTER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,234 @@
+/*******************************************************************************
+ * thrill/vfs/zstd_filter.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/vfs/zstd_filter.hpp>
+
+#include <thrill/common/logger.hpp>
+
+#include <tlx/die.hpp>
+
+#if THRILL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <cstdlib>
+#include <vector>
+
+namespace thrill {
+namespace vfs {
+
+#if THRILL_HAVE_ZSTD
+
+/******************************************************************************/
+
+//! read an integer from the environment variable name, or return def.
+static int GetEnvInt(const char* name, int def) {
+    const char* env = getenv(name);
+    if (env == nullptr || *env == 0) return def;
+
+    char* endptr;
+    long value = std::strtol(env, &endptr, 10);
+    if (endptr == nullptr || *endptr != 0)
+        die("Thrill: environment variable " << name << "=" << env <<
+            " is not a valid number.");
+    return static_cast<int>(value);
+}
+
+/******************************************************************************/
+// ZstdWriteFilter - on-the-fly Zstandard compressor
+
+class ZstdWriteFilter final : public virtual WriteStream
+{
+    static constexpr bool debug = false;
+
+public:
+    explicit ZstdWriteFilter(const WriteStreamPtr& output)
+        : output_(output) {
+        ctx_ = ZSTD_createCCtx();
+        die_unless(ctx_);
+
+        CheckError(ZSTD_CCtx_setParameter(
+                       ctx_, ZSTD_c_compressionLevel,
+                       GetEnvInt("THRILL_ZSTD_LEVEL", 3)));
+
+        // compression threads are only available if libzstd was built with
+        // multi-threading support, otherwise compress in this thread.
+        size_t err = ZSTD_CCtx_setParameter(
+            ctx_, ZSTD_c_nbWorkers, GetEnvInt("THRILL_ZSTD_THREADS", 1));
+        if (ZSTD_isError(err)) {
+            LOG << "ZstdWriteFilter: no compression threads: "
+                << ZSTD_getErrorName(err);
+        }
+
+        // output buffer
+        buffer_.resize(ZSTD_CStreamOutSize());
+
+        initialized_ = true;
+    }
+
+    ~ZstdWriteFilter() {
+        close();
+    }
+
+    ssize_t write(const void* data, const size_t size) final {
+        ZSTD_inBuffer in = { data, size, 0 };
+
+        while (in.pos != in.size) {
+            ZSTD_outBuffer out = { buffer_.data(), buffer_.size(), 0 };
+            CheckError(ZSTD_compressStream2(ctx_, &out, &in, ZSTD_e_continue));
+
+            if (out.pos != 0)
+                output_->write(buffer_.data(), out.pos);
+        }
+
+        return size;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        ZSTD_inBuffer in = { nullptr, 0, 0 };
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out = { buffer_.data(), buffer_.size(), 0 };
+            remaining = ZSTD_compressStream2(ctx_, &out, &in, ZSTD_e_end);
+            CheckError(remaining);
+
+            if (out.pos != 0)
+                output_->write(buffer_.data(), out.pos);
+        } while (remaining != 0); // NOLINT
+
+        output_->close();
+
+        ZSTD_freeCCtx(ctx_);
+        initialized_ = false;
+    }
+
+private:
+    //! if ctx_ is initialized
+    bool initialized_ = false;
+
+    //! zstd context
+    ZSTD_CCtx* ctx_;
+
+    //! compression buffer, flushed to output after each call
+    std::vector<char> buffer_;
+
+    //! output stream for writing data somewhere
+    WriteStreamPtr output_;
+
+    static void CheckError(size_t code) {
+        if (ZSTD_isError(code))
+            die("ZstdWriteFilter: " << ZSTD_getErrorName(code));
+    }
+};
+
+WriteStreamPtr MakeZstdWriteFilter(const WriteStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<ZstdWriteFilter>(stream);
+}
+
+/******************************************************************************/
+// ZstdReadFilter - on-the-fly Zstandard decompressor
+
+class ZstdReadFilter final : public virtual ReadStream
+{
+public:
+    explicit ZstdReadFilter(const ReadStreamPtr& input)
+        : input_(input) {
+        ctx_ = ZSTD_createDCtx();
+        die_unless(ctx_);
+
+        // input buffer
+        buffer_.resize(ZSTD_DStreamInSize());
+
+        initialized_ = true;
+    }
+
+    ~ZstdReadFilter() {
+        close();
+    }
+
+    ssize_t read(void* data, size_t size) final {
+        ZSTD_outBuffer out = { data, size, 0 };
+
+        while (out.pos < out.size)
+        {
+            if (in_.pos == in_.size && !input_eof_) {
+                // input buffer empty, so read from input_
+                ssize_t rb = input_->read(buffer_.data(), buffer_.size());
+                in_ = { buffer_.data(), rb > 0 ? size_t(rb) : 0, 0 };
+                input_eof_ = (in_.size == 0);
+            }
+
+            // the context may hold decompressed data even without input
+            size_t out_pos = out.pos;
+            size_t err = ZSTD_decompressStream(ctx_, &out, &in_);
+            if (ZSTD_isError(err))
+                die("ZstdReadFilter: " << ZSTD_getErrorName(err));
+
+            if (input_eof_ && out.pos == out_pos) break;
+        }
+
+        return out.pos;
+    }
+
+    void close() final {
+        if (!initialized_) return;
+
+        ZSTD_freeDCtx(ctx_);
+        input_->close();
+
+        initialized_ = false;
+    }
+
+private:
+    //! if ctx_ is initialized
+    bool initialized_ = false;
+
+    //! zstd context
+    ZSTD_DCtx* ctx_;
+
+    //! decompression buffer, filled from the input when empty
+    std::vector<char> buffer_;
+
+    //! unconsumed input in buffer_
+    ZSTD_inBuffer in_ = { nullptr, 0, 0 };
+
+    //! whether input_ returned EOF
+    bool input_eof_ = false;
+
+    //! input stream for reading data from somewhere
+    ReadStreamPtr input_;
+};
+
+ReadStreamPtr MakeZstdReadFilter(const ReadStreamPtr& stream) {
+    die_unless(stream);
+    return tlx::make_counting<ZstdReadFilter>(stream);
+}
+
+/******************************************************************************/
+
+#else   // !THRILL_HAVE_ZSTD
+
+WriteStreamPtr MakeZstdWriteFilter(const WriteStreamPtr&) {
+    die(".zst compression is not available, "
+        "because Thrill was built without zstd.");
+}
+
+ReadStreamPtr MakeZstdReadFilter(const ReadStreamPtr&) {
+    die(".zst decompression is not available, "
+        "because Thrill was built without zstd.");
+}
+
+#endif
+
+} // namespace vfs
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * thrill/vfs/zstd_filter.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_VFS_ZSTD_FILTER_HEADER
+#define THRILL_VFS_ZSTD_FILTER_HEADER
+
+#include <thrill/vfs/file_io.hpp>
+
+#include <string>
+
+namespace thrill {
+namespace vfs {
+
+ReadStreamPtr MakeZstdReadFilter(const ReadStreamPtr& stream);
+
+/*!
+ * Zstandard compressor. The compression level is read from THRILL_ZSTD_LEVEL
+ * (default: 3), and the number of compression threads from THRILL_ZSTD_THREADS
+ * (default: 1, which compresses in the background of the writing worker, 0
+ * compresses in the worker's thread).
+ */
+WriteStreamPtr MakeZstdWriteFilter(const WriteStreamPtr& stream);
+
+} // namespace vfs
+} // namespace thrill
+
+#endif // !THRILL_VFS_ZSTD_FILTER_HEADER
+
+/******************************************************************************/